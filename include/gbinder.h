@@ -48,6 +48,9 @@
 #include "gbinder_remote_request.h"
 #include "gbinder_servicename.h"
 #include "gbinder_servicemanager.h"
+#include "gbinder_stats.h"
+#include "gbinder_threads.h"
+#include "gbinder_trace.h"
 #include "gbinder_writer.h"
 
 #endif /* GBINDER_H */
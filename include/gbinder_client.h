@@ -115,6 +115,35 @@ gbinder_client_transact(
     GDestroyNotify destroy,
     void* user_data);
 
+/*
+ * Timeouts are in milliseconds, zero means no timeout. If the timeout
+ * expires, the status is -ETIMEDOUT and the reply is NULL. Transactions
+ * timed out before being sent are dropped, the late replies to those
+ * already sent are discarded. Note that until the late reply arrives,
+ * the binder driver won't accept another synchronous transaction from
+ * the thread which has given up on a synchronous call. Those fail with
+ * -EBUSY, or wait for the late reply within their own timeout. One-way
+ * transactions can be sent as usual.
+ */
+GBinderRemoteReply*
+gbinder_client_transact_sync_reply_timeout(
+    GBinderClient* client,
+    guint32 code,
+    GBinderLocalRequest* req,
+    int* status,
+    guint timeout_ms); /* since 1.1.51 */
+
+gulong
+gbinder_client_transact_timeout(
+    GBinderClient* client,
+    guint32 code,
+    guint32 flags,
+    GBinderLocalRequest* req,
+    GBinderClientReplyFunc reply,
+    GDestroyNotify destroy,
+    void* user_data,
+    guint timeout_ms); /* since 1.1.51 */
+
 void
 gbinder_client_cancel(
     GBinderClient* client,
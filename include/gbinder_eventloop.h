@@ -50,6 +50,11 @@ typedef struct gbinder_eventloop_callback {
     const GBinderEventLoopIntegration* eventloop;
 } GBinderEventLoopCallback;
 
+/* Since 1.1.51 */
+typedef struct gbinder_eventloop_watch {
+    const GBinderEventLoopIntegration* eventloop;
+} GBinderEventLoopWatch;
+
 /**
  * Main event loop integration. There is only one main event loop in the
  * process (by definition).
@@ -155,9 +160,29 @@ typedef struct gbinder_eventloop_integration {
      */
     void (*cleanup)(void);
 
+    /**
+     * watch_add
+     *
+     * Makes the main loop invoke the function whenever the file descriptor
+     * becomes readable (or gets into an error state), until the watch is
+     * removed with watch_remove. Since 1.1.51
+     *
+     * May be NULL (e.g. if the integration has been written for an older
+     * version of libgbinder), in which case libgbinder won't even try to
+     * process binder commands on the main thread.
+     */
+    GBinderEventLoopWatch* (*watch_add)(int fd,
+        GBinderEventLoopCallbackFunc func, gpointer data);
+
+    /**
+     * watch_remove
+     *
+     * Removes the watch and destroys it. The caller makes sure that
+     * argument is not NULL. Since 1.1.51
+     */
+    void (*watch_remove)(GBinderEventLoopWatch* watch);
+
     /* Padding for future expansion */
-    void (*_reserved1)(void);
-    void (*_reserved2)(void);
     void (*_reserved3)(void);
     void (*_reserved4)(void);
     void (*_reserved5)(void);
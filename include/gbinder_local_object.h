@@ -37,6 +37,35 @@
 
 G_BEGIN_DECLS
 
+/*
+ * By default, incoming transactions are handed over to the main thread
+ * and the looper thread which has received the transaction waits until
+ * the main thread is done with it.
+ *
+ * GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD tells libgbinder to invoke the
+ * transaction handler directly on the looper thread. That saves a couple
+ * of context switches per call and allows several transactions to be
+ * handled in parallel, but the following rules apply:
+ *
+ * 1. The handler may be invoked on several threads at the same time, so
+ *    it must be thread-safe and must not touch the state owned by the
+ *    main thread without proper synchronization.
+ * 2. The handler may use synchronous libgbinder calls. Asynchronous API
+ *    (e.g. gbinder_client_transact()), signal handlers and event loop
+ *    callbacks are still associated with the main thread.
+ * 3. gbinder_remote_request_block() must be called by the handler itself,
+ *    before it returns. gbinder_remote_request_complete() may then be
+ *    called from any thread. The looper remains blocked until the
+ *    request is completed and another looper accepts incoming
+ *    transactions in the meantime.
+ * 4. Reference counting notifications and the object lifecycle are still
+ *    handled on the main thread.
+ */
+typedef enum gbinder_local_object_flags {
+    GBINDER_LOCAL_OBJECT_FLAGS_NONE = 0,
+    GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD = 0x01
+} GBINDER_LOCAL_OBJECT_FLAGS; /* Since 1.1.51 */
+
 GBinderLocalObject*
 gbinder_local_object_new(
     GBinderIpc* ipc,
@@ -45,6 +74,15 @@ gbinder_local_object_new(
     void* user_data) /* Since 1.0.30 */
     G_GNUC_WARN_UNUSED_RESULT;
 
+GBinderLocalObject*
+gbinder_local_object_new2(
+    GBinderIpc* ipc,
+    const char* const* ifaces,
+    GBinderLocalTransactFunc handler,
+    void* user_data,
+    GBINDER_LOCAL_OBJECT_FLAGS flags) /* Since 1.1.51 */
+    G_GNUC_WARN_UNUSED_RESULT;
+
 GBinderLocalObject*
 gbinder_local_object_ref(
     GBinderLocalObject* obj);
@@ -66,6 +104,50 @@ gbinder_local_object_set_stability(
     GBinderLocalObject* self,
     GBINDER_STABILITY_LEVEL stability); /* Since 1.1.40 */
 
+/*
+ * Minimum scheduling policy and priority of the threads handling
+ * the incoming transactions. The policy is SCHED_OTHER, SCHED_BATCH,
+ * SCHED_FIFO or SCHED_RR. The priority is the nice value for the
+ * first two (-20..19) and the real-time priority (1..99) for the
+ * other two. With inherit_rt, the handler threads also inherit the
+ * real-time priority of the caller. Both require the binder driver
+ * to support priority inheritance (it's an Android extension) and
+ * must be set before the object gets passed to the other side.
+ */
+gboolean
+gbinder_local_object_set_min_sched_policy(
+    GBinderLocalObject* obj,
+    int policy,
+    int priority); /* Since 1.1.51 */
+
+void
+gbinder_local_object_set_inherit_rt(
+    GBinderLocalObject* obj,
+    gboolean inherit_rt); /* Since 1.1.51 */
+
+/*
+ * Time spent handling incoming transactions, either in total or for
+ * the particular transaction code. The codes which have been seen so
+ * far are returned in ascending order, the array must be deallocated
+ * with g_free().
+ */
+void
+gbinder_local_object_get_stats(
+    GBinderLocalObject* obj,
+    GBinderStatsLatency* stats); /* Since 1.1.51 */
+
+gboolean
+gbinder_local_object_get_code_stats(
+    GBinderLocalObject* obj,
+    guint32 code,
+    GBinderStatsLatency* stats); /* Since 1.1.51 */
+
+guint32*
+gbinder_local_object_get_stats_codes(
+    GBinderLocalObject* obj,
+    guint* count) /* Since 1.1.51 */
+    G_GNUC_WARN_UNUSED_RESULT;
+
 G_END_DECLS
 
 #endif /* GBINDER_LOCAL_OBJECT_H */
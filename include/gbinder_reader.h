@@ -207,6 +207,23 @@ char**
 gbinder_reader_read_hidl_string_vec(
     GBinderReader* reader);
 
+/*
+ * Views point directly into the transaction buffer and remain valid for
+ * as long as the request (reply) being read is alive. Strings are NULL
+ * terminated, elements of the vector view are validated the same way
+ * as by gbinder_reader_read_hidl_string_vec().
+ */
+
+const char*
+gbinder_reader_read_hidl_string_view(
+    GBinderReader* reader,
+    gsize* len); /* Since 1.1.51 */
+
+const GBinderHidlString*
+gbinder_reader_read_hidl_string_vec_view(
+    GBinderReader* reader,
+    gsize* count); /* Since 1.1.51 */
+
 gboolean
 gbinder_reader_skip_buffer(
     GBinderReader* reader);
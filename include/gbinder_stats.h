@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_STATS_H
+#define GBINDER_STATS_H
+
+#include "gbinder_types.h"
+
+G_BEGIN_DECLS
+
+/* Since 1.1.51 */
+
+#define GBINDER_STATS_LATENCY_BUCKETS (20)
+#define GBINDER_STATS_MAX_COMMANDS (32)
+
+/*
+ * Latency histogram. buckets[0] counts the calls which took less than
+ * a microsecond, buckets[i] the ones which took [2^(i-1), 2^i) usec.
+ * The last bucket also counts everything longer than that.
+ */
+struct gbinder_stats_latency {
+    guint64 count;
+    guint64 total_usec;
+    guint64 max_usec;
+    guint64 buckets[GBINDER_STATS_LATENCY_BUCKETS];
+};
+
+/*
+ * Latencies, call counters, byte and command counters are only collected
+ * if enabled in the config ([General] Stats = true), the rest is always
+ * available. The structure may grow at the expense of the reserved
+ * space at the end, without breaking the ABI.
+ */
+struct gbinder_stats {
+    /* Outgoing transactions */
+    GBinderStatsLatency sync_calls;
+    GBinderStatsLatency async_calls;  /* From submission to completion */
+    guint oneway_calls;
+    guint failed_calls;
+
+    /* Incoming transactions handled by all local objects */
+    GBinderStatsLatency incoming;
+
+    /* Asynchronous transactions */
+    guint tx_pool_threads;
+    guint tx_pool_queued;
+    guint urgent_pool_threads;
+    guint urgent_pool_queued;
+    guint completion_queue_depth;
+    guint completion_queue_max_depth;
+    guint completion_batches;
+    guint completions;
+
+    /* Loopers */
+    guint primary_loopers;
+    guint blocked_loopers;
+    guint spawned_loopers;
+
+    /* Driver */
+    guint ioctls;
+    guint transactions;
+    guint64 bytes_written;
+    guint64 bytes_read;
+    guint bc[GBINDER_STATS_MAX_COMMANDS]; /* Indexed by _IOC_NR(BC_xxx) */
+    guint br[GBINDER_STATS_MAX_COMMANDS]; /* Indexed by _IOC_NR(BR_xxx) */
+
+    /* Padding for future expansion */
+    guint _reserved[32];
+};
+
+void
+gbinder_ipc_get_stats(
+    GBinderIpc* ipc,
+    GBinderStats* stats);
+
+G_END_DECLS
+
+#endif /* GBINDER_STATS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
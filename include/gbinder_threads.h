@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_THREADS_H
+#define GBINDER_THREADS_H
+
+#include "gbinder_types.h"
+
+G_BEGIN_DECLS
+
+/* Since 1.1.51 */
+
+/*
+ * Asynchronous transactions are executed by a pool of worker threads,
+ * one per binder device. Transactions submitted with
+ * GBINDER_TX_FLAG_URGENT go through a separate (normally, smaller)
+ * pool, so that they don't get stuck behind slow calls.
+ */
+typedef enum gbinder_tx_lane {
+    GBINDER_TX_LANE_NORMAL,
+    GBINDER_TX_LANE_URGENT
+} GBINDER_TX_LANE;
+
+gboolean
+gbinder_ipc_set_tx_threads(
+    GBinderIpc* ipc,
+    GBINDER_TX_LANE lane,
+    guint max_threads);
+
+guint
+gbinder_ipc_get_tx_threads(
+    GBinderIpc* ipc,
+    GBINDER_TX_LANE lane);
+
+/*
+ * Scheduling attributes of the looper and transaction worker threads.
+ *
+ * policy is SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO or SCHED_RR,
+ * negative value leaves the scheduling alone. priority is the real-time
+ * priority (for SCHED_FIFO and SCHED_RR), nice is used with the other
+ * policies. cpus is the list of CPUs to pin the threads to, e.g. "0-1,3"
+ * (NULL means no pinning). Non-zero stack_size only affects the looper
+ * threads, the stack size of GThreadPool workers can't be specified.
+ *
+ * Looper threads get these attributes when they are started. Passing
+ * NULL doesn't reset the loopers which have already been configured.
+ * Workers only get the attributes while executing a transaction (GLib
+ * may hand idle workers over to other thread pools in the same process)
+ * and restore the previous ones afterwards. Restoring may fail if it
+ * requires privileges which the process doesn't have, e.g. lowering
+ * the nice value.
+ */
+typedef struct gbinder_thread_attr {
+    int policy;
+    int priority;
+    int nice;
+    const char* cpus;
+    gsize stack_size;
+} GBinderThreadAttr;
+
+gboolean
+gbinder_ipc_set_thread_attr(
+    GBinderIpc* ipc,
+    const GBinderThreadAttr* attr);
+
+G_END_DECLS
+
+#endif /* GBINDER_THREADS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
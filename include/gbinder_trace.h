@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_TRACE_H
+#define GBINDER_TRACE_H
+
+#include "gbinder_types.h"
+
+G_BEGIN_DECLS
+
+/* Since 1.1.51 */
+
+/*
+ * Binary transaction trace. Each thread writes timestamped events into
+ * its own ring buffer without taking any locks, which makes it cheap
+ * enough to keep enabled in production. The buffers can be dumped at
+ * any time with gbinder_trace_dump(), the result can be decoded with
+ * the binder-trace tool.
+ *
+ * The dump consists of GBinderTraceHeader followed by the records in
+ * host byte order, sorted by time within each thread but not across
+ * the threads.
+ */
+
+/*
+ * Event arguments:
+ *
+ * TX_QUEUED      arg1: transaction id, arg2: handle, arg3: code
+ * IOCTL_ENTER    arg1: bytes to write, arg2: fd
+ * IOCTL_EXIT     arg1: bytes read, arg2: fd, arg3: error
+ * BR_TRANSACTION arg1: target, arg2: code, arg3: flags
+ * HANDLER_START  arg1: object, arg2: code
+ * HANDLER_END    arg1: object, arg2: code, arg3: status
+ * REPLY_SENT     arg2: status, arg3: error
+ */
+typedef enum gbinder_trace_event {
+    GBINDER_TRACE_TX_QUEUED = 1,
+    GBINDER_TRACE_IOCTL_ENTER,
+    GBINDER_TRACE_IOCTL_EXIT,
+    GBINDER_TRACE_BR_TRANSACTION,
+    GBINDER_TRACE_HANDLER_START,
+    GBINDER_TRACE_HANDLER_END,
+    GBINDER_TRACE_REPLY_SENT
+} GBINDER_TRACE_EVENT;
+
+#define GBINDER_TRACE_MAGIC GBINDER_FOURCC('G','B','T','R')
+#define GBINDER_TRACE_VERSION (1)
+
+struct gbinder_trace_header {
+    guint32 magic;
+    guint32 version;
+    guint32 record_size;
+    guint32 count;
+};
+
+struct gbinder_trace_record {
+    guint64 nsec;       /* CLOCK_MONOTONIC */
+    guint32 tid;
+    guint16 event;      /* GBINDER_TRACE_EVENT */
+    guint16 reserved;
+    guint64 arg1;
+    guint32 arg2;
+    guint32 arg3;
+};
+
+/* Size is the number of records per thread, zero selects the default */
+void
+gbinder_trace_start(
+    guint size);
+
+void
+gbinder_trace_stop(
+    void);
+
+/*
+ * Writes the header and the contents of all buffers to the file
+ * descriptor. This function allocates memory, takes locks and may
+ * log, so it must not be called from a signal handler. To dump the
+ * trace on a signal, use g_unix_signal_add() (or a self-pipe) and
+ * call gbinder_trace_dump() from the main loop.
+ */
+gboolean
+gbinder_trace_dump(
+    int fd);
+
+G_END_DECLS
+
+#endif /* GBINDER_TRACE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -73,6 +73,10 @@ typedef struct gbinder_remote_reply GBinderRemoteReply;
 typedef struct gbinder_remote_request GBinderRemoteRequest;
 typedef struct gbinder_servicename GBinderServiceName;
 typedef struct gbinder_servicemanager GBinderServiceManager;
+typedef struct gbinder_stats GBinderStats; /* Since 1.1.51 */
+typedef struct gbinder_stats_latency GBinderStatsLatency; /* Since 1.1.51 */
+typedef struct gbinder_trace_header GBinderTraceHeader; /* Since 1.1.51 */
+typedef struct gbinder_trace_record GBinderTraceRecord; /* Since 1.1.51 */
 typedef struct gbinder_writer GBinderWriter;
 typedef struct gbinder_parent GBinderParent;
 
@@ -167,6 +171,13 @@ GBinderLocalReply*
 
 #define GBINDER_TX_FLAG_ONEWAY (0x01)
 
+/*
+ * Asynchronous transactions submitted with GBINDER_TX_FLAG_URGENT don't
+ * have to wait behind the regular ones (see gbinder_threads.h). This
+ * flag is handled by libgbinder and never gets passed to the driver.
+ */
+#define GBINDER_TX_FLAG_URGENT (0x100) /* Since 1.1.51 */
+
 typedef enum gbinder_status {
     GBINDER_STATUS_OK = 0,
     GBINDER_STATUS_FAILED,
@@ -328,6 +328,24 @@ gbinder_writer_overwrite_int32(
     gsize offset,
     gint32 value); /* Since 1.0.21 */
 
+/*
+ * gbinder_writer_reserve() appends size bytes (padded to 4-byte boundary,
+ * padding is zeroed) and returns the pointer to the reserved area, which
+ * the caller fills in. The pointer remains valid until anything else is
+ * written. gbinder_writer_size_hint() makes sure that the next size bytes
+ * can be written without reallocating the buffer.
+ */
+
+void*
+gbinder_writer_reserve(
+    GBinderWriter* writer,
+    gsize size); /* Since 1.1.51 */
+
+void
+gbinder_writer_size_hint(
+    GBinderWriter* writer,
+    gsize size); /* Since 1.1.51 */
+
 /* Note: memory allocated by GBinderWriter is owned by GBinderWriter */
 
 void*
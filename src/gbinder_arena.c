@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gbinder_arena.h"
+
+#include <gutil_macros.h>
+
+#include <string.h>
+
+/*
+ * Chunks start small (most requests only need a few bytes) and double
+ * in size up to GBINDER_ARENA_MAX_CHUNK. Larger allocations get their
+ * own chunks and don't affect the current one.
+ */
+#define GBINDER_ARENA_MIN_CHUNK (512)
+#define GBINDER_ARENA_MAX_CHUNK (64 * 1024)
+#define GBINDER_ARENA_MAX_BUMP (GBINDER_ARENA_MAX_CHUNK / 4)
+
+struct gbinder_arena_chunk {
+    GBinderArenaChunk* next;
+    gsize size;
+};
+
+#define GBINDER_ARENA_CHUNK_HEADER G_ALIGN8(sizeof(GBinderArenaChunk))
+
+static
+guint8*
+gbinder_arena_new_chunk(
+    GBinderArena* self,
+    gsize size)
+{
+    GBinderArenaChunk* chunk = g_malloc(GBINDER_ARENA_CHUNK_HEADER + size);
+
+    chunk->size = size;
+    chunk->next = self->chunks;
+    self->chunks = chunk;
+    return (guint8*)chunk + GBINDER_ARENA_CHUNK_HEADER;
+}
+
+void*
+gbinder_arena_alloc(
+    GBinderArena* self,
+    gsize size)
+{
+    if (G_LIKELY(size)) {
+        const gsize aligned = G_ALIGN8(size);
+        void* ptr;
+
+        if (G_UNLIKELY(aligned > self->left)) {
+            if (aligned > GBINDER_ARENA_MAX_BUMP) {
+                return gbinder_arena_new_chunk(self, aligned);
+            } else {
+                const gsize chunk_size = MAX(aligned,
+                    MAX(self->next, GBINDER_ARENA_MIN_CHUNK));
+
+                /* Whatever is left in the current chunk is wasted */
+                self->ptr = gbinder_arena_new_chunk(self, chunk_size);
+                self->left = chunk_size;
+                self->next = MIN(chunk_size * 2, GBINDER_ARENA_MAX_CHUNK);
+            }
+        }
+        ptr = self->ptr;
+        self->ptr += aligned;
+        self->left -= aligned;
+        return ptr;
+    }
+    return NULL;
+}
+
+void*
+gbinder_arena_alloc0(
+    GBinderArena* self,
+    gsize size)
+{
+    void* ptr = gbinder_arena_alloc(self, size);
+
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void*
+gbinder_arena_memdup(
+    GBinderArena* self,
+    const void* buf,
+    gsize size)
+{
+    if (buf) {
+        void* ptr = gbinder_arena_alloc(self, size);
+
+        if (ptr) {
+            memcpy(ptr, buf, size);
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Frees everything but the largest regular chunk, which becomes the
+ * current one. That's for reusing the arena without going through
+ * malloc again.
+ */
+void
+gbinder_arena_rewind(
+    GBinderArena* self)
+{
+    GBinderArenaChunk* keep = NULL;
+    GBinderArenaChunk* chunk = self->chunks;
+
+    while (chunk) {
+        GBinderArenaChunk* next = chunk->next;
+
+        if (chunk->size > GBINDER_ARENA_MAX_CHUNK) {
+            /* Too big to keep around */
+            g_free(chunk);
+        } else if (!keep || chunk->size > keep->size) {
+            g_free(keep);
+            keep = chunk;
+        } else {
+            g_free(chunk);
+        }
+        chunk = next;
+    }
+
+    if (keep) {
+        keep->next = NULL;
+        self->chunks = keep;
+        self->ptr = (guint8*)keep + GBINDER_ARENA_CHUNK_HEADER;
+        self->left = keep->size;
+        self->next = MIN(keep->size * 2, GBINDER_ARENA_MAX_CHUNK);
+    } else {
+        memset(self, 0, sizeof(*self));
+    }
+}
+
+void
+gbinder_arena_clear(
+    GBinderArena* self)
+{
+    GBinderArenaChunk* chunk = self->chunks;
+
+    while (chunk) {
+        GBinderArenaChunk* next = chunk->next;
+
+        g_free(chunk);
+        chunk = next;
+    }
+    memset(self, 0, sizeof(*self));
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
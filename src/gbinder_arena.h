@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_ARENA_H
+#define GBINDER_ARENA_H
+
+#include "gbinder_types_p.h"
+
+/*
+ * Bump allocator for the short-lived allocations which share the same
+ * lifetime, e.g. the temporary data attached to a request or a reply.
+ * Everything gets deallocated in one go by gbinder_arena_clear(), or
+ * gbinder_arena_rewind() if the arena is going to be reused.
+ * The memory returned by gbinder_arena_alloc() is 8-byte aligned.
+ * Zero-initialized GBinderArena is an empty arena.
+ */
+
+typedef struct gbinder_arena_chunk GBinderArenaChunk;
+
+struct gbinder_arena {
+    GBinderArenaChunk* chunks;
+    guint8* ptr;    /* Free space in the current chunk */
+    gsize left;     /* Bytes left in the current chunk */
+    gsize next;     /* Size of the next chunk */
+};
+
+void*
+gbinder_arena_alloc(
+    GBinderArena* arena,
+    gsize size)
+    GBINDER_INTERNAL;
+
+void*
+gbinder_arena_alloc0(
+    GBinderArena* arena,
+    gsize size)
+    GBINDER_INTERNAL;
+
+void*
+gbinder_arena_memdup(
+    GBinderArena* arena,
+    const void* buf,
+    gsize size)
+    GBINDER_INTERNAL;
+
+void
+gbinder_arena_rewind(
+    GBinderArena* arena)
+    GBINDER_INTERNAL;
+
+void
+gbinder_arena_clear(
+    GBinderArena* arena)
+    GBINDER_INTERNAL;
+
+#endif /* GBINDER_ARENA_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -91,6 +91,15 @@ gbinder_client_find_range(
     return NULL;
 }
 
+static
+gint64
+gbinder_client_deadline(
+    guint timeout_ms)
+{
+    return timeout_ms ? (g_get_monotonic_time() +
+        (gint64)timeout_ms * 1000) : 0;
+}
+
 /*
  * Generates basic request (without additional parameters) for the
  * specified interface and pulls header data out of it. The basic
@@ -432,6 +441,58 @@ gbinder_client_transact(
     GBinderClientReplyFunc reply,
     GDestroyNotify destroy,
     void* user_data)
+{
+    return gbinder_client_transact_timeout(self, code, flags, req, reply,
+        destroy, user_data, 0);
+}
+
+GBinderRemoteReply*
+gbinder_client_transact_sync_reply_timeout(
+    GBinderClient* self,
+    guint32 code,
+    GBinderLocalRequest* req,
+    int* status,
+    guint timeout_ms) /* since 1.1.51 */
+{
+    if (!timeout_ms) {
+        return gbinder_client_transact_sync_reply(self, code, req, status);
+    } else if (G_LIKELY(self)) {
+        GBinderRemoteObject* obj = self->remote;
+
+        if (G_LIKELY(!obj->dead)) {
+            if (!req) {
+                const GBinderClientIfaceRange* r = gbinder_client_find_range
+                    (gbinder_client_cast(self), code);
+
+                /* Default empty request (just the header, no parameters) */
+                if (r) {
+                    req = r->basic_req;
+                }
+            }
+            if (req) {
+                return gbinder_ipc_transact_sync_reply_deadline(obj->ipc,
+                    obj->handle, code, req, status,
+                    gbinder_client_deadline(timeout_ms));
+            } else {
+                GWARN("Unable to build empty request for tx code %u", code);
+            }
+        } else {
+            GDEBUG("Refusing to perform transaction with a dead object");
+        }
+    }
+    return NULL;
+}
+
+gulong
+gbinder_client_transact_timeout(
+    GBinderClient* self,
+    guint32 code,
+    guint32 flags,
+    GBinderLocalRequest* req,
+    GBinderClientReplyFunc reply,
+    GDestroyNotify destroy,
+    void* user_data,
+    guint timeout_ms) /* since 1.1.51 */
 {
     if (G_LIKELY(self)) {
         GBinderRemoteObject* obj = self->remote;
@@ -453,9 +514,10 @@ gbinder_client_transact(
                 tx->reply = reply;
                 tx->destroy = destroy;
                 tx->user_data = user_data;
-                return gbinder_ipc_transact(obj->ipc, obj->handle, code,
-                    flags, req, gbinder_client_transact_reply,
-                    gbinder_client_transact_destroy, tx);
+                return gbinder_ipc_transact_deadline(obj->ipc, obj->handle,
+                    code, flags, req, gbinder_client_transact_reply,
+                    gbinder_client_transact_destroy, tx,
+                    gbinder_client_deadline(timeout_ms));
             } else {
                 GWARN("Unable to build empty request for tx code %u", code);
             }
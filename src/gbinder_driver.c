@@ -33,6 +33,7 @@
 #include "gbinder_driver.h"
 #include "gbinder_buffer_p.h"
 #include "gbinder_cleanup.h"
+#include "gbinder_config.h"
 #include "gbinder_handler.h"
 #include "gbinder_io.h"
 #include "gbinder_local_object_p.h"
@@ -40,11 +41,13 @@
 #include "gbinder_local_request_p.h"
 #include "gbinder_object_registry.h"
 #include "gbinder_output_data.h"
+#include "gbinder_probes.h"
 #include "gbinder_remote_object_p.h"
 #include "gbinder_remote_reply_p.h"
 #include "gbinder_remote_request_p.h"
 #include "gbinder_rpc_protocol.h"
 #include "gbinder_system.h"
+#include "gbinder_trace_p.h"
 #include "gbinder_writer.h"
 #include "gbinder_log.h"
 
@@ -74,8 +77,24 @@
 /* OK, one more */
 #define BINDER_SET_MAX_THREADS _IOW('b', 5, guint32)
 
+/* And another one */
+#define BINDER_THREAD_EXIT _IOW('b', 8, gint32)
+
 #define DEFAULT_MAX_BINDER_THREADS (0)
 
+/*
+ * Read buffer size can be configured like this:
+ *
+ * [General]
+ * ReadBufferSize = 4096
+ *
+ * Read buffers are allocated per thread and reused. The larger the
+ * buffer, the more commands can be fetched by a single ioctl.
+ */
+#define CONF_READ_BUFFER_SIZE "ReadBufferSize"
+#define DEFAULT_READ_BUFFER_SIZE (4096)
+#define MAX_READ_BUFFER_SIZE (256*1024)
+
 struct gbinder_driver {
     gint refcount;
     int fd;
@@ -85,6 +104,15 @@ struct gbinder_driver {
     const char* name;
     const GBinderIo* io;
     const GBinderRpcProtocol* protocol;
+    gsize read_buffer_size;
+    gint ioctl_count;
+    gint tx_count;
+    gboolean stats; /* Set by gbinder_driver_set_stats() */
+    GMutex stats_mutex;
+    guint64 bytes_written; /* Protected by stats_mutex */
+    guint64 bytes_read; /* Ditto */
+    gint bc_count[GBINDER_STATS_MAX_COMMANDS];
+    gint br_count[GBINDER_STATS_MAX_COMMANDS];
 };
 
 typedef struct gbinder_driver_read_buf {
@@ -94,9 +122,41 @@ typedef struct gbinder_driver_read_buf {
 
 typedef struct gbinder_driver_read_data {
     GBinderDriverReadBuf buf;
-    guint8 data[GBINDER_IO_READ_BUFFER_SIZE];
+    gsize size;
+    guint8 data[1]; /* Actually, size bytes */
 } GBinderDriverReadData;
 
+/* One spare read buffer per thread */
+static GPrivate gbinder_driver_read_data_cache = G_PRIVATE_INIT(g_free);
+
+typedef struct gbinder_driver_out {
+    GBinderDriver* driver; /* Not a reference, only set while queueing */
+    GByteArray* buf;
+} GBinderDriverOut;
+
+static
+void
+gbinder_driver_out_free(
+    gpointer data);
+
+static GPrivate gbinder_driver_out_key =
+    G_PRIVATE_INIT(gbinder_driver_out_free);
+
+/* Transactions abandoned by the current thread, one entry per driver */
+typedef struct gbinder_driver_abandoned {
+    struct gbinder_driver_abandoned* next;
+    GBinderDriver* driver; /* Reference */
+    guint count;
+} GBinderDriverAbandoned;
+
+static
+void
+gbinder_driver_abandoned_free(
+    gpointer data);
+
+static GPrivate gbinder_driver_abandoned_key =
+    G_PRIVATE_INIT(gbinder_driver_abandoned_free);
+
 typedef struct gbinder_driver_context {
     GBinderDriverReadBuf* rbuf;
     GBinderObjectRegistry* reg;
@@ -222,30 +282,76 @@ gbinder_driver_verbose_transaction_data(
 #  define gbinder_driver_verbose_transaction_data(x,y) GLOG_NOTHING
 #endif /* GUTIL_LOG_VERBOSE */
 
+/*
+ * Counts the commands passed to (or received from) the driver by _IOC_NR,
+ * which is the same for 32 and 64-bit protocols. Only done if statistics
+ * are enabled (see gbinder_driver_set_stats).
+ */
+static
+void
+gbinder_driver_count_commands(
+    GBinderDriver* self,
+    gint* counts,
+    guint64* bytes,
+    const GBinderIoBuf* buf,
+    gsize start)
+{
+    const guint8* ptr = GSIZE_TO_POINTER(buf->ptr + start);
+    const guint8* end = GSIZE_TO_POINTER(buf->ptr + buf->consumed);
+
+    if (end > ptr) {
+        /* Lock */
+        g_mutex_lock(&self->stats_mutex);
+        *bytes += end - ptr;
+        g_mutex_unlock(&self->stats_mutex);
+        /* Unlock */
+
+        while (ptr + sizeof(guint32) <= end) {
+            const guint32 cmd = *(guint32*)ptr;
+            const guint nr = _IOC_NR(cmd);
+
+            if (nr < GBINDER_STATS_MAX_COMMANDS) {
+                g_atomic_int_inc(counts + nr);
+            }
+            ptr += sizeof(cmd) + _IOC_SIZE(cmd);
+        }
+    }
+}
+
 static
 int
-gbinder_driver_write(
+gbinder_driver_write_buf(
     GBinderDriver* self,
     GBinderIoBuf* buf)
 {
     int err = (-EAGAIN);
 
     while (err == (-EAGAIN)) {
+        const gsize were_written = buf->consumed;
+
         gbinder_driver_verbose_dump('<',
             buf->ptr +  buf->consumed,
             buf->size - buf->consumed);
         GVERBOSE("gbinder_driver_write(%d) %u/%u", self->fd,
             (guint)buf->consumed, (guint)buf->size);
+        g_atomic_int_inc(&self->ioctl_count);
+        GBINDER_TRACE(GBINDER_TRACE_IOCTL_ENTER, buf->size - buf->consumed,
+            self->fd, 0);
         err = self->io->write_read(self->fd, buf, NULL);
+        GBINDER_TRACE(GBINDER_TRACE_IOCTL_EXIT, 0, self->fd, err);
         GVERBOSE("gbinder_driver_write(%d) %u/%u err %d", self->fd,
             (guint)buf->consumed, (guint)buf->size, err);
+        if (self->stats) {
+            gbinder_driver_count_commands(self, self->bc_count,
+                &self->bytes_written, buf, were_written);
+        }
     }
     return err;
 }
 
 static
 int
-gbinder_driver_write_read(
+gbinder_driver_write_read_buf(
     GBinderDriver* self,
     GBinderIoBuf* write,
     GBinderDriverReadBuf* rbuf)
@@ -265,9 +371,10 @@ gbinder_driver_write_read(
     }
 
     while (err == (-EAGAIN)) {
+        const gsize were_written = write ? write->consumed : 0;
+        const gsize were_consumed = read->consumed;
 
 #if GUTIL_LOG_VERBOSE
-        const gsize were_consumed = read ? read->consumed : 0;
         if (GLOG_ENABLED(GLOG_LEVEL_VERBOSE)) {
             if (write) {
                 gbinder_driver_verbose_dump('<',
@@ -282,7 +389,12 @@ gbinder_driver_write_read(
                 (guint)(read ? read->size : 0));
         }
 #endif /* GUTIL_LOG_VERBOSE */
+        g_atomic_int_inc(&self->ioctl_count);
+        GBINDER_TRACE(GBINDER_TRACE_IOCTL_ENTER, write ?
+            (write->size - write->consumed) : 0, self->fd, 0);
         err = self->io->write_read(self->fd, write, read);
+        GBINDER_TRACE(GBINDER_TRACE_IOCTL_EXIT, read->consumed -
+            were_consumed, self->fd, err);
 #if GUTIL_LOG_VERBOSE
         if (GLOG_ENABLED(GLOG_LEVEL_VERBOSE)) {
             GVERBOSE("gbinder_driver_write_read(%d) "
@@ -291,13 +403,19 @@ gbinder_driver_write_read(
                 (guint)(write ? write->size : 0),
                 (guint)(read ? read->consumed : 0),
                 (guint)(read ? read->size : 0), err);
-            if (read) {
-                gbinder_driver_verbose_dump('>',
-                    read->ptr + were_consumed,
-                    read->consumed - were_consumed);
-            }
+            gbinder_driver_verbose_dump('>',
+                read->ptr + were_consumed,
+                read->consumed - were_consumed);
         }
 #endif /* GUTIL_LOG_VERBOSE */
+        if (self->stats) {
+            if (write) {
+                gbinder_driver_count_commands(self, self->bc_count,
+                    &self->bytes_written, write, were_written);
+            }
+            gbinder_driver_count_commands(self, self->br_count,
+                &self->bytes_read, read, were_consumed);
+        }
     }
 
     if (rbuf->offset) {
@@ -306,6 +424,250 @@ gbinder_driver_write_read(
     return err;
 }
 
+/*
+ * Output queue. While the thread is handling the incoming commands (or
+ * waiting for a reply), the commands which don't need to be delivered
+ * right away (BC_FREE_BUFFER, BC_INCREFS_DONE, BC_ACQUIRE_DONE etc.) are
+ * collected in a per-thread buffer and sent to the driver together with
+ * the next write (e.g. BC_REPLY) or read. Whatever is left gets flushed
+ * when the thread is done with the driver.
+ */
+
+static
+void
+gbinder_driver_out_free(
+    gpointer data)
+{
+    GBinderDriverOut* out = data;
+
+    g_byte_array_free(out->buf, TRUE);
+    g_slice_free(GBinderDriverOut, out);
+}
+
+static
+GByteArray*
+gbinder_driver_out_pending(
+    GBinderDriver* self)
+{
+    GBinderDriverOut* out = g_private_get(&gbinder_driver_out_key);
+
+    return (out && out->driver == self && out->buf->len) ? out->buf : NULL;
+}
+
+gboolean
+gbinder_driver_out_begin(
+    GBinderDriver* self)
+{
+    GBinderDriverOut* out = g_private_get(&gbinder_driver_out_key);
+
+    if (!out) {
+        out = g_slice_new0(GBinderDriverOut);
+        out->buf = g_byte_array_new();
+        g_private_set(&gbinder_driver_out_key, out);
+    }
+    if (!out->driver) {
+        out->driver = self;
+        return TRUE;
+    }
+    /* Nested call or another driver is already queueing on this thread */
+    return FALSE;
+}
+
+void
+gbinder_driver_out_end(
+    GBinderDriver* self,
+    gboolean begun)
+{
+    if (begun) {
+        GBinderDriverOut* out = g_private_get(&gbinder_driver_out_key);
+
+        gbinder_driver_flush(self);
+        g_byte_array_set_size(out->buf, 0);
+        out->driver = NULL;
+    }
+}
+
+/* Sends the queued commands together with the contents of write buffer */
+static
+GBinderIoBuf*
+gbinder_driver_out_merge(
+    GByteArray* queue,
+    GBinderIoBuf* write,
+    GBinderIoBuf* merged)
+{
+    if (write) {
+        g_byte_array_append(queue, GSIZE_TO_POINTER(write->ptr +
+            write->consumed), write->size - write->consumed);
+    }
+    memset(merged, 0, sizeof(*merged));
+    merged->ptr = GPOINTER_TO_SIZE(queue->data);
+    merged->size = queue->len;
+    return merged;
+}
+
+static
+void
+gbinder_driver_out_done(
+    GByteArray* queue,
+    GBinderIoBuf* write,
+    GBinderIoBuf* merged)
+{
+    const gsize n = write ? (write->size - write->consumed) : 0;
+    const gsize queued = queue->len - n;
+
+    if (merged->consumed > queued) {
+        write->consumed += merged->consumed - queued;
+    }
+    g_byte_array_set_size(queue, queued);
+    g_byte_array_remove_range(queue, 0, MIN(merged->consumed, queued));
+}
+
+static
+int
+gbinder_driver_write(
+    GBinderDriver* self,
+    GBinderIoBuf* write)
+{
+    GByteArray* queue = gbinder_driver_out_pending(self);
+
+    if (queue) {
+        GBinderIoBuf merged;
+        const int err = gbinder_driver_write_buf(self,
+            gbinder_driver_out_merge(queue, write, &merged));
+
+        gbinder_driver_out_done(queue, write, &merged);
+        return err;
+    } else {
+        return gbinder_driver_write_buf(self, write);
+    }
+}
+
+static
+int
+gbinder_driver_write_read(
+    GBinderDriver* self,
+    GBinderIoBuf* write,
+    GBinderDriverReadBuf* rbuf)
+{
+    GByteArray* queue = gbinder_driver_out_pending(self);
+
+    if (queue) {
+        GBinderIoBuf merged;
+        const int err = gbinder_driver_write_read_buf(self,
+            gbinder_driver_out_merge(queue, write, &merged), rbuf);
+
+        gbinder_driver_out_done(queue, write, &merged);
+        return err;
+    } else {
+        return gbinder_driver_write_read_buf(self, write, rbuf);
+    }
+}
+
+/* Queues the command if possible, otherwise writes it right away */
+static
+int
+gbinder_driver_queue(
+    GBinderDriver* self,
+    GBinderIoBuf* write)
+{
+    GBinderDriverOut* out = g_private_get(&gbinder_driver_out_key);
+
+    if (out && out->driver == self) {
+        g_byte_array_append(out->buf, GSIZE_TO_POINTER(write->ptr +
+            write->consumed), write->size - write->consumed);
+        write->consumed = write->size;
+        return 0;
+    } else {
+        return gbinder_driver_write_buf(self, write);
+    }
+}
+
+/*
+ * Abandoned transactions. If the deadline passes while the thread is
+ * waiting for a reply, the thread gives up waiting but the transaction
+ * remains on its kernel transaction stack. The driver won't accept
+ * another synchronous transaction from this thread until the reply is
+ * picked up, and the reply buffer has to be freed anyway. So the late
+ * replies get counted here and silently discarded when they arrive.
+ */
+
+static
+void
+gbinder_driver_abandoned_free(
+    gpointer data)
+{
+    GBinderDriverAbandoned* list = data;
+
+    while (list) {
+        GBinderDriverAbandoned* entry = list;
+
+        list = entry->next;
+        gbinder_driver_unref(entry->driver);
+        g_slice_free(GBinderDriverAbandoned, entry);
+    }
+}
+
+static
+GBinderDriverAbandoned*
+gbinder_driver_abandoned_find(
+    GBinderDriver* self)
+{
+    GBinderDriverAbandoned* entry =
+        g_private_get(&gbinder_driver_abandoned_key);
+
+    while (entry && entry->driver != self) {
+        entry = entry->next;
+    }
+    return entry;
+}
+
+static
+void
+gbinder_driver_abandon(
+    GBinderDriver* self)
+{
+    GBinderDriverAbandoned* entry = gbinder_driver_abandoned_find(self);
+
+    if (entry) {
+        entry->count++;
+    } else {
+        entry = g_slice_new(GBinderDriverAbandoned);
+        entry->next = g_private_get(&gbinder_driver_abandoned_key);
+        entry->driver = gbinder_driver_ref(self);
+        entry->count = 1;
+        g_private_set(&gbinder_driver_abandoned_key, entry);
+    }
+}
+
+/* Accounts for a reply which nobody is waiting for */
+static
+void
+gbinder_driver_abandoned_reply(
+    GBinderDriver* self)
+{
+    GBinderDriverAbandoned* prev = NULL;
+    GBinderDriverAbandoned* entry =
+        g_private_get(&gbinder_driver_abandoned_key);
+
+    while (entry && entry->driver != self) {
+        prev = entry;
+        entry = entry->next;
+    }
+
+    if (!entry) {
+        GWARN("Unexpected reply");
+    } else if (!--(entry->count)) {
+        if (prev) {
+            prev->next = entry->next;
+        } else {
+            g_private_set(&gbinder_driver_abandoned_key, entry->next);
+        }
+        /* The caller holds a reference, this one is never the last */
+        gbinder_driver_unref(entry->driver);
+        g_slice_free(GBinderDriverAbandoned, entry);
+    }
+}
+
 static
 gboolean
 gbinder_driver_cmd(
@@ -335,7 +697,7 @@ gbinder_driver_cmd_int32(
     memset(&write, 0, sizeof(write));
     write.ptr = (uintptr_t)data;
     write.size = sizeof(data);
-    return gbinder_driver_write(self, &write) >= 0;
+    return gbinder_driver_queue(self, &write) >= 0;
 }
 
 static
@@ -355,7 +717,7 @@ gbinder_driver_cmd_data(
     write.ptr = (uintptr_t)buf;
     write.size = 4 + _IOC_SIZE(cmd);
 
-    return gbinder_driver_write(self, &write) >= 0;
+    return gbinder_driver_queue(self, &write) >= 0;
 }
 
 static
@@ -376,19 +738,48 @@ gbinder_driver_handle_cookie(
     return gbinder_driver_write(self, &write) >= 0;
 }
 
+static
+GBinderDriverReadData*
+gbinder_driver_read_data_new(
+    GBinderDriver* self)
+{
+    GBinderDriverReadData* read = g_private_get
+        (&gbinder_driver_read_data_cache);
+
+    if (read && read->size >= self->read_buffer_size) {
+        /* Nested reads on this thread will have to allocate their own */
+        g_private_set(&gbinder_driver_read_data_cache, NULL);
+        memset(&read->buf, 0, sizeof(read->buf));
+    } else {
+        const gsize size = self->read_buffer_size;
+
+        /*
+         * It shouldn't be necessary to zero-initialize the whole buffer
+         * but valgrind complains about access to uninitialised data if
+         * we don't do so. Oh well... At least we do it only once.
+         */
+        read = g_malloc0(G_STRUCT_OFFSET(GBinderDriverReadData, data) + size);
+        read->size = size;
+    }
+    read->buf.io.ptr = GPOINTER_TO_SIZE(read->data);
+    read->buf.io.size = self->read_buffer_size;
+    return read;
+}
+
 static
 void
-gbinder_driver_read_init(
+gbinder_driver_read_data_free(
     GBinderDriverReadData* read)
 {
-    /*
-     * It shouldn't be necessary to zero-initialize the whole buffer
-     * but valgrind complains about access to uninitialised data if
-     * we don't do so. Oh well...
-     */
-    memset(read, 0, sizeof(*read));
-    read->buf.io.ptr = GPOINTER_TO_SIZE(read->data);
-    read->buf.io.size = sizeof(read->data);
+    GBinderDriverReadData* cached = g_private_get
+        (&gbinder_driver_read_data_cache);
+
+    /* Keep the larger one for reuse */
+    if (!cached || cached->size < read->size) {
+        g_private_replace(&gbinder_driver_read_data_cache, read);
+    } else {
+        g_free(read);
+    }
 }
 
 static
@@ -438,14 +829,13 @@ gbinder_driver_next_command(
 }
 
 static
-gboolean
-gbinder_driver_reply_status(
+gsize
+gbinder_driver_encode_reply_status(
     GBinderDriver* self,
+    guint8* buf,
     gint32 status)
 {
     const GBinderIo* io = self->io;
-    GBinderIoBuf write;
-    guint8 buf[sizeof(guint32) + GBINDER_MAX_BC_TRANSACTION_SIZE];
     guint8* ptr = buf;
     const guint32* code = &io->bc.reply;
 
@@ -458,27 +848,22 @@ gbinder_driver_reply_status(
     ptr += io->encode_status_reply(ptr, &status);
 
     GVERBOSE("< BC_REPLY (%d)", status);
-    memset(&write, 0, sizeof(write));
-    write.ptr = (uintptr_t)buf;
-    write.size = ptr - buf;
-    return gbinder_driver_write(self, &write) >= 0;
+    return ptr - buf;
 }
 
 static
-gboolean
-gbinder_driver_reply_data(
+gsize
+gbinder_driver_encode_reply_data(
     GBinderDriver* self,
-    GBinderOutputData* data)
+    guint8* buf,
+    GBinderOutputData* data,
+    void** offsets_buf)
 {
-    GBinderIoBuf write;
     const GBinderIo* io = self->io;
     const gsize extra_buffers = gbinder_output_data_buffers_size(data);
-    guint8 buf[GBINDER_MAX_BC_TRANSACTION_SG_SIZE + sizeof(guint32)];
     guint32* cmd = (guint32*)buf;
     guint len = sizeof(*cmd);
-    int status;
     GUtilIntArray* offsets = gbinder_output_data_offsets(data);
-    void* offsets_buf = NULL;
 
     /* Build BC_REPLY */
     if (extra_buffers) {
@@ -486,30 +871,63 @@ gbinder_driver_reply_data(
         gbinder_driver_verbose_dump_bytes(' ', data->bytes);
         *cmd = io->bc.reply_sg;
         len += io->encode_reply_sg(buf + len, 0, 0, data->bytes,
-            offsets, &offsets_buf, extra_buffers);
+            offsets, offsets_buf, extra_buffers);
     } else {
         GVERBOSE("< BC_REPLY");
         gbinder_driver_verbose_dump_bytes(' ', data->bytes);
         *cmd = io->bc.reply;
         len += io->encode_reply(buf + len, 0, 0, data->bytes,
-            offsets, &offsets_buf);
+            offsets, offsets_buf);
     }
 
 #if 0 /* GUTIL_LOG_VERBOSE */
     if (offsets && offsets->count) {
-        gbinder_driver_verbose_dump('<', (uintptr_t)offsets_buf,
+        gbinder_driver_verbose_dump('<', (uintptr_t)*offsets_buf,
             offsets->count * io->pointer_size);
     }
 #endif /* GUTIL_LOG_VERBOSE */
 
-    /* Write it */
+    return len;
+}
+
+static
+int
+gbinder_driver_reply(
+    GBinderDriver* self,
+    GBinderDriverContext* context,
+    GBinderLocalReply* reply,
+    gint32 status)
+{
+    GBinderIoBuf write;
+    guint8 buf[GBINDER_MAX_BC_TRANSACTION_SG_SIZE + sizeof(guint32)];
+    void* offsets_buf = NULL;
+    int txstatus;
+
+    memset(&write, 0, sizeof(write));
     write.ptr = (uintptr_t)buf;
-    write.size = len;
-    write.consumed = 0;
-    status = gbinder_driver_write(self, &write);
+    write.size = reply ?
+        gbinder_driver_encode_reply_data(self, buf,
+            gbinder_local_reply_data(reply), &offsets_buf) :
+        gbinder_driver_encode_reply_status(self, buf, status);
+
+    /*
+     * Write the reply and read whatever comes back (normally that's
+     * BR_TRANSACTION_COMPLETE, possibly followed by the next incoming
+     * transaction) with a single BINDER_WRITE_READ. Anything that's left
+     * in the read buffer after BR_TRANSACTION_COMPLETE is handled by the
+     * caller without going back to poll.
+     */
+    do {
+        txstatus = gbinder_driver_write_read(self, &write, context->rbuf);
+        if (txstatus >= 0) {
+            txstatus = gbinder_driver_txstatus(self, context, NULL);
+        }
+    } while (txstatus == (-EAGAIN));
+    GBINDER_TRACE(GBINDER_TRACE_REPLY_SENT, 0, status, txstatus);
 
+    /* The kernel has copied the offsets by now */
     g_free(offsets_buf);
-    return status >= 0;
+    return txstatus;
 }
 
 static
@@ -527,8 +945,12 @@ gbinder_driver_handle_transaction(
     const char* iface;
     int txstatus = -EBADMSG;
 
+    g_atomic_int_inc(&self->tx_count);
     self->io->decode_transaction_data(data, &tx);
     gbinder_driver_verbose_transaction_data("BR_TRANSACTION", &tx);
+    GBINDER_TRACE(GBINDER_TRACE_BR_TRANSACTION, (uintptr_t)tx.target,
+        tx.code, tx.flags);
+    GBINDER_PROBE4(incoming_start, tx.target, tx.code, tx.flags, tx.size);
     req = gbinder_remote_request_new(reg, self->protocol, tx.pid, tx.euid);
     obj = gbinder_object_registry_get_local(reg, tx.target);
 
@@ -565,29 +987,32 @@ gbinder_driver_handle_transaction(
             gbinder_local_object_handle_transaction(obj, req, tx.code,
                 tx.flags, &txstatus);
         break;
+    case GBINDER_LOCAL_TRANSACTION_DIRECT:
+        /* The object wants its handler to be invoked on this thread */
+        reply = context->handler ?
+            gbinder_handler_transact_direct(context->handler, obj, req,
+                tx.code, tx.flags, &txstatus) :
+            gbinder_local_object_handle_transaction(obj, req, tx.code,
+                tx.flags, &txstatus);
+        break;
     default:
         GWARN("Unhandled transaction %s 0x%08x from %s", iface, tx.code,
             self->name);
         break;
     }
 
+    GBINDER_PROBE4(incoming_done, tx.code, tx.flags, txstatus, reply ?
+        gbinder_local_reply_data(reply)->bytes->len : 0);
+
     /* No reply for one-way transactions */
     if (!(tx.flags & GBINDER_TX_FLAG_ONEWAY)) {
         if (reply) {
             context->bufs = gbinder_buffer_contents_list_add(context->bufs,
                 gbinder_local_reply_contents(reply));
-            gbinder_driver_reply_data(self, gbinder_local_reply_data(reply));
-        } else {
-            gbinder_driver_reply_status(self, txstatus);
         }
 
-        /* Wait until the reply is handled */
-        do {
-            txstatus = gbinder_driver_write_read(self, NULL, context->rbuf);
-            if (txstatus >= 0) {
-                txstatus = gbinder_driver_txstatus(self, context, NULL);
-            }
-        } while (txstatus == (-EAGAIN));
+        /* Send the reply and wait until it's handled */
+        gbinder_driver_reply(self, context, reply, txstatus);
     }
 
     /* Free the data allocated for the transaction */
@@ -637,6 +1062,7 @@ gbinder_driver_handle_command(
         GVERBOSE("> BR_TRANSACTION_COMPLETE (?)");
     } else if (cmd == io->br.spawn_looper) {
         GVERBOSE("> BR_SPAWN_LOOPER");
+        gbinder_handler_spawn_looper(context->handler);
     } else if (cmd == io->br.finished) {
         GVERBOSE("> BR_FINISHED");
     } else if (cmd == io->br.increfs) {
@@ -692,6 +1118,19 @@ gbinder_driver_handle_command(
         }
     } else if (cmd == io->br.transaction) {
         gbinder_driver_handle_transaction(self, context, data);
+    } else if (cmd == io->br.reply) {
+        GBinderIoTxData tx;
+
+        io->decode_transaction_data(data, &tx);
+        gbinder_driver_verbose_transaction_data("BR_REPLY (late)", &tx);
+        gbinder_driver_free_buffer(self, tx.data);
+        gbinder_driver_abandoned_reply(self);
+    } else if (cmd == io->br.dead_reply) {
+        GVERBOSE("> BR_DEAD_REPLY (late)");
+        gbinder_driver_abandoned_reply(self);
+    } else if (cmd == io->br.failed_reply) {
+        GVERBOSE("> BR_FAILED_REPLY (late)");
+        gbinder_driver_abandoned_reply(self);
     } else if (cmd == io->br.dead_binder) {
         guint64 handle = 0;
         GBinderRemoteObject* obj;
@@ -800,6 +1239,11 @@ gbinder_driver_txstatus(
             if (!reply) {
                 txstatus = GBINDER_STATUS_OK;
             }
+        } else if (!reply && gbinder_driver_abandoned_find(self) &&
+            (cmd == io->br.reply || cmd == io->br.dead_reply ||
+            cmd == io->br.failed_reply)) {
+            /* Late reply to an abandoned transaction, not our status */
+            gbinder_driver_handle_command(self, context, cmd, data);
         } else if (cmd == io->br.dead_reply) {
             GVERBOSE("> BR_DEAD_REPLY");
             txstatus = GBINDER_STATUS_DEAD_OBJECT;
@@ -853,6 +1297,29 @@ gbinder_driver_txstatus(
     return txstatus;
 }
 
+static
+gsize
+gbinder_driver_read_buffer_size(
+    void)
+{
+    GKeyFile* k = gbinder_config_get();
+    gsize size = DEFAULT_READ_BUFFER_SIZE;
+
+    if (k) {
+        GError* error = NULL;
+        const int val = g_key_file_get_integer(k,
+            GBINDER_CONFIG_GROUP_GENERAL, CONF_READ_BUFFER_SIZE, &error);
+
+        if (error) {
+            g_error_free(error);
+        } else if (val > 0) {
+            size = CLAMP(val, GBINDER_IO_READ_BUFFER_SIZE,
+                MAX_READ_BUFFER_SIZE);
+        }
+    }
+    return size;
+}
+
 /*==========================================================================*
  * Interface
  *
@@ -892,6 +1359,7 @@ gbinder_driver_new(
                     GBinderDriver* self = g_slice_new0(GBinderDriver);
 
                     g_atomic_int_set(&self->refcount, 1);
+                    g_mutex_init(&self->stats_mutex);
                     self->fd = fd;
                     self->io = io;
                     self->vm = vm;
@@ -899,6 +1367,7 @@ gbinder_driver_new(
                     self->dev = g_strdup(dev);
                     self->name = self->dev + /* Shorter version for logging */
                         (g_str_has_prefix(self->dev, "/dev/") ? 5 : 0);
+                    self->read_buffer_size = gbinder_driver_read_buffer_size();
 
                     if (gbinder_system_ioctl(fd, BINDER_SET_MAX_THREADS,
                         &max_threads) < 0) {
@@ -924,6 +1393,37 @@ gbinder_driver_new(
     return NULL;
 }
 
+void
+gbinder_driver_get_stats(
+    GBinderDriver* self,
+    GBinderDriverStats* stats)
+{
+    guint i;
+
+    stats->ioctls = (guint)g_atomic_int_get(&self->ioctl_count);
+    stats->transactions = (guint)g_atomic_int_get(&self->tx_count);
+
+    /* Lock */
+    g_mutex_lock(&self->stats_mutex);
+    stats->bytes_written = self->bytes_written;
+    stats->bytes_read = self->bytes_read;
+    g_mutex_unlock(&self->stats_mutex);
+    /* Unlock */
+
+    for (i = 0; i < GBINDER_STATS_MAX_COMMANDS; i++) {
+        stats->bc[i] = (guint)g_atomic_int_get(self->bc_count + i);
+        stats->br[i] = (guint)g_atomic_int_get(self->br_count + i);
+    }
+}
+
+void
+gbinder_driver_set_stats(
+    GBinderDriver* self,
+    gboolean enabled)
+{
+    self->stats = enabled;
+}
+
 GBinderDriver*
 gbinder_driver_ref(
     GBinderDriver* self)
@@ -940,6 +1440,7 @@ gbinder_driver_unref(
     GASSERT(self->refcount > 0);
     if (g_atomic_int_dec_and_test(&self->refcount)) {
         gbinder_driver_close(self);
+        g_mutex_clear(&self->stats_mutex);
         g_free(self->dev);
         g_slice_free(GBinderDriver, self);
     }
@@ -959,11 +1460,29 @@ gbinder_driver_close(
     }
 }
 
+void
+gbinder_driver_wakeup(
+    GBinderDriver* self)
+{
+    /*
+     * Closing any file descriptor referring to the binder device makes
+     * the kernel kick all threads of this process out of BINDER_WRITE_READ
+     * (see binder_flush). Closing a duplicate does exactly that and leaves
+     * the original descriptor alone.
+     */
+    const int fd = dup(self->fd);
+
+    if (fd >= 0) {
+        close(fd);
+    } else {
+        GWARN("Failed to dup %s fd: %s", self->dev, strerror(errno));
+    }
+}
+
 int
 gbinder_driver_fd(
     GBinderDriver* self)
 {
-    /* Only used by unit tests */
     return self->fd;
 }
 
@@ -971,6 +1490,16 @@ int
 gbinder_driver_poll(
     GBinderDriver* self,
     struct pollfd* pipefd)
+{
+    return gbinder_driver_poll2(self, pipefd, -1);
+}
+
+/* Returns zero on timeout */
+int
+gbinder_driver_poll2(
+    GBinderDriver* self,
+    struct pollfd* pipefd,
+    int timeout_ms)
 {
     struct pollfd fds[2];
     nfds_t n = 1;
@@ -986,7 +1515,7 @@ gbinder_driver_poll(
         n++;
     }
 
-    err = poll(fds, n, -1);
+    err = poll(fds, n, timeout_ms);
     if (err >= 0) {
         if (pipefd) {
             pipefd->revents = fds[1].revents;
@@ -1037,7 +1566,7 @@ gbinder_driver_acquire_done(
     write.size = 4 + io->encode_ptr_cookie(data + 1, obj);
 
     GVERBOSE("< BC_ACQUIRE_DONE %p", obj);
-    return gbinder_driver_write(self, &write) >= 0;
+    return gbinder_driver_queue(self, &write) >= 0;
 }
 
 gboolean
@@ -1057,7 +1586,7 @@ gbinder_driver_dead_binder_done(
         write.size = 4 + io->encode_cookie(data + 1, obj->handle);
 
         GVERBOSE("< BC_DEAD_BINDER_DONE 0x%08x", obj->handle);
-        return gbinder_driver_write(self, &write) >= 0;
+        return gbinder_driver_queue(self, &write) >= 0;
     } else {
         return FALSE;
     }
@@ -1173,7 +1702,25 @@ gbinder_driver_free_buffer(
         write.ptr = (uintptr_t)wbuf;
         write.size = len;
         write.consumed = 0;
-        (void) gbinder_driver_write(self, &write);
+        (void) gbinder_driver_queue(self, &write);
+    }
+}
+
+void
+gbinder_driver_flush(
+    GBinderDriver* self)
+{
+    GByteArray* queue = gbinder_driver_out_pending(self);
+
+    if (queue) {
+        GBinderIoBuf merged;
+
+        if (gbinder_driver_write_buf(self, gbinder_driver_out_merge(queue,
+            NULL, &merged)) < 0) {
+            GWARN("Failed to flush %u bytes to %s", queue->len, self->name);
+        }
+        /* Drop whatever couldn't be written, there's no point in retrying */
+        g_byte_array_set_size(queue, 0);
     }
 }
 
@@ -1193,23 +1740,68 @@ gbinder_driver_exit_looper(
     return gbinder_driver_cmd(self, self->io->bc.exit_looper);
 }
 
+/*
+ * Releases the kernel state of the calling thread, which otherwise
+ * stays around until the fd gets closed. Must be the last thing the
+ * thread does with the driver.
+ */
+gboolean
+gbinder_driver_thread_exit(
+    GBinderDriver* self)
+{
+    gint32 unused = 0;
+
+    if (gbinder_system_ioctl(self->fd, BINDER_THREAD_EXIT, &unused) >= 0) {
+        GVERBOSE("%s thread exit", self->name);
+        return TRUE;
+    } else {
+        GWARN("%s failed to release the thread: %s", self->name,
+            strerror(errno));
+        return FALSE;
+    }
+}
+
+gboolean
+gbinder_driver_register_looper(
+    GBinderDriver* self)
+{
+    GVERBOSE("< BC_REGISTER_LOOPER");
+    return gbinder_driver_cmd(self, self->io->bc.register_looper);
+}
+
+gboolean
+gbinder_driver_set_max_threads(
+    GBinderDriver* self,
+    guint32 max_threads)
+{
+    if (gbinder_system_ioctl(self->fd, BINDER_SET_MAX_THREADS,
+        &max_threads) >= 0) {
+        GDEBUG("%s max threads %u", self->name, max_threads);
+        return TRUE;
+    } else {
+        GERR("%s failed to set max threads (%u): %s", self->name,
+            max_threads, strerror(errno));
+        return FALSE;
+    }
+}
+
 int
 gbinder_driver_read(
     GBinderDriver* self,
     GBinderObjectRegistry* reg,
     GBinderHandler* handler)
 {
-    GBinderDriverReadData read;
+    GBinderDriverReadData* read = gbinder_driver_read_data_new(self);
+    const gboolean queue = gbinder_driver_out_begin(self);
     GBinderDriverContext context;
     int ret;
 
-    gbinder_driver_read_init(&read);
-    gbinder_driver_context_init(&context, &read.buf, reg, handler);
+    gbinder_driver_context_init(&context, &read->buf, reg, handler);
     ret = gbinder_driver_write_read(self, NULL, context.rbuf);
     if (ret >= 0) {
         /* Loop until we have handled all the incoming commands */
         gbinder_driver_handle_commands(self, &context);
-        while (read.buf.io.consumed && gbinder_handler_can_loop(handler)) {
+        while (read->buf.io.consumed && gbinder_handler_can_loop(handler)) {
             ret = gbinder_driver_write_read(self, NULL, context.rbuf);
             if (ret >= 0) {
                 gbinder_driver_handle_commands(self, &context);
@@ -1219,36 +1811,28 @@ gbinder_driver_read(
         }
     }
     gbinder_driver_context_cleanup(&context);
+    gbinder_driver_out_end(self, queue);
+    gbinder_driver_read_data_free(read);
     return ret;
 }
 
-int
-gbinder_driver_transact(
+static
+gsize
+gbinder_driver_encode_transaction(
     GBinderDriver* self,
-    GBinderObjectRegistry* reg,
-    GBinderHandler* handler,
+    guint8* buf,
     guint32 handle,
     guint32 code,
+    guint32 flags,
     GBinderLocalRequest* req,
-    GBinderRemoteReply* reply)
+    void** offsets_buf)
 {
-    GBinderDriverReadData read;
-    GBinderDriverContext context;
-    GBinderIoBuf write;
-    GBinderDriverReadBuf* rbuf = &read.buf;
     const GBinderIo* io = self->io;
-    const guint flags = reply ? 0 : GBINDER_TX_FLAG_ONEWAY;
     GBinderOutputData* data = gbinder_local_request_data(req);
     const gsize extra_buffers = gbinder_output_data_buffers_size(data);
     GUtilIntArray* offsets = gbinder_output_data_offsets(data);
-    void* offsets_buf = NULL;
-    guint8 wbuf[GBINDER_MAX_BC_TRANSACTION_SG_SIZE + sizeof(guint32)];
-    guint32* cmd = (guint32*)wbuf;
+    guint32* cmd = (guint32*)buf;
     guint len = sizeof(*cmd);
-    int txstatus = (-EAGAIN);
-
-    gbinder_driver_read_init(&read);
-    gbinder_driver_context_init(&context, &read.buf, reg, handler);
 
     /* Build BC_TRANSACTION */
     if (extra_buffers) {
@@ -1256,33 +1840,177 @@ gbinder_driver_transact(
             (guint)extra_buffers);
         gbinder_driver_verbose_dump_bytes(' ', data->bytes);
         *cmd = io->bc.transaction_sg;
-        len += io->encode_transaction_sg(wbuf + len, handle, code,
-            data->bytes, flags, offsets, &offsets_buf, extra_buffers);
+        len += io->encode_transaction_sg(buf + len, handle, code,
+            data->bytes, flags, offsets, offsets_buf, extra_buffers);
     } else {
         GVERBOSE("< BC_TRANSACTION 0x%08x 0x%08x", handle, code);
         gbinder_driver_verbose_dump_bytes(' ', data->bytes);
         *cmd = io->bc.transaction;
-        len += io->encode_transaction(wbuf + len, handle, code,
-            data->bytes, flags, offsets, &offsets_buf);
+        len += io->encode_transaction(buf + len, handle, code,
+            data->bytes, flags, offsets, offsets_buf);
     }
 
 #if 0 /* GUTIL_LOG_VERBOSE */
     if (offsets && offsets->count) {
-        gbinder_driver_verbose_dump('<', (uintptr_t)offsets_buf,
+        gbinder_driver_verbose_dump('<', (uintptr_t)*offsets_buf,
             offsets->count * io->pointer_size);
     }
 #endif /* GUTIL_LOG_VERBOSE */
 
+    return len;
+}
+
+/* Waits until there's something to read or the deadline passes */
+static
+int
+gbinder_driver_wait(
+    GBinderDriver* self,
+    gint64 deadline)
+{
+    gint64 now;
+
+    /* Don't keep the queued commands while waiting */
+    gbinder_driver_flush(self);
+    while ((now = g_get_monotonic_time()) < deadline) {
+        const gint64 ms = (deadline - now + 999) / 1000;
+
+        if (gbinder_driver_poll2(self, NULL, (int)MIN(ms, G_MAXINT)) > 0) {
+            return 0;
+        }
+    }
+    return (-ETIMEDOUT);
+}
+
+/*
+ * Picks up the late replies to the transactions previously abandoned
+ * by this thread, handling whatever else arrives in the meantime.
+ * Without a deadline, it only takes what's already there and returns
+ * -EBUSY if that's not enough, rather than blocking until the remote
+ * side answers (which may never happen).
+ */
+static
+int
+gbinder_driver_drain(
+    GBinderDriver* self,
+    GBinderDriverContext* context,
+    gint64 deadline)
+{
+    int err = 0;
+
+    while (!err && gbinder_driver_abandoned_find(self)) {
+        if (deadline) {
+            err = gbinder_driver_wait(self, deadline);
+        } else {
+            gbinder_driver_flush(self);
+            if (gbinder_driver_poll2(self, NULL, 0) <= 0) {
+                err = (-EBUSY);
+            }
+        }
+        if (!err) {
+            err = gbinder_driver_write_read(self, NULL, context->rbuf);
+            if (err >= 0) {
+                gbinder_driver_handle_commands(self, context);
+                err = 0;
+            }
+        }
+    }
+    return err;
+}
+
+gboolean
+gbinder_driver_has_abandoned_tx(
+    GBinderDriver* self)
+{
+    return gbinder_driver_abandoned_find(self) != NULL;
+}
+
+int
+gbinder_driver_transact(
+    GBinderDriver* self,
+    GBinderObjectRegistry* reg,
+    GBinderHandler* handler,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* req,
+    GBinderRemoteReply* reply)
+{
+    return gbinder_driver_transact_deadline(self, reg, handler, handle, code,
+        req, reply, 0);
+}
+
+/*
+ * If the deadline passes before the transaction is sent, it's not sent
+ * at all. If it passes while waiting for the reply, the transaction is
+ * abandoned and its reply will be discarded. Either way, -ETIMEDOUT is
+ * returned. Until the late reply arrives, the kernel won't take another
+ * synchronous transaction from this thread. Those fail with -EBUSY (or
+ * -ETIMEDOUT if they have a deadline of their own). One-way transactions
+ * are not affected.
+ */
+int
+gbinder_driver_transact_deadline(
+    GBinderDriver* self,
+    GBinderObjectRegistry* reg,
+    GBinderHandler* handler,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* req,
+    GBinderRemoteReply* reply,
+    gint64 deadline)
+{
+    GBinderDriverReadData* read = gbinder_driver_read_data_new(self);
+    GBinderDriverContext context;
+    GBinderIoBuf write;
+    GBinderDriverReadBuf* rbuf = &read->buf;
+    const guint flags = reply ? 0 : GBINDER_TX_FLAG_ONEWAY;
+    void* offsets_buf = NULL;
+    guint8 wbuf[GBINDER_MAX_BC_TRANSACTION_SG_SIZE + sizeof(guint32)];
+    int txstatus = (-EAGAIN);
+    const gboolean queue = gbinder_driver_out_begin(self);
+
+    /* One-way transactions don't wait for anything */
+    if (!reply) {
+        deadline = 0;
+    }
+
+    g_atomic_int_inc(&self->tx_count);
+    gbinder_driver_context_init(&context, rbuf, reg, handler);
+
     /* Write it */
     write.ptr = (uintptr_t)wbuf;
-    write.size = len;
+    write.size = gbinder_driver_encode_transaction(self, wbuf, handle, code,
+        flags, req, &offsets_buf);
     write.consumed = 0;
+    GBINDER_PROBE4(transact_start, handle, code, flags, req ?
+        gbinder_local_request_data(req)->bytes->len : 0);
+
+    /*
+     * The kernel rejects nested synchronous transactions, those can't be
+     * sent until the previous replies are picked up. One-way are fine.
+     */
+    txstatus = reply ? gbinder_driver_drain(self, &context, deadline) : 0;
+    if (!txstatus) {
+        txstatus = (deadline && g_get_monotonic_time() >= deadline) ?
+            (-ETIMEDOUT) : (-EAGAIN);
+    }
 
     /* And wait for reply. Positive txstatus is the transaction status,
      * negative is a driver error (except for -EAGAIN meaning that there's
      * no status yet) */
     while (txstatus == (-EAGAIN)) {
-        int err = gbinder_driver_write_read(self, &write, rbuf);
+        int err;
+
+        if (!deadline) {
+            err = gbinder_driver_write_read(self, &write, rbuf);
+        } else if (write.consumed < write.size) {
+            err = gbinder_driver_write(self, &write);
+        } else if ((err = gbinder_driver_wait(self, deadline)) == 0) {
+            err = gbinder_driver_write_read(self, NULL, rbuf);
+        } else {
+            /* Whatever comes later will be discarded */
+            GWARN("Transaction 0x%08x 0x%08x timed out", handle, code);
+            gbinder_driver_abandon(self);
+        }
         if (err < 0) {
             txstatus = err;
         } else {
@@ -1308,10 +2036,92 @@ gbinder_driver_transact(
     }
 
     gbinder_driver_context_cleanup(&context);
+    gbinder_driver_out_end(self, queue);
+    gbinder_driver_read_data_free(read);
     g_free(offsets_buf);
+    GBINDER_PROBE3(transact_done, handle, code, txstatus);
     return txstatus;
 }
 
+void
+gbinder_driver_transact_oneway(
+    GBinderDriver* self,
+    GBinderObjectRegistry* reg,
+    GBinderHandler* handler,
+    GBinderDriverOneway* txs,
+    guint count)
+{
+    GBinderDriverReadData* read = gbinder_driver_read_data_new(self);
+    GBinderDriverReadBuf* rbuf = &read->buf;
+    GByteArray* wbuf = g_byte_array_new();
+    void** offsets_bufs = g_new0(void*, count);
+    const gboolean queue = gbinder_driver_out_begin(self);
+    GBinderDriverContext context;
+    GBinderIoBuf write;
+    guint i, done = 0;
+
+    g_atomic_int_add(&self->tx_count, count);
+    gbinder_driver_context_init(&context, rbuf, reg, handler);
+
+    /* All BC_TRANSACTIONs go to the driver with a single write */
+    for (i = 0; i < count; i++) {
+        guint8 buf[GBINDER_MAX_BC_TRANSACTION_SG_SIZE + sizeof(guint32)];
+
+        g_byte_array_append(wbuf, buf, gbinder_driver_encode_transaction(self,
+            buf, txs[i].handle, txs[i].code, GBINDER_TX_FLAG_ONEWAY,
+            txs[i].req, offsets_bufs + i));
+        GBINDER_PROBE4(transact_start, txs[i].handle, txs[i].code,
+            GBINDER_TX_FLAG_ONEWAY, txs[i].req ?
+            gbinder_local_request_data(txs[i].req)->bytes->len : 0);
+    }
+
+    memset(&write, 0, sizeof(write));
+    write.ptr = (uintptr_t)wbuf->data;
+    write.size = wbuf->len;
+
+    /*
+     * Collect the statuses, one per transaction. Note that the driver
+     * stops processing the write buffer after the first failure, the
+     * rest gets written by the next ioctl.
+     */
+    while (done < count) {
+        const int err = gbinder_driver_write_read(self, &write, rbuf);
+
+        if (err < 0) {
+            while (done < count) {
+                txs[done++].status = err;
+            }
+        } else {
+            int txstatus;
+
+            while (done < count && (txstatus =
+                gbinder_driver_txstatus(self, &context, NULL)) != (-EAGAIN)) {
+                txs[done++].status = txstatus;
+            }
+        }
+    }
+
+    /* Loop until we have handled all the incoming commands */
+    gbinder_driver_handle_commands(self, &context);
+    while (rbuf->io.consumed) {
+        if (gbinder_driver_write_read(self, NULL, rbuf) < 0) {
+            break;
+        } else {
+            gbinder_driver_handle_commands(self, &context);
+        }
+    }
+    gbinder_driver_context_cleanup(&context);
+    gbinder_driver_out_end(self, queue);
+    gbinder_driver_read_data_free(read);
+    for (i = 0; i < count; i++) {
+        GBINDER_PROBE3(transact_done, txs[i].handle, txs[i].code,
+            txs[i].status);
+        g_free(offsets_bufs[i]);
+    }
+    g_free(offsets_bufs);
+    g_byte_array_free(wbuf, TRUE);
+}
+
 GBinderLocalRequest*
 gbinder_driver_local_request_new(
     GBinderDriver* self,
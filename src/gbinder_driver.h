@@ -35,6 +35,8 @@
 
 #include "gbinder_types_p.h"
 
+#include <gbinder_stats.h>
+
 struct pollfd;
 
 GBinderDriver*
@@ -58,17 +60,52 @@ gbinder_driver_close(
     GBinderDriver* driver)
     GBINDER_INTERNAL;
 
+/* Wakes up all threads blocked in BINDER_WRITE_READ */
+void
+gbinder_driver_wakeup(
+    GBinderDriver* driver)
+    GBINDER_INTERNAL;
+
 int
 gbinder_driver_fd(
     GBinderDriver* driver)
     GBINDER_INTERNAL;
 
+typedef struct gbinder_driver_stats {
+    guint ioctls;        /* BINDER_WRITE_READ */
+    guint transactions;  /* Both incoming and outgoing */
+    /* The rest is only collected if enabled by gbinder_driver_set_stats */
+    guint64 bytes_written;
+    guint64 bytes_read;
+    guint bc[GBINDER_STATS_MAX_COMMANDS]; /* By _IOC_NR */
+    guint br[GBINDER_STATS_MAX_COMMANDS]; /* By _IOC_NR */
+} GBinderDriverStats;
+
+void
+gbinder_driver_get_stats(
+    GBinderDriver* driver,
+    GBinderDriverStats* stats)
+    GBINDER_INTERNAL;
+
+void
+gbinder_driver_set_stats(
+    GBinderDriver* driver,
+    gboolean enabled)
+    GBINDER_INTERNAL;
+
 int
 gbinder_driver_poll(
     GBinderDriver* driver,
     struct pollfd* pollfd)
     GBINDER_INTERNAL;
 
+int
+gbinder_driver_poll2(
+    GBinderDriver* driver,
+    struct pollfd* pollfd,
+    int timeout_ms)
+    GBINDER_INTERNAL;
+
 const char*
 gbinder_driver_dev(
     GBinderDriver* driver)
@@ -145,6 +182,29 @@ gbinder_driver_free_buffer(
     void* buffer)
     GBINDER_INTERNAL;
 
+/* Sends the commands queued by this thread (if any) to the driver */
+void
+gbinder_driver_flush(
+    GBinderDriver* driver)
+    GBINDER_INTERNAL;
+
+/*
+ * Starts queueing the outgoing commands on this thread. Returns FALSE
+ * if the thread is already queueing (for this or another driver), in
+ * which case gbinder_driver_out_end() does nothing.
+ */
+gboolean
+gbinder_driver_out_begin(
+    GBinderDriver* driver)
+    GBINDER_INTERNAL;
+
+/* Flushes the queue and stops queueing, if begun is TRUE */
+void
+gbinder_driver_out_end(
+    GBinderDriver* driver,
+    gboolean begun)
+    GBINDER_INTERNAL;
+
 gboolean
 gbinder_driver_enter_looper(
     GBinderDriver* driver)
@@ -155,6 +215,22 @@ gbinder_driver_exit_looper(
     GBinderDriver* driver)
     GBINDER_INTERNAL;
 
+gboolean
+gbinder_driver_thread_exit(
+    GBinderDriver* driver)
+    GBINDER_INTERNAL;
+
+gboolean
+gbinder_driver_register_looper(
+    GBinderDriver* driver)
+    GBINDER_INTERNAL;
+
+gboolean
+gbinder_driver_set_max_threads(
+    GBinderDriver* driver,
+    guint32 max_threads)
+    GBINDER_INTERNAL;
+
 int
 gbinder_driver_read(
     GBinderDriver* driver,
@@ -173,6 +249,42 @@ gbinder_driver_transact(
     GBinderRemoteReply* reply)
     GBINDER_INTERNAL;
 
+/* Deadline is g_get_monotonic_time() based, zero means no deadline */
+int
+gbinder_driver_transact_deadline(
+    GBinderDriver* driver,
+    GBinderObjectRegistry* reg,
+    GBinderHandler* handler,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* request,
+    GBinderRemoteReply* reply,
+    gint64 deadline)
+    GBINDER_INTERNAL;
+
+/* TRUE if the calling thread is still owed replies by the driver */
+gboolean
+gbinder_driver_has_abandoned_tx(
+    GBinderDriver* driver)
+    GBINDER_INTERNAL;
+
+typedef struct gbinder_driver_oneway {
+    guint32 handle;
+    guint32 code;
+    GBinderLocalRequest* req;
+    int status;             /* Output */
+} GBinderDriverOneway;
+
+/* Sends a bunch of one-way transactions with as few ioctls as possible */
+void
+gbinder_driver_transact_oneway(
+    GBinderDriver* driver,
+    GBinderObjectRegistry* reg,
+    GBinderHandler* handler,
+    GBinderDriverOneway* txs,
+    guint count)
+    GBINDER_INTERNAL;
+
 GBinderLocalRequest*
 gbinder_driver_local_request_new(
     GBinderDriver* driver,
@@ -61,6 +61,13 @@ typedef struct gbinder_eventloop_glib_callback {
     GBinderEventLoopCallback callback;
 } GBinderEventLoopCallbackGLib;
 
+typedef struct gbinder_eventloop_glib_watch {
+    GBinderEventLoopWatch watch;
+    guint id;
+    GBinderEventLoopCallbackFunc func;
+    gpointer data;
+} GBinderEventLoopWatchGLib;
+
 static
 inline
 GBinderEventLoopTimeoutGLib*
@@ -209,6 +216,57 @@ gbinder_eventloop_glib_callback_cancel(
     g_source_destroy(gbinder_eventloop_glib_callback_source(cb));
 }
 
+static
+gboolean
+gbinder_eventloop_glib_watch_callback(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer data)
+{
+    GBinderEventLoopWatchGLib* watch = data;
+
+    watch->func(watch->data);
+    return G_SOURCE_CONTINUE;
+}
+
+static
+void
+gbinder_eventloop_glib_watch_finalize(
+    gpointer data)
+{
+    g_slice_free1(sizeof(GBinderEventLoopWatchGLib), data);
+}
+
+static
+GBinderEventLoopWatch*
+gbinder_eventloop_glib_watch_add(
+    int fd,
+    GBinderEventLoopCallbackFunc func,
+    gpointer data)
+{
+    GBinderEventLoopWatchGLib* impl = g_slice_new(GBinderEventLoopWatchGLib);
+    GIOChannel* channel = g_io_channel_unix_new(fd);
+
+    impl->watch.eventloop = &gbinder_eventloop_glib;
+    impl->func = func;
+    impl->data = data;
+    impl->id = g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
+        G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
+        gbinder_eventloop_glib_watch_callback, impl,
+        gbinder_eventloop_glib_watch_finalize);
+    /* The source holds its own reference, fd stays open */
+    g_io_channel_unref(channel);
+    return &impl->watch;
+}
+
+static
+void
+gbinder_eventloop_glib_watch_remove(
+    GBinderEventLoopWatch* watch)
+{
+    g_source_remove(G_CAST(watch,GBinderEventLoopWatchGLib,watch)->id);
+}
+
 static
 void
 gbinder_eventloop_glib_cleanup(
@@ -224,7 +282,9 @@ static const GBinderEventLoopIntegration gbinder_eventloop_glib = {
     gbinder_eventloop_glib_callback_unref,
     gbinder_eventloop_glib_callback_schedule,
     gbinder_eventloop_glib_callback_cancel,
-    gbinder_eventloop_glib_cleanup
+    gbinder_eventloop_glib_cleanup,
+    gbinder_eventloop_glib_watch_add,
+    gbinder_eventloop_glib_watch_remove
 };
 
 /*==========================================================================*
@@ -379,6 +439,25 @@ gbinder_idle_callback_invoke_later(
     gbinder_idle_callback_schedule(idle->cb);
 }
 
+GBinderEventLoopWatch*
+gbinder_fd_watch_add(
+    int fd,
+    GBinderEventLoopCallbackFunc func,
+    gpointer data)
+{
+    return gbinder_eventloop->watch_add ?
+        gbinder_eventloop->watch_add(fd, func, data) : NULL;
+}
+
+void
+gbinder_fd_watch_remove(
+    GBinderEventLoopWatch* watch)
+{
+    if (watch) {
+        watch->eventloop->watch_remove(watch);
+    }
+}
+
 /*==========================================================================*
  * Public interface
  *==========================================================================*/
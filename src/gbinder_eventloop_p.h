@@ -104,6 +104,20 @@ gbinder_idle_callback_invoke_later(
     GDestroyNotify destroy)
     GBINDER_INTERNAL;
 
+/* Returns NULL if the event loop integration doesn't support fd watches */
+GBinderEventLoopWatch*
+gbinder_fd_watch_add(
+    int fd,
+    GBinderEventLoopCallbackFunc func,
+    gpointer data)
+    G_GNUC_WARN_UNUSED_RESULT
+    GBINDER_INTERNAL;
+
+void
+gbinder_fd_watch_remove(
+    GBinderEventLoopWatch* watch)
+    GBINDER_INTERNAL;
+
 #endif /* GBINDER_EVENTLOOP_PRIVATE_H */
 
 /*
@@ -40,6 +40,12 @@ typedef struct gbinder_handler_functions {
     GBinderLocalReply* (*transact)(GBinderHandler* handler,
         GBinderLocalObject* obj, GBinderRemoteRequest* req, guint code,
         guint flags, int* status);
+    /* Same as transact but the handler is invoked on the calling thread */
+    GBinderLocalReply* (*transact_direct)(GBinderHandler* handler,
+        GBinderLocalObject* obj, GBinderRemoteRequest* req, guint code,
+        guint flags, int* status);
+    /* Kernel is asking for another looper (BR_SPAWN_LOOPER) */
+    void (*spawn_looper)(GBinderHandler* handler);
 } GBinderHandlerFunctions;
 
 struct gbinder_handler {
@@ -70,6 +76,32 @@ gbinder_handler_transact(
         NULL;
 }
 
+GBINDER_INLINE_FUNC
+GBinderLocalReply*
+gbinder_handler_transact_direct(
+    GBinderHandler* self,
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status)
+{
+    /* Fall back to the regular transact if direct one isn't available */
+    return !self ? NULL : self->f->transact_direct ?
+        self->f->transact_direct(self, obj, req, code, flags, status) :
+        self->f->transact(self, obj, req, code, flags, status);
+}
+
+GBINDER_INLINE_FUNC
+void
+gbinder_handler_spawn_looper(
+    GBinderHandler* self)
+{
+    if (self && self->f->spawn_looper) {
+        self->f->spawn_looper(self);
+    }
+}
+
 #endif /* GBINDER_HANDLER_H */
 
 /*
@@ -164,6 +164,31 @@ GBINDER_IO_FN(encode_cookie)(
     return sizeof(*dest);
 }
 
+/*
+ * Scheduling bits of flat_binder_object flags. Without the minimum
+ * policy, the priority bits are 0x7f (the lowest nice value possible,
+ * i.e. no minimum), which is what Android used to do too.
+ */
+static
+guint32
+GBINDER_IO_FN(local_object_flags)(
+    GBinderLocalObject* obj)
+{
+    guint32 flags = FLAT_BINDER_FLAG_ACCEPTS_FDS;
+
+    if (obj->min_sched_policy < 0) {
+        flags |= 0x7f;
+    } else {
+        flags |= (obj->min_sched_priority & FLAT_BINDER_FLAG_PRIORITY_MASK) |
+            ((obj->min_sched_policy << FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT) &
+            FLAT_BINDER_FLAG_SCHED_POLICY_MASK);
+    }
+    if (obj->inherit_rt) {
+        flags |= FLAT_BINDER_FLAG_INHERIT_RT;
+    }
+    return flags;
+}
+
 /* Encodes flat_binder_object */
 static
 guint
@@ -177,7 +202,7 @@ GBINDER_IO_FN(encode_local_object)(
     memset(dest, 0, sizeof(*dest));
     dest->hdr.type = BINDER_TYPE_BINDER;
     if (obj) {
-        dest->flags = 0x7f | FLAT_BINDER_FLAG_ACCEPTS_FDS;
+        dest->flags = GBINDER_IO_FN(local_object_flags)(obj);
         dest->binder = (uintptr_t)obj;
     }
     if (protocol->finish_flatten_binder) {
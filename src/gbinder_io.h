@@ -62,7 +62,7 @@ typedef struct gbinder_io_tx_data {
     void** objects;
 } GBinderIoTxData;
 
-/* Read buffer size (allocated on stack, shouldn't be too large) */
+/* Minimum read buffer size (must fit any single BR_ command) */
 #define GBINDER_IO_READ_BUFFER_SIZE (128)
 
 /*
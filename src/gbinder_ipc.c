@@ -33,11 +33,13 @@
 #define _GNU_SOURCE  /* pthread_*_np */
 
 #include "gbinder_ipc.h"
+#include "gbinder_config.h"
 #include "gbinder_driver.h"
 #include "gbinder_handler.h"
 #include "gbinder_io.h"
 #include "gbinder_rpc_protocol.h"
 #include "gbinder_object_registry.h"
+#include "gbinder_probes.h"
 #include "gbinder_local_object_p.h"
 #include "gbinder_local_reply.h"
 #include "gbinder_local_request_p.h"
@@ -45,38 +47,122 @@
 #include "gbinder_remote_reply_p.h"
 #include "gbinder_remote_request_p.h"
 #include "gbinder_eventloop_p.h"
+#include "gbinder_stats_p.h"
+#include "gbinder_thread_attr.h"
+#include "gbinder_trace_p.h"
 #include "gbinder_writer.h"
 #include "gbinder_log.h"
 
 #include <gutil_macros.h>
 
+#include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <poll.h>
 #include <errno.h>
 #include <time.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifndef SYS_futex
+#  define SYS_futex SYS_futex_time64
+#endif
 
 typedef struct gbinder_ipc_looper GBinderIpcLooper;
 typedef GObjectClass GBinderIpcClass;
 
+#define GBINDER_IPC_TX_LANES (GBINDER_TX_LANE_URGENT + 1)
+
+/*
+ * Local and remote objects are looked up by every incoming transaction
+ * and every unflattened handle, potentially on many threads at once.
+ * To keep them from serializing on a single mutex, each table is split
+ * into shards which are selected by the key (object pointer or handle)
+ * and locked independently. Each shard occupies its own cache line.
+ * GObject private data isn't aligned that well, so the shard arrays are
+ * allocated separately, with posix_memalign().
+ */
+#define GBINDER_IPC_REGISTRY_SHARDS (16) /* Must be a power of 2 */
+#define GBINDER_IPC_CACHE_LINE (64)
+
+typedef union gbinder_ipc_registry_shard {
+    struct {
+        GMutex mutex;
+        GHashTable* table;
+    } s;
+    guint8 pad[GBINDER_IPC_CACHE_LINE];
+} GBinderIpcRegistryShard;
+
+/*
+ * Handles are small integers allocated by the kernel more or less
+ * sequentially, so remote objects are kept in a plain array indexed by
+ * handle / GBINDER_IPC_REGISTRY_SHARDS. The array grows on demand.
+ * Handles beyond GBINDER_IPC_REMOTE_DENSE_MAX go to the overflow hash
+ * table, so that a single huge handle doesn't blow up the array.
+ */
+#define GBINDER_IPC_REMOTE_DENSE_MAX (0x10000)
+#define GBINDER_IPC_REMOTE_DENSE_MIN_SIZE (16)
+
+typedef union gbinder_ipc_remote_shard {
+    struct {
+        GMutex mutex;
+        GBinderRemoteObject** objects;
+        guint size;
+        guint count; /* Including overflow */
+        GHashTable* overflow;
+    } s;
+    guint8 pad[GBINDER_IPC_CACHE_LINE];
+} GBinderIpcRemoteShard;
+
 struct gbinder_ipc_priv {
     GBinderIpc* self;
-    GThreadPool* tx_pool;
+    GThreadPool* tx_pool[GBINDER_IPC_TX_LANES];
+    GMutex tx_pool_mutex;
+    gint tx_threads[GBINDER_IPC_TX_LANES]; /* Protected by tx_pool_mutex */
+    guint tx_abandoned[GBINDER_IPC_TX_LANES]; /* Ditto */
+    GBinderThreadAttrPriv* thread_attr; /* Ditto */
     GHashTable* tx_table;
+    GPtrArray* oneway_queue;
+    GBinderEventLoopCallback* oneway_flush;
+    struct gbinder_ipc_tx_priv* completed; /* Lock-free, newest first */
+    gint completed_depth;
+    gint completed_max_depth;
+    gint completion_batches;
+    gint completions;
     char* dev;
     char* key;
     const char* name;
     GBinderObjectRegistry object_registry;
 
-    GMutex remote_objects_mutex;
-    GHashTable* remote_objects;
-
-    GMutex local_objects_mutex;
-    GHashTable* local_objects;
+    GBinderIpcRemoteShard* remote_objects; /* Cache line aligned */
+    GBinderIpcRegistryShard* local_objects; /* Ditto */
 
     GMutex looper_mutex;
     GBinderIpcLooper* primary_loopers;
     GBinderIpcLooper* blocked_loopers;
+    guint max_spawned_loopers;
+    guint spawned_loopers;
+    guint retired_loopers;
+    gboolean spawn_pending;
+    gint spawn_failed;
+    gboolean blocking_loopers;
+
+    /* Main loop polling mode */
+    gboolean main_loop_polling;
+    GBinderEventLoopCallback* poll_setup;
+    GBinderEventLoopWatch* poll_watch;
+    pthread_t poll_thread;
+
+    /* Statistics */
+    GMutex stats_mutex;
+    GBinderStatsLatency sync_calls;
+    GBinderStatsLatency async_calls;
+    GBinderStatsLatency incoming;
+    gint oneway_calls;
+    gint failed_calls;
+    gboolean stats_enabled;
+    gboolean stats_transaction;
 };
 
 #define PARENT_CLASS gbinder_ipc_parent_class
@@ -93,25 +179,115 @@ G_DEFINE_TYPE(GBinderIpc, gbinder_ipc, G_TYPE_OBJECT)
 static GHashTable* gbinder_ipc_table = NULL;
 static pthread_mutex_t gbinder_ipc_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Asynchronous transactions are executed by the worker threads. There
+ * are two pools (lanes) of those, one for the regular transactions and
+ * one for those submitted with GBINDER_TX_FLAG_URGENT. Urgent ones are
+ * supposed to be quick and this way they don't have to wait behind the
+ * bulk traffic. Maximum number of threads in each pool can be changed
+ * with gbinder_ipc_set_tx_threads() or in the config:
+ *
+ * [General]
+ * TxThreads = 15
+ * UrgentTxThreads = 4
+ */
+#define CONF_TX_THREADS "TxThreads"
+#define CONF_URGENT_TX_THREADS "UrgentTxThreads"
+
 #define GBINDER_IPC_MAX_TX_THREADS (15)
+#define GBINDER_IPC_MAX_URGENT_TX_THREADS (4)
 #define GBINDER_IPC_MAX_PRIMARY_LOOPERS (5)
+#define GBINDER_IPC_MAX_SPAWNED_LOOPERS (15)
 #define GBINDER_IPC_LOOPER_START_TIMEOUT_SEC (2)
 #define GBINDER_IPC_LOOPER_JOIN_TIMEOUT_MS (500)
+#define GBINDER_IPC_LOOPER_IDLE_TIMEOUT_MS (10000)
+
+/*
+ * In addition to the primary looper(s), the kernel may ask us to start
+ * more loopers (BR_SPAWN_LOOPER) when all of the existing ones are busy.
+ * There can be up to max_spawned_loopers of those at any time (set by
+ * gbinder_ipc_set_max_threads, zero disables spawning and no limit for
+ * the workers means GBINDER_IPC_MAX_SPAWNED_LOOPERS) and they exit after
+ * having nothing to do for GBINDER_IPC_LOOPER_IDLE_TIMEOUT_MS.
+ *
+ * The kernel never decrements its count of the started threads, so the
+ * limit passed to BINDER_SET_MAX_THREADS is adjusted by the number of
+ * the spawned loopers which have already exited.
+ *
+ * Once the kernel has sent BR_SPAWN_LOOPER, it won't send another one
+ * until some thread issues BC_REGISTER_LOOPER. If the looper can't be
+ * started right away (thread creation fails or the local limit has been
+ * lowered in the meantime) the request remains pending. Failed attempts
+ * are retried after the next read, declined ones when a spawned looper
+ * exits or the limit gets raised.
+ *
+ * Normally, loopers poll the binder fd together with the exit pipe before
+ * reading each portion of commands. In the blocking mode, which can be
+ * enabled like this:
+ *
+ * [General]
+ * BlockingLoopers = true
+ *
+ * the primary loopers block right in BINDER_WRITE_READ, saving a syscall
+ * (and a wakeup) per incoming transaction. The commands queued while
+ * handling one transaction are sent to the driver together with the next
+ * read. Such loopers are kicked out of the kernel at shutdown by
+ * gbinder_driver_wakeup(). Spawned loopers always poll because they
+ * need to time out.
+ *
+ * Alternatively, there may be no loopers at all:
+ *
+ * [General]
+ * MainLoopPolling = true
+ *
+ * In that case the main thread enters the looper mode, the binder fd is
+ * watched by the main loop (see GBinderEventLoopIntegration) and all
+ * incoming commands are handled right on the main thread. That saves
+ * the thread creation, pipes and cross-thread handoffs, which is nice
+ * for small single-threaded services. Note that incoming transactions
+ * can't be blocked by gbinder_remote_request_block() in this mode, just
+ * like those received while waiting for a synchronous reply. If the
+ * event loop integration doesn't support fd watches or reading from
+ * the main thread fails, the usual loopers are started.
+ */
+#define CONF_BLOCKING_LOOPERS "BlockingLoopers"
+#define CONF_MAIN_LOOP_POLLING "MainLoopPolling"
+
+/*
+ * Collecting transaction statistics (see gbinder_ipc_get_stats) adds
+ * some work to every transaction and every ioctl, so it has to be
+ * enabled in the config. The statistics can also be fetched from the
+ * outside by sending GBINDER_STATS_TRANSACTION to any of the local
+ * objects, once that's allowed (which implies Stats = true):
+ *
+ * [General]
+ * Stats = true
+ * StatsTransaction = true
+ *
+ * Thread pool, completion queue and looper counters are always there.
+ */
+#define CONF_STATS "Stats"
+#define CONF_STATS_TRANSACTION "StatsTransaction"
 
 /*
  * When looper receives the transaction:
  *
  * 1. Finds the target object and allocates GBinderIpcLooperTx.
  * 2. Posts the GBinderIpcLooperTx reference to the main thread
- * 4. Waits for (any) byte from the receiving end of the tx pipe.
+ * 4. Waits for the completion bits to get set in GBinderIpcLooperTx.
  *
  * When the main thread receives GBinderIpcLooperTx:
  *
  * 1. Lets the object to process it and produce the response (GBinderOutput).
- * 2. Writes one byte (TX_DONE) to the sending end of the tx pipe.
+ * 2. Sets TX_DONE bit and wakes up the looper if it's sleeping.
  * 3. Unreferences GBinderIpcLooperTx
  *
- * When tx pipe wakes up the looper:
+ * The completion bits double as a futex word. The looper only goes to
+ * sleep in the kernel (and the main thread only makes the wake up call)
+ * if the transaction hasn't been completed by the time the looper starts
+ * waiting for it. There's no file descriptors involved.
+ *
+ * When the looper wakes up:
  *
  * 1. Sends the transaction to the kernel.
  * 2. Unreferences GBinderIpcLooperTx
@@ -121,13 +297,22 @@ static pthread_mutex_t gbinder_ipc_mutex = PTHREAD_MUTEX_INITIALIZER;
  * before it gets processed.
  *
  * When transaction is blocked by gbinder_remote_request_block() call, it
- * gets slightly more complicated. Then the main thread writes TX_BLOCKED
- * to the pipe (rather than TX_DONE) and then looper thread spawn another
- * looper and keeps waiting for TX_DONE.
+ * gets slightly more complicated. Then the main thread sets TX_BLOCKED
+ * (rather than TX_DONE) and then looper thread spawn another looper and
+ * keeps waiting for TX_DONE.
+ *
+ * If the object has been created with GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD
+ * then the looper handles the transaction itself and only has to wait
+ * if the transaction gets blocked.
+ *
+ * TX_CANCELLED is set by gbinder_ipc_looper_stop() to release the looper
+ * waiting for the transaction completion.
  */
 
-#define TX_DONE (0x2a)
-#define TX_BLOCKED (0x3b)
+#define TX_DONE (0x01)
+#define TX_BLOCKED (0x02)
+#define TX_CANCELLED (0x04)
+#define TX_WAITING (0x80) /* Someone is sleeping on the futex */
 
 typedef enum gbinder_ipc_looper_tx_state {
     GBINDER_IPC_LOOPER_TX_SCHEDULED,
@@ -141,14 +326,15 @@ typedef enum gbinder_ipc_looper_tx_state {
 struct gbinder_ipc_looper_tx {
     /* Reference count */
     gint refcount;
+    /* Completion bits (TX_DONE etc.), also serves as a futex word */
+    gint signal;
     /* These are filled by the looper: */
-    int pipefd[2];
     guint32 code;
     guint32 flags;
     GBinderLocalObject* obj;
     GBinderRemoteRequest* req;
-    /* And these by the main thread processing the transaction: */
-    GBINDER_IPC_LOOPER_TX_STATE state;
+    /* And these by the thread processing the transaction: */
+    gint state; /* GBINDER_IPC_LOOPER_TX_STATE */
     GBinderLocalReply* reply;
     int status;
 } /* GBinderIpcLooperTx */;
@@ -160,21 +346,19 @@ struct gbinder_ipc_looper {
     GBinderHandler handler;
     GBinderDriver* driver;
     GBinderIpc* ipc; /* Not a reference! */
+    GBinderThreadAttrPriv* thread_attr;
     pthread_t thread;
     GMutex mutex;
     GCond start_cond;
     gint exit;
     gint started;
     gint joined;
+    gboolean spawned; /* Requested by the kernel */
+    gboolean blocking; /* Doesn't poll before reading */
     int pipefd[2];
-    int txfd[2];
+    GBinderIpcLooperTx* tx; /* Protected by mutex */
 };
 
-typedef struct gbinder_ipc_tx_handler {
-    int pipefd[2];
-    int txfd[2];
-} GBinderIpcTxHandler;
-
 typedef struct gbinder_ipc_tx_priv GBinderIpcTxPriv;
 
 typedef
@@ -182,12 +366,27 @@ void
 (*GBinderIpcTxPrivFunc)(
     GBinderIpcTxPriv* tx);
 
+/*
+ * Transactions with a deadline go through these states. The state is
+ * only tracked for those, the ones without a deadline are always
+ * executed (unless cancelled) and never time out.
+ */
+enum gbinder_ipc_tx_state {
+    GBINDER_IPC_TX_QUEUED,
+    GBINDER_IPC_TX_RUNNING,
+    GBINDER_IPC_TX_FINISHED,
+    GBINDER_IPC_TX_TIMED_OUT
+};
+
 typedef struct gbinder_ipc_tx_priv {
     GBinderIpcTx pub;
     GBinderIpcTxPrivFunc fn_exec;
     GBinderIpcTxPrivFunc fn_done;
     GBinderIpcTxPrivFunc fn_free;
-    GBinderEventLoopCallback* completion;
+    GBinderIpcTxPriv* next; /* Link in the completion queue */
+    GBINDER_TX_LANE lane;
+    gint64 deadline; /* Monotonic time, zero if none */
+    gint state; /* enum gbinder_ipc_tx_state, atomic */
 } GBinderIpcTxPriv;
 
 typedef struct gbinder_ipc_tx_internal {
@@ -200,6 +399,8 @@ typedef struct gbinder_ipc_tx_internal {
     GBinderRemoteReply* reply;
     GBinderIpcReplyFunc fn_reply;
     GDestroyNotify fn_destroy;
+    GBinderEventLoopTimeout* watchdog;
+    gint64 start;
 } GBinderIpcTxInternal;
 
 typedef struct gbinder_ipc_tx_custom {
@@ -212,11 +413,17 @@ typedef struct gbinder_ipc_tx_custom {
 static
 GBinderIpcLooper*
 gbinder_ipc_looper_new(
-    GBinderIpc* ipc);
+    GBinderIpc* ipc,
+    gboolean spawned);
+
+static
+void
+gbinder_ipc_poll_setup(
+    gpointer data);
 
 static
 GBinderRemoteReply*
-gbinder_ipc_transact_sync_reply_worker(
+gbinder_ipc_transact_reply_worker(
     GBinderIpc* self,
     guint32 handle,
     guint32 code,
@@ -225,7 +432,7 @@ gbinder_ipc_transact_sync_reply_worker(
 
 static
 int
-gbinder_ipc_transact_sync_oneway_worker(
+gbinder_ipc_transact_oneway_worker(
     GBinderIpc* self,
     guint32 handle,
     guint32 code,
@@ -235,36 +442,6 @@ gbinder_ipc_transact_sync_oneway_worker(
  * Utilities
  *==========================================================================*/
 
-static
-gboolean
-gbinder_ipc_wait(
-    int fd_wakeup,
-    int fd_read,
-    guint8* out)
-{
-    struct pollfd fds[2];
-
-    memset(fds, 0, sizeof(fds));
-    fds[0].fd = fd_wakeup;
-    fds[0].events = POLLIN | POLLERR | POLLHUP | POLLNVAL;
-    fds[1].fd = fd_read;
-    fds[1].events = POLLIN | POLLERR | POLLHUP | POLLNVAL;
-    if (poll(fds, 2, -1) < 0) {
-        GWARN("Transaction pipe polling error: %s", strerror(errno));
-    } else if (fds[1].revents & POLLIN) {
-        const ssize_t n = read(fds[1].fd, out, 1);
-
-        if (n == 1) {
-            return TRUE;
-        } else if (n < 0) {
-            GWARN("Transaction pipe read error: %s", strerror(errno));
-        } else {
-            GWARN("Nothing was read from the transaction pipe");
-        }
-    }
-    return FALSE;
-}
-
 static
 char*
 gbinder_ipc_make_key(
@@ -274,6 +451,47 @@ gbinder_ipc_make_key(
     return g_strdup_printf("%s:%s", protocol, dev);
 }
 
+static
+void
+gbinder_ipc_stats_call(
+    GBinderIpc* self,
+    GBinderStatsLatency* latency,
+    gint64 start,
+    int status)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    if (priv->stats_enabled) {
+        const gint64 usec = g_get_monotonic_time() - start;
+
+        /* Lock */
+        g_mutex_lock(&priv->stats_mutex);
+        gbinder_stats_latency_add(latency, usec);
+        g_mutex_unlock(&priv->stats_mutex);
+        /* Unlock */
+
+        if (status != GBINDER_STATUS_OK) {
+            g_atomic_int_inc(&priv->failed_calls);
+        }
+    }
+}
+
+static
+void
+gbinder_ipc_stats_oneway(
+    GBinderIpc* self,
+    int status)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    if (priv->stats_enabled) {
+        g_atomic_int_inc(&priv->oneway_calls);
+        if (status != GBINDER_STATUS_OK) {
+            g_atomic_int_inc(&priv->failed_calls);
+        }
+    }
+}
+
 /*==========================================================================*
  * GBinderIpcLooperTx
  *==========================================================================*/
@@ -284,13 +502,11 @@ gbinder_ipc_looper_tx_new(
     GBinderLocalObject* obj,
     guint32 code,
     guint32 flags,
-    GBinderRemoteRequest* req,
-    const int* fd)
+    GBinderRemoteRequest* req)
 {
     GBinderIpcLooperTx* tx = g_slice_new0(GBinderIpcLooperTx);
 
     g_atomic_int_set(&tx->refcount, 1);
-    memcpy(tx->pipefd, fd, sizeof(tx->pipefd));
     tx->code = code;
     tx->flags = flags;
     tx->obj = gbinder_local_object_ref(obj);
@@ -303,10 +519,6 @@ void
 gbinder_ipc_looper_tx_free(
     GBinderIpcLooperTx* tx)
 {
-    if (tx->pipefd[0] >= 0) {
-        close(tx->pipefd[0]);
-        close(tx->pipefd[1]);
-    }
     gbinder_local_object_unref(tx->obj);
     gbinder_remote_request_unref(tx->req);
     gbinder_local_reply_unref(tx->reply);
@@ -324,26 +536,166 @@ gbinder_ipc_looper_tx_ref(
 }
 
 static
-gboolean
+void
 gbinder_ipc_looper_tx_unref(
-    GBinderIpcLooperTx* tx,
-    gboolean dropfd)
+    GBinderIpcLooperTx* tx)
 {
-    gboolean dropped = FALSE;
     GASSERT(tx->refcount > 0);
     if (g_atomic_int_dec_and_test(&tx->refcount)) {
-        if (dropfd) {
-            tx->pipefd[0] = tx->pipefd[1] = -1;
-            dropped = TRUE;
-        }
         gbinder_ipc_looper_tx_free(tx);
     }
-    return dropped;
+}
+
+static
+void
+gbinder_ipc_looper_tx_notify(
+    GBinderIpcLooperTx* tx,
+    guint bit)
+{
+    /* Only make a syscall if the other side is actually sleeping */
+    if (g_atomic_int_or((guint*)&tx->signal, bit) & TX_WAITING) {
+        syscall(SYS_futex, &tx->signal, FUTEX_WAKE_PRIVATE, INT_MAX,
+            NULL, NULL, 0);
+    }
+}
+
+/*
+ * Waits until any of the bits in the mask gets set. Returns TX_DONE,
+ * TX_BLOCKED or zero if the wait has been cancelled.
+ *
+ * The wait may take as long as the main loop or the blocked transaction
+ * takes, so the commands queued by this thread so far (BC_FREE_BUFFER,
+ * BC_*_DONE, BC_DECREFS and such) are sent to the driver first. Holding
+ * BC_FREE_BUFFER for a oneway buffer would stall the async queue of the
+ * node in the kernel.
+ */
+static
+guint
+gbinder_ipc_looper_tx_wait(
+    GBinderIpcLooperTx* tx,
+    guint mask)
+{
+    gint val;
+
+    if (!(g_atomic_int_get(&tx->signal) & mask)) {
+        gbinder_driver_flush(tx->obj->ipc->driver);
+    }
+    while (!((val = g_atomic_int_get(&tx->signal)) & mask)) {
+        if ((val & TX_WAITING) ||
+            g_atomic_int_compare_and_exchange(&tx->signal, val,
+                val | TX_WAITING)) {
+            /* EINTR and EAGAIN are handled by re-checking the value */
+            syscall(SYS_futex, &tx->signal, FUTEX_WAIT_PRIVATE,
+                val | TX_WAITING, NULL, NULL, 0);
+        }
+    }
+
+    /* TX_DONE takes precedence */
+    val &= mask;
+    return (val & TX_DONE) ? TX_DONE : (val & TX_BLOCKED);
+}
+
+/*
+ * Invokes the handler and returns TX_DONE or TX_BLOCKED. If notify is TRUE,
+ * the same bit is signaled to wake up the looper waiting for the main
+ * thread.
+ */
+static
+guint
+gbinder_ipc_looper_tx_process(
+    GBinderIpcLooperTx* tx,
+    gboolean notify)
+{
+    GBinderRemoteRequest* req = tx->req;
+    GBinderLocalReply* reply;
+    int status = GBINDER_STATUS_OK;
+    guint done = TX_DONE;
+
+    /*
+     * Transaction reference for gbinder_remote_request_block()
+     * and gbinder_remote_request_complete().
+     */
+    req->tx = gbinder_ipc_looper_tx_ref(tx);
+
+    /* See state machine */
+    GASSERT(tx->state == GBINDER_IPC_LOOPER_TX_SCHEDULED);
+    g_atomic_int_set(&tx->state, GBINDER_IPC_LOOPER_TX_PROCESSING);
+
+    /* Actually handle the transaction */
+    reply = gbinder_local_object_handle_transaction(tx->obj, req,
+        tx->code, tx->flags, &status);
+
+    /* Handle all possible return states */
+    switch (g_atomic_int_get(&tx->state)) {
+    case GBINDER_IPC_LOOPER_TX_PROCESSING:
+        /* Result was returned by the handler */
+        tx->reply = reply;
+        tx->status = status;
+        g_atomic_int_set(&tx->state, GBINDER_IPC_LOOPER_TX_COMPLETE);
+        reply = NULL;
+        break;
+    case GBINDER_IPC_LOOPER_TX_PROCESSED:
+        /* Result has been provided to gbinder_remote_request_complete() */
+        g_atomic_int_set(&tx->state, GBINDER_IPC_LOOPER_TX_COMPLETE);
+        break;
+    case GBINDER_IPC_LOOPER_TX_BLOCKING:
+        /*
+         * Result will be provided to gbinder_remote_request_complete()
+         * which may be called on another thread at any moment. TX_BLOCKED
+         * must be set before TX_DONE, hence the order.
+         */
+        if (notify) {
+            gbinder_ipc_looper_tx_notify(tx, TX_BLOCKED);
+        }
+        if (g_atomic_int_compare_and_exchange(&tx->state,
+            GBINDER_IPC_LOOPER_TX_BLOCKING,
+            GBINDER_IPC_LOOPER_TX_BLOCKED)) {
+            done = TX_BLOCKED;
+        } else {
+            /* Completed in the meantime */
+            g_atomic_int_set(&tx->state, GBINDER_IPC_LOOPER_TX_COMPLETE);
+        }
+        break;
+    default:
+        break;
+    }
+
+    /* In case handler returns a reply which it wasn't expected to return */
+    GASSERT(!reply);
+    gbinder_local_reply_unref(reply);
+
+    /* Drop the transaction reference unless blocked */
+    if (done == TX_BLOCKED) {
+        /*
+         * From this point on, it's GBinderRemoteRequest who's holding
+         * reference to GBinderIpcLooperTx, not the other way around and
+         * not both ways. Even if gbinder_remote_request_complete() never
+         * gets called, transaction will still be completed when the last
+         * reference to GBinderRemoteRequest goes away. And if request
+         * never gets deallocated... oh well.
+         */
+        gbinder_remote_request_unref(tx->req);
+        tx->req = NULL;
+    } else {
+        GBinderIpcLooperTx* ref = g_atomic_pointer_get(&req->tx);
+
+        if (ref && g_atomic_pointer_compare_and_exchange(&req->tx, ref,
+            NULL)) {
+            gbinder_ipc_looper_tx_unref(ref);
+        }
+        if (notify) {
+            /* And wake up the looper */
+            gbinder_ipc_looper_tx_notify(tx, TX_DONE);
+        }
+    }
+    return done;
 }
 
 /*==========================================================================*
- * State machine of transaction handling. All this is happening on the event
- * thread and therefore doesn't need to be synchronized.
+ * State machine of transaction handling. Normally, all this is happening
+ * on the event thread. If the handler is invoked on the looper thread,
+ * gbinder_remote_request_complete() may be called on yet another thread,
+ * that's why the state is updated atomically.
  *
  * SCHEDULED
  * =========
@@ -379,9 +731,10 @@ gbinder_remote_request_block(
         GASSERT(tx);
         if (G_LIKELY(tx)) {
             GASSERT(tx->state == GBINDER_IPC_LOOPER_TX_PROCESSING);
-            if (tx->state == GBINDER_IPC_LOOPER_TX_PROCESSING) {
-                tx->state = GBINDER_IPC_LOOPER_TX_BLOCKING;
-            }
+            /* No effect if the state is wrong */
+            (void) g_atomic_int_compare_and_exchange(&tx->state,
+                GBINDER_IPC_LOOPER_TX_PROCESSING,
+                GBINDER_IPC_LOOPER_TX_BLOCKING);
         }
     }
 }
@@ -393,37 +746,35 @@ gbinder_remote_request_complete(
     int status) /* Since 1.0.20 */
 {
     if (G_LIKELY(req)) {
-        GBinderIpcLooperTx* tx = req->tx;
+        GBinderIpcLooperTx* tx = g_atomic_pointer_get(&req->tx);
 
         GASSERT(tx);
-        if (G_LIKELY(tx)) {
-            const guint8 done = TX_DONE;
+        /* Whoever clears req->tx takes over the transaction reference */
+        if (G_LIKELY(tx) &&
+            g_atomic_pointer_compare_and_exchange(&req->tx, tx, NULL)) {
+            const int state = g_atomic_int_get(&tx->state);
 
-            switch (tx->state) {
-            case GBINDER_IPC_LOOPER_TX_BLOCKING:
-                /* Called by the transaction handler */
-                tx->status = status;
-                tx->reply = gbinder_local_reply_ref(reply);
-                tx->state = GBINDER_IPC_LOOPER_TX_PROCESSED;
-                break;
-            case GBINDER_IPC_LOOPER_TX_BLOCKED:
-                /* Really asynchronous completion */
+            if (state == GBINDER_IPC_LOOPER_TX_BLOCKING ||
+                state == GBINDER_IPC_LOOPER_TX_BLOCKED) {
                 tx->status = status;
                 tx->reply = gbinder_local_reply_ref(reply);
-                tx->state = GBINDER_IPC_LOOPER_TX_COMPLETE;
-                /* Wake up the looper */
-                if (write(tx->pipefd[1], &done, sizeof(done)) <= 0) {
-                    GWARN("Failed to wake up the looper");
+                if (!g_atomic_int_compare_and_exchange(&tx->state,
+                    GBINDER_IPC_LOOPER_TX_BLOCKING,
+                    GBINDER_IPC_LOOPER_TX_PROCESSED)) {
+                    /* Really asynchronous completion */
+                    GASSERT(tx->state == GBINDER_IPC_LOOPER_TX_BLOCKED);
+                    g_atomic_int_set(&tx->state,
+                        GBINDER_IPC_LOOPER_TX_COMPLETE);
+                    /* Wake up the looper */
+                    gbinder_ipc_looper_tx_notify(tx, TX_DONE);
                 }
-                break;
-            default:
-                GWARN("Unexpected state %d in request completion", tx->state);
-                break;
+                /* Otherwise it's called by the transaction handler */
+            } else {
+                GWARN("Unexpected state %d in request completion", state);
             }
 
-            /* Clear the transaction reference */
-            gbinder_ipc_looper_tx_unref(tx, FALSE);
-            req->tx = NULL;
+            /* Drop the transaction reference */
+            gbinder_ipc_looper_tx_unref(tx);
        }
     }
 }
@@ -442,11 +793,8 @@ gbinder_ipc_looper_free(
     }
     close(looper->pipefd[0]);
     close(looper->pipefd[1]);
-    if (looper->txfd[0] >= 0) {
-        close(looper->txfd[0]);
-        close(looper->txfd[1]);
-    }
     gbinder_driver_unref(looper->driver);
+    gbinder_thread_attr_unref(looper->thread_attr);
     g_free(looper->name);
     g_cond_clear(&looper->start_cond);
     g_mutex_clear(&looper->mutex);
@@ -479,76 +827,7 @@ void
 gbinder_ipc_looper_tx_handle(
     gpointer data)
 {
-    GBinderIpcLooperTx* tx = data;
-    GBinderRemoteRequest* req = tx->req;
-    GBinderLocalReply* reply;
-    int status = GBINDER_STATUS_OK;
-    guint8 done;
-
-    /*
-     * Transaction reference for gbinder_remote_request_block()
-     * and gbinder_remote_request_complete().
-     */
-    req->tx = gbinder_ipc_looper_tx_ref(tx);
-
-    /* See state machine */
-    GASSERT(tx->state == GBINDER_IPC_LOOPER_TX_SCHEDULED);
-    tx->state = GBINDER_IPC_LOOPER_TX_PROCESSING;
-
-    /* Actually handle the transaction */
-    reply = gbinder_local_object_handle_transaction(tx->obj, req,
-        tx->code, tx->flags, &status);
-
-    /* Handle all possible return states */
-    switch (tx->state) {
-    case GBINDER_IPC_LOOPER_TX_PROCESSING:
-        /* Result was returned by the handler */
-        tx->reply = reply;
-        tx->status = status;
-        tx->state = GBINDER_IPC_LOOPER_TX_COMPLETE;
-        reply = NULL;
-        break;
-    case GBINDER_IPC_LOOPER_TX_PROCESSED:
-        /* Result has been provided to gbinder_remote_request_complete() */
-        tx->state = GBINDER_IPC_LOOPER_TX_COMPLETE;
-        break;
-    case GBINDER_IPC_LOOPER_TX_BLOCKING:
-        /* Result will be provided to gbinder_remote_request_complete() */
-        tx->state = GBINDER_IPC_LOOPER_TX_BLOCKED;
-        break;
-    default:
-        break;
-    }
-
-    /* In case handler returns a reply which it wasn't expected to return */
-    GASSERT(!reply);
-    gbinder_local_reply_unref(reply);
-
-    /* Drop the transaction reference unless blocked */
-    if (tx->state == GBINDER_IPC_LOOPER_TX_BLOCKED) {
-        done = TX_BLOCKED;
-        /*
-         * From this point on, it's GBinderRemoteRequest who's holding
-         * reference to GBinderIpcLooperTx, not the other way around and
-         * not both ways. Even if gbinder_remote_request_complete() never
-         * gets called, transaction will still be completed when the last
-         * reference to GBinderRemoteRequest goes away. And if request
-         * never gets deallocated... oh well.
-         */
-        gbinder_remote_request_unref(tx->req);
-        tx->req = NULL;
-    } else {
-        done = TX_DONE;
-        if (req->tx) {
-            gbinder_ipc_looper_tx_unref(req->tx, FALSE);
-            req->tx = NULL;
-        }
-    }
-
-    /* And wake up the looper */
-    if (write(tx->pipefd[1], &done, sizeof(done)) <= 0) {
-        GWARN("Failed to wake up the looper");
-    }
+    gbinder_ipc_looper_tx_process((GBinderIpcLooperTx*)data, TRUE);
 }
 
 static
@@ -556,7 +835,7 @@ void
 gbinder_ipc_looper_tx_done(
     gpointer data)
 {
-    gbinder_ipc_looper_tx_unref(data, FALSE);
+    gbinder_ipc_looper_tx_unref(data);
 }
 
 static
@@ -646,126 +925,297 @@ gbinder_ipc_looper_can_loop(
     return !g_atomic_int_get(&looper->exit);
 }
 
+/*
+ * Same as gbinder_ipc_looper_tx_wait() but also returns zero when
+ * the looper is requested to exit.
+ */
+static
+guint
+gbinder_ipc_looper_wait(
+    GBinderIpcLooper* looper,
+    GBinderIpcLooperTx* tx,
+    guint mask)
+{
+    guint done = 0;
+
+    /* Lock */
+    g_mutex_lock(&looper->mutex);
+    looper->tx = tx;
+    g_mutex_unlock(&looper->mutex);
+    /* Unlock */
+
+    /* gbinder_ipc_looper_stop() sets the exit flag before locking */
+    if (!g_atomic_int_get(&looper->exit)) {
+        done = gbinder_ipc_looper_tx_wait(tx, mask | TX_CANCELLED);
+    }
+
+    /* Lock */
+    g_mutex_lock(&looper->mutex);
+    looper->tx = NULL;
+    g_mutex_unlock(&looper->mutex);
+    /* Unlock */
+    return done;
+}
+
 static
 GBinderLocalReply*
-gbinder_ipc_looper_transact(
-    GBinderHandler* handler,
+gbinder_ipc_looper_transact_impl(
+    GBinderIpcLooper* looper,
     GBinderLocalObject* obj,
     GBinderRemoteRequest* req,
     guint code,
     guint flags,
+    gboolean direct,
     int* result)
 {
-    GBinderIpcLooper* looper = G_CAST(handler,GBinderIpcLooper,handler);
     GBinderIpc* ipc = looper->ipc;
     GBinderLocalReply* reply = NULL;
     int status = -EFAULT;
+    GBinderIpcLooperTx* tx = gbinder_ipc_looper_tx_new(obj, code, flags, req);
+    GBinderIpcPriv* priv = ipc->priv;
+    GBinderEventLoopCallback* callback = NULL;
+    guint done;
+    gboolean was_blocked = FALSE;
+
+    GBINDER_PROBE4(looper_tx_start, obj, code, flags, direct);
+    if (direct) {
+        /* Invoke the handler right here, on the looper thread */
+        done = gbinder_ipc_looper_tx_process(tx, FALSE);
+    } else {
+        /* Let GBinderLocalObject handle it on the main thread */
+        callback = gbinder_idle_callback_schedule_new
+            (gbinder_ipc_looper_tx_handle, gbinder_ipc_looper_tx_ref(tx),
+                gbinder_ipc_looper_tx_done);
 
-    if (looper->txfd[0] < 0 && pipe(looper->txfd)) {
-        GERR("Failed to create a tx pipe: %s", strerror(errno));
+        /* Wait for either transaction completion or looper shutdown */
+        done = gbinder_ipc_looper_wait(looper, tx, TX_DONE | TX_BLOCKED);
     }
 
-    if (looper->txfd[0] >= 0) {
-        GBinderIpcLooperTx* tx = gbinder_ipc_looper_tx_new(obj, code, flags,
-            req, looper->txfd);
-        GBinderIpcPriv* priv = ipc->priv;
-        guint8 done = 0;
-        gboolean was_blocked = FALSE;
-        /* Let GBinderLocalObject handle the transaction on the main thread */
-        GBinderEventLoopCallback* callback =
-            gbinder_idle_callback_schedule_new(gbinder_ipc_looper_tx_handle,
-                gbinder_ipc_looper_tx_ref(tx), gbinder_ipc_looper_tx_done);
-
-        /* Wait for either transaction completion or looper shutdown */
-        if (gbinder_ipc_wait(looper->pipefd[0], tx->pipefd[0], &done) &&
-            done == TX_BLOCKED) {
-            /*
-             * We are going to block this looper for potentially
-             * significant period of time. Start new looper to
-             * accept normal incoming requests and terminate this
-             * one when we are done with this transaction.
-             *
-             * For the duration of the transaction, this looper is
-             * moved to the blocked_loopers list.
-             */
-            GBinderIpcPriv* priv = looper->ipc->priv;
-            GBinderIpcLooper* new_looper = NULL;
+    if (done == TX_BLOCKED) {
+        /*
+         * We are going to block this looper for potentially
+         * significant period of time. Start new looper to
+         * accept normal incoming requests and terminate this
+         * one when we are done with this transaction.
+         *
+         * For the duration of the transaction, this looper is
+         * moved to the blocked_loopers list.
+         */
+        GBinderIpcPriv* priv = looper->ipc->priv;
+        GBinderIpcLooper* new_looper = NULL;
 
-            /* Lock */
-            g_mutex_lock(&priv->looper_mutex);
-            if (gbinder_ipc_looper_remove_primary(looper)) {
-                GVERBOSE("Primary looper %s is blocked", looper->name);
-                looper->next = priv->blocked_loopers;
-                priv->blocked_loopers = looper;
-                was_blocked = TRUE;
-
-                /* If there's no more primary loopers left, create one */
-                if (!priv->primary_loopers) {
-                    new_looper = gbinder_ipc_looper_new(ipc);
-                    if (new_looper) {
-                        /* Will unref it after it gets started */
-                        gbinder_ipc_looper_ref(new_looper);
-                        priv->primary_loopers = new_looper;
-                    }
+        /* Lock */
+        g_mutex_lock(&priv->looper_mutex);
+        if (gbinder_ipc_looper_remove_primary(looper)) {
+            GVERBOSE("Primary looper %s is blocked", looper->name);
+            looper->next = priv->blocked_loopers;
+            priv->blocked_loopers = looper;
+            was_blocked = TRUE;
+
+            /* If there's no more primary loopers left, create one */
+            if (!priv->primary_loopers) {
+                new_looper = gbinder_ipc_looper_new(ipc, FALSE);
+                if (new_looper) {
+                    /* Will unref it after it gets started */
+                    gbinder_ipc_looper_ref(new_looper);
+                    priv->primary_loopers = new_looper;
                 }
             }
-            g_mutex_unlock(&priv->looper_mutex);
-            /* Unlock */
-
-            if (new_looper) {
-                /* Wait until it gets started */
-                gbinder_ipc_looper_start(new_looper);
-                gbinder_ipc_looper_unref(new_looper);
-            }
+        }
+        g_mutex_unlock(&priv->looper_mutex);
+        /* Unlock */
 
-            /* Block until asynchronous transaction gets completed. */
-            done = 0;
-            if (gbinder_ipc_wait(looper->pipefd[0], tx->pipefd[0], &done)) {
-                GVERBOSE("Looper %s is released", looper->name);
-                GASSERT(done == TX_DONE);
-            }
+        if (new_looper) {
+            /* Wait until it gets started */
+            gbinder_ipc_looper_start(new_looper);
+            gbinder_ipc_looper_unref(new_looper);
         }
 
+        /* Block until asynchronous transaction gets completed. */
+        done = gbinder_ipc_looper_wait(looper, tx, TX_DONE);
         if (done) {
-            GASSERT(done == TX_DONE);
-            reply = gbinder_local_reply_ref(tx->reply);
-            status = tx->status;
+            GVERBOSE("Looper %s is released", looper->name);
         }
+    }
 
-        if (!gbinder_ipc_looper_tx_unref(tx, TRUE)) {
-            /*
-             * This wasn't the last reference meaning that
-             * gbinder_ipc_looper_tx_free() will close the
-             * descriptors and we will have to create a new
-             * pipe for the next transaction.
-             */
-            looper->txfd[0] = looper->txfd[1] = -1;
-        }
+    if (done) {
+        GASSERT(done == TX_DONE);
+        reply = gbinder_local_reply_ref(tx->reply);
+        status = tx->status;
+    }
 
-        gbinder_idle_callback_destroy(callback);
+    gbinder_ipc_looper_tx_unref(tx);
+    gbinder_idle_callback_destroy(callback);
 
-        if (was_blocked) {
-            guint n;
+    if (was_blocked) {
+        guint n;
 
-            g_mutex_lock(&priv->looper_mutex);
-            n = gbinder_ipc_looper_count_primary(looper);
-            if (n >= GBINDER_IPC_MAX_PRIMARY_LOOPERS) {
-                /* Looper will exit once transaction completes */
-                GDEBUG("Too many primary loopers (%u)", n);
-                g_atomic_int_set(&looper->exit, 1);
-            } else {
-                /* Move it back to the primary list */
-                gbinder_ipc_looper_remove_blocked(looper);
-                looper->next = priv->primary_loopers;
-                priv->primary_loopers = looper;
-            }
-            g_mutex_unlock(&priv->looper_mutex);
+        g_mutex_lock(&priv->looper_mutex);
+        n = gbinder_ipc_looper_count_primary(looper);
+        if (n >= GBINDER_IPC_MAX_PRIMARY_LOOPERS) {
+            /* Looper will exit once transaction completes */
+            GDEBUG("Too many primary loopers (%u)", n);
+            g_atomic_int_set(&looper->exit, 1);
+        } else {
+            /* Move it back to the primary list */
+            gbinder_ipc_looper_remove_blocked(looper);
+            looper->next = priv->primary_loopers;
+            priv->primary_loopers = looper;
         }
+        g_mutex_unlock(&priv->looper_mutex);
     }
+    GBINDER_PROBE4(looper_tx_done, obj, code, status, was_blocked);
     *result = status;
     return reply;
 }
 
+static
+GBinderLocalReply*
+gbinder_ipc_looper_transact(
+    GBinderHandler* handler,
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* result)
+{
+    return gbinder_ipc_looper_transact_impl(G_CAST(handler,
+        GBinderIpcLooper, handler), obj, req, code, flags, FALSE, result);
+}
+
+static
+GBinderLocalReply*
+gbinder_ipc_looper_transact_direct(
+    GBinderHandler* handler,
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* result)
+{
+    return gbinder_ipc_looper_transact_impl(G_CAST(handler,
+        GBinderIpcLooper, handler), obj, req, code, flags, TRUE, result);
+}
+
+static
+void
+gbinder_ipc_looper_spawn_locked(
+    GBinderIpc* ipc)
+{
+    GBinderIpcPriv* priv = ipc->priv;
+
+    if (priv->spawned_loopers < priv->max_spawned_loopers) {
+        GBinderIpcLooper* new_looper = gbinder_ipc_looper_new(ipc, TRUE);
+
+        if (new_looper) {
+            /* No need to wait until it gets started */
+            priv->spawned_loopers++;
+            priv->spawn_pending = FALSE;
+            g_atomic_int_set(&priv->spawn_failed, FALSE);
+            new_looper->next = priv->primary_loopers;
+            priv->primary_loopers = new_looper;
+        } else {
+            /* Retry after the next read */
+            g_atomic_int_set(&priv->spawn_failed, TRUE);
+        }
+    } else {
+        GDEBUG("Too many spawned loopers (%u), deferring",
+            priv->spawned_loopers);
+    }
+}
+
+static
+void
+gbinder_ipc_looper_spawn(
+    GBinderHandler* handler)
+{
+    GBinderIpcLooper* looper = G_CAST(handler, GBinderIpcLooper, handler);
+    GBinderIpcPriv* priv = looper->ipc->priv;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    priv->spawn_pending = TRUE;
+    gbinder_ipc_looper_spawn_locked(looper->ipc);
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
+}
+
+static
+void
+gbinder_ipc_looper_spawn_retry(
+    GBinderIpc* ipc)
+{
+    GBinderIpcPriv* priv = ipc->priv;
+
+    if (g_atomic_int_get(&priv->spawn_failed)) {
+        /* Lock */
+        g_mutex_lock(&priv->looper_mutex);
+        if (priv->spawn_pending) {
+            GDEBUG("Retrying to spawn a looper");
+            gbinder_ipc_looper_spawn_locked(ipc);
+        }
+        g_mutex_unlock(&priv->looper_mutex);
+        /* Unlock */
+    }
+}
+
+static
+void
+gbinder_ipc_looper_update_max_threads_locked(
+    GBinderIpc* ipc)
+{
+    GBinderIpcPriv* priv = ipc->priv;
+
+    gbinder_driver_set_max_threads(ipc->driver, priv->max_spawned_loopers ?
+        (priv->max_spawned_loopers + priv->retired_loopers) : 0);
+}
+
+static
+gboolean
+gbinder_ipc_looper_retire(
+    GBinderIpcLooper* looper)
+{
+    GBinderIpcPriv* priv = looper->ipc->priv;
+    gboolean retired = FALSE;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    /* Always keep at least one primary looper */
+    if (gbinder_ipc_looper_count_primary(looper) > 1 &&
+        gbinder_ipc_looper_remove_primary(looper)) {
+        GDEBUG("Looper %s is idle", looper->name);
+        retired = TRUE;
+    }
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
+    return retired;
+}
+
+static
+int
+gbinder_ipc_looper_read(
+    GBinderIpcLooper* looper)
+{
+    /*
+     * No need to synchronize access to looper->ipc because the other
+     * thread would wait until this thread exits before setting
+     * looper->ipc to NULL.
+     */
+    GBinderIpc* ipc = gbinder_ipc_ref(looper->ipc);
+    GBinderObjectRegistry* reg = gbinder_ipc_object_registry(ipc);
+    /* But that gbinder_driver_read() may unref GBinderIpc */
+    int ret = gbinder_driver_read(looper->driver, reg, &looper->handler);
+
+    gbinder_ipc_looper_spawn_retry(ipc);
+    /* And this gbinder_ipc_unref() may release the last ref: */
+    gbinder_ipc_unref(ipc);
+    /* And at this point looper->ipc may be NULL */
+    if (ret < 0) {
+        GDEBUG("Looper %s failed", looper->name);
+    }
+    return ret;
+}
+
 static
 gpointer
 gbinder_ipc_looper_thread(
@@ -776,7 +1226,13 @@ gbinder_ipc_looper_thread(
 
     g_mutex_lock(&looper->mutex);
     pthread_setname_np(looper->thread, looper->name);
-    if (gbinder_driver_enter_looper(driver)) {
+    gbinder_thread_attr_apply(looper->thread_attr);
+    if (looper->spawned ? gbinder_driver_register_looper(driver) :
+        gbinder_driver_enter_looper(driver)) {
+        /* Spawned loopers don't stick around for too long */
+        const int timeout = looper->spawned ?
+            GBINDER_IPC_LOOPER_IDLE_TIMEOUT_MS : -1;
+        gboolean retired = FALSE;
         struct pollfd pipefd;
         int res;
 
@@ -785,41 +1241,49 @@ gbinder_ipc_looper_thread(
         g_cond_broadcast(&looper->start_cond);
         g_mutex_unlock(&looper->mutex);
 
-        memset(&pipefd, 0, sizeof(pipefd));
-        pipefd.fd = looper->pipefd[0]; /* read end of the pipe */
-        pipefd.events = POLLIN | POLLERR | POLLHUP | POLLNVAL;
-
-        res = gbinder_driver_poll(driver, &pipefd);
-        while (!g_atomic_int_get(&looper->exit) && ((res & POLLIN) || !res)) {
-            if (res & POLLIN) {
-                /*
-                 * No need to synchronize access to looper->ipc because
-                 * the other thread would wait until this thread exits
-                 * before setting looper->ipc to NULL.
-                 */
-                GBinderIpc* ipc = gbinder_ipc_ref(looper->ipc);
-                GBinderObjectRegistry* reg = gbinder_ipc_object_registry(ipc);
-                /* But that gbinder_driver_read() may unref GBinderIpc */
-                int ret = gbinder_driver_read(driver, reg, &looper->handler);
-
-                /* And this gbinder_ipc_unref() may release the last ref: */
-                gbinder_ipc_unref(ipc);
-                /* And at this point looper->ipc may be NULL */
-                if (ret < 0) {
-                    GDEBUG("Looper %s failed", looper->name);
+        if (looper->blocking) {
+            const gboolean queue = gbinder_driver_out_begin(driver);
+
+            while (!g_atomic_int_get(&looper->exit)) {
+                if (gbinder_ipc_looper_read(looper) < 0) {
                     break;
                 }
             }
-            /* Any event from this pipe terminates the loop */
-            if (pipefd.revents || g_atomic_int_get(&looper->exit)) {
-                GDEBUG("Looper %s is requested to exit", looper->name);
-                break;
+            gbinder_driver_out_end(driver, queue);
+        } else {
+            memset(&pipefd, 0, sizeof(pipefd));
+            pipefd.fd = looper->pipefd[0]; /* read end of the pipe */
+            pipefd.events = POLLIN | POLLERR | POLLHUP | POLLNVAL;
+
+            res = gbinder_driver_poll2(driver, &pipefd, timeout);
+            while (!g_atomic_int_get(&looper->exit) &&
+                ((res & POLLIN) || !res)) {
+                if (res & POLLIN) {
+                    if (gbinder_ipc_looper_read(looper) < 0) {
+                        break;
+                    }
+                } else if (!res && gbinder_ipc_looper_retire(looper)) {
+                    /* Timed out waiting for something to happen */
+                    retired = TRUE;
+                    break;
+                }
+                /* Any event from this pipe terminates the loop */
+                if (pipefd.revents || g_atomic_int_get(&looper->exit)) {
+                    GDEBUG("Looper %s is requested to exit", looper->name);
+                    break;
+                }
+                res = gbinder_driver_poll2(driver, &pipefd, timeout);
             }
-            res = gbinder_driver_poll(driver, &pipefd);
         }
 
         gbinder_driver_exit_looper(driver);
 
+        /*
+         * The thread is about to exit, don't leave its kernel state behind
+         * (spawned loopers come and go under bursty load).
+         */
+        gbinder_driver_thread_exit(driver);
+
         /*
          * Again, there's no need to synchronize access to looper->ipc
          * because the other thread would wait until this thread exits
@@ -830,10 +1294,20 @@ gbinder_ipc_looper_thread(
 
             /* Lock */
             g_mutex_lock(&priv->looper_mutex);
-            if (gbinder_ipc_looper_remove_blocked(looper) ||
+            if (retired ||
+                gbinder_ipc_looper_remove_blocked(looper) ||
                 gbinder_ipc_looper_remove_primary(looper)) {
                 /* Spontaneous exit */
                 GDEBUG("Looper %s exits", looper->name);
+                if (looper->spawned) {
+                    priv->spawned_loopers--;
+                    priv->retired_loopers++;
+                    gbinder_ipc_looper_update_max_threads_locked(looper->ipc);
+                    if (priv->spawn_pending) {
+                        /* The slot has been freed */
+                        gbinder_ipc_looper_spawn_locked(looper->ipc);
+                    }
+                }
                 gbinder_ipc_looper_unref(looper);
             } else {
                 /* Main thread is shutting it down */
@@ -857,7 +1331,8 @@ gbinder_ipc_looper_thread(
 static
 GBinderIpcLooper*
 gbinder_ipc_looper_new(
-    GBinderIpc* ipc)
+    GBinderIpc* ipc,
+    gboolean spawned)
 {
     int fd[2];
 
@@ -865,24 +1340,44 @@ gbinder_ipc_looper_new(
     if (!pipe(fd)) {
         static const GBinderHandlerFunctions handler_functions = {
             .can_loop = gbinder_ipc_looper_can_loop,
-            .transact = gbinder_ipc_looper_transact
+            .transact = gbinder_ipc_looper_transact,
+            .transact_direct = gbinder_ipc_looper_transact_direct,
+            .spawn_looper = gbinder_ipc_looper_spawn
         };
         GBinderIpcLooper* looper = g_slice_new0(GBinderIpcLooper);
+        GBinderIpcPriv* priv = ipc->priv;
         static gint gbinder_ipc_next_looper_id = 1;
         guint id = (guint)g_atomic_int_add(&gbinder_ipc_next_looper_id, 1);
+        pthread_attr_t attr;
+        gboolean have_attr;
+        int err;
 
         memcpy(looper->pipefd, fd, sizeof(fd));
-        looper->txfd[0] = looper->txfd[1] = -1;
         g_atomic_int_set(&looper->refcount, 1);
         g_cond_init(&looper->start_cond);
         g_mutex_init(&looper->mutex);
         g_mutex_lock(&looper->mutex);
         looper->name = g_strdup_printf("%s#%u", gbinder_ipc_name(ipc), id);
         looper->handler.f = &handler_functions;
+        looper->spawned = spawned;
+        looper->blocking = !spawned && ipc->priv->blocking_loopers;
         looper->ipc = ipc;
         looper->driver = gbinder_driver_ref(ipc->driver);
-        if (!pthread_create(&looper->thread, NULL, gbinder_ipc_looper_thread,
-            looper)) {
+
+        /* Lock */
+        g_mutex_lock(&priv->tx_pool_mutex);
+        looper->thread_attr = gbinder_thread_attr_ref(priv->thread_attr);
+        g_mutex_unlock(&priv->tx_pool_mutex);
+        /* Unlock */
+
+        have_attr = gbinder_thread_attr_init_pthread(looper->thread_attr,
+            &attr);
+        err = pthread_create(&looper->thread, have_attr ? &attr : NULL,
+            gbinder_ipc_looper_thread, looper);
+        if (have_attr) {
+            pthread_attr_destroy(&attr);
+        }
+        if (!err) {
             /* gbinder_ipc_looper_thread() will release this reference: */
             gbinder_ipc_looper_ref(looper);
             g_mutex_unlock(&looper->mutex);
@@ -909,8 +1404,14 @@ gbinder_ipc_looper_check(
 
         /* Lock */
         g_mutex_lock(&priv->looper_mutex);
-        if (!priv->primary_loopers) {
-            priv->primary_loopers = gbinder_ipc_looper_new(self);
+        if (priv->main_loop_polling) {
+            /* BC_ENTER_LOOPER has to be issued by the main thread */
+            if (!priv->poll_setup && !priv->poll_watch) {
+                priv->poll_setup = gbinder_idle_callback_schedule_new(
+                    gbinder_ipc_poll_setup, self, NULL);
+            }
+        } else if (!priv->primary_loopers) {
+            priv->primary_loopers = gbinder_ipc_looper_new(self, FALSE);
             new_looper = priv->primary_loopers;
             if (new_looper) {
                 gbinder_ipc_looper_ref(new_looper);
@@ -940,9 +1441,19 @@ gbinder_ipc_looper_stop(
         if (looper->thread != pthread_self()) {
             guint8 done = TX_DONE;
 
-            if (write(looper->pipefd[1], &done, sizeof(done)) <= 0) {
+            if (looper->blocking) {
+                /* It's (most likely) sitting in BINDER_WRITE_READ */
+                gbinder_driver_wakeup(looper->driver);
+            } else if (write(looper->pipefd[1], &done, sizeof(done)) <= 0) {
                 GWARN("Failed to stop looper %s", looper->name);
             }
+
+            /* Release the looper if it's waiting for a transaction */
+            g_mutex_lock(&looper->mutex);
+            if (looper->tx) {
+                gbinder_ipc_looper_tx_notify(looper->tx, TX_CANCELLED);
+            }
+            g_mutex_unlock(&looper->mutex);
         }
     }
 }
@@ -1005,134 +1516,330 @@ gbinder_ipc_looper_join(
     looper->ipc = NULL;
 }
 
-/*==========================================================================*
- * GBinderIpcTxHandler
- *
- * It's needed to handle the following scenario:
- *
- * 1. Asynchronous call is made. The actual transaction is performed on
- *    gbinder_ipc_tx_proc thread.
- * 2. While we were are waiting for completion of our transaction, we
- *    receive a valid incoming transation.
- * 3. This transaction is handled by gbinder_ipc_tx_handler_transact.
- *
- * This seems to be quite a rare scenario, so we allocate a new
- * GBinderIpcTxHandler (and new pipes) for each such transaction,
- * to keep things as simple as possible.
- *
- *==========================================================================*/
+/*==========================================================================*
+ * Main loop polling
+ *==========================================================================*/
+
+static
+void
+gbinder_ipc_poll_proc(
+    gpointer data)
+{
+    /* Handlers may drop the last reference */
+    GBinderIpc* self = gbinder_ipc_ref(THIS(data));
+    GBinderIpcPriv* priv = self->priv;
+
+    /* NULL handler makes gbinder_driver_read() call the objects directly */
+    if (gbinder_driver_read(self->driver, gbinder_ipc_object_registry(self),
+        NULL) < 0) {
+        gboolean fallback = FALSE;
+
+        GWARN("Failed to read from %s, starting loopers", priv->name);
+
+        /* Lock */
+        g_mutex_lock(&priv->looper_mutex);
+        if (priv->poll_watch) {
+            gbinder_fd_watch_remove(priv->poll_watch);
+            priv->poll_watch = NULL;
+            gbinder_driver_exit_looper(self->driver);
+            priv->main_loop_polling = FALSE;
+            fallback = TRUE;
+        }
+        g_mutex_unlock(&priv->looper_mutex);
+        /* Unlock */
+
+        if (fallback) {
+            /* Same as when fd watches aren't supported */
+            gbinder_ipc_looper_check(self);
+        }
+    }
+    gbinder_ipc_unref(self);
+}
+
+static
+void
+gbinder_ipc_poll_setup(
+    gpointer data)
+{
+    GBinderIpc* self = THIS(data);
+    GBinderIpcPriv* priv = self->priv;
+    GBinderDriver* driver = self->driver;
+    gboolean fallback = TRUE;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    gbinder_idle_callback_unref(priv->poll_setup);
+    priv->poll_setup = NULL;
+    if (gbinder_driver_enter_looper(driver)) {
+        priv->poll_watch = gbinder_fd_watch_add(gbinder_driver_fd(driver),
+            gbinder_ipc_poll_proc, self);
+        if (priv->poll_watch) {
+            GDEBUG("Polling %s on the main thread", priv->name);
+            priv->poll_thread = pthread_self();
+            fallback = FALSE;
+        } else {
+            gbinder_driver_exit_looper(driver);
+        }
+    }
+    if (fallback) {
+        GWARN("Can't poll %s on the main thread, starting loopers",
+            priv->name);
+        priv->main_loop_polling = FALSE;
+    }
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
+
+    if (fallback) {
+        gbinder_ipc_looper_check(self);
+    }
+}
+
+static
+void
+gbinder_ipc_poll_stop(
+    GBinderIpc* self)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    gbinder_idle_callback_destroy(priv->poll_setup);
+    priv->poll_setup = NULL;
+    if (priv->poll_watch) {
+        gbinder_fd_watch_remove(priv->poll_watch);
+        priv->poll_watch = NULL;
+        /* BC_EXIT_LOOPER must come from the thread which entered it */
+        if (pthread_equal(priv->poll_thread, pthread_self())) {
+            gbinder_driver_exit_looper(self->driver);
+        }
+    }
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
+}
+
+/*==========================================================================*
+ * GBinderIpcTxHandler
+ *
+ * It's needed to handle the following scenario:
+ *
+ * 1. Asynchronous call is made. The actual transaction is performed on
+ *    gbinder_ipc_tx_proc thread.
+ * 2. While we were are waiting for completion of our transaction, we
+ *    receive a valid incoming transation.
+ * 3. This transaction is handled by gbinder_ipc_tx_handler_transact.
+ *
+ * This seems to be quite a rare scenario. Nothing can interrupt the
+ * worker thread while it's waiting, so there's no cancellation here.
+ *
+ *==========================================================================*/
+
+static
+GBinderLocalReply*
+gbinder_ipc_tx_handler_transact_impl(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    gboolean direct,
+    int* result)
+{
+    GBinderIpcLooperTx* tx = gbinder_ipc_looper_tx_new(obj, code, flags, req);
+    GBinderEventLoopCallback* callback = NULL;
+    GBinderLocalReply* reply = NULL;
+    guint done;
+
+    if (direct) {
+        /* Handle transaction on this thread */
+        done = gbinder_ipc_looper_tx_process(tx, FALSE);
+    } else {
+        /* Handle transaction on the main thread */
+        callback = gbinder_idle_callback_schedule_new
+            (gbinder_ipc_looper_tx_handle, gbinder_ipc_looper_tx_ref(tx),
+                gbinder_ipc_looper_tx_done);
+
+        /* Wait for completion */
+        done = gbinder_ipc_looper_tx_wait(tx, TX_DONE | TX_BLOCKED);
+    }
+
+    if (done == TX_BLOCKED) {
+        /* Block until asynchronous transaction gets completed. */
+        done = gbinder_ipc_looper_tx_wait(tx, TX_DONE);
+    }
+
+    GASSERT(done == TX_DONE);
+    reply = gbinder_local_reply_ref(tx->reply);
+    *result = tx->status;
+
+    gbinder_ipc_looper_tx_unref(tx);
+    gbinder_idle_callback_destroy(callback);
+    return reply;
+}
+
+static
+GBinderLocalReply*
+gbinder_ipc_tx_handler_transact(
+    GBinderHandler* handler,
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* result)
+{
+    return gbinder_ipc_tx_handler_transact_impl(obj, req, code, flags,
+        FALSE, result);
+}
+
+static
+GBinderLocalReply*
+gbinder_ipc_tx_handler_transact_direct(
+    GBinderHandler* handler,
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* result)
+{
+    return gbinder_ipc_tx_handler_transact_impl(obj, req, code, flags,
+        TRUE, result);
+}
+
+/*==========================================================================*
+ * GBinderObjectRegistry
+ *==========================================================================*/
+
+static
+inline
+GBinderIpcRegistryShard*
+gbinder_ipc_local_shard(
+    GBinderIpcPriv* priv,
+    gconstpointer obj)
+{
+    /* Low bits of the pointer are always the same */
+    const gsize key = GPOINTER_TO_SIZE(obj) >> 4;
+
+    return priv->local_objects + ((key ^ (key >> 8)) &
+        (GBINDER_IPC_REGISTRY_SHARDS - 1));
+}
+
+static
+inline
+GBinderIpcRemoteShard*
+gbinder_ipc_remote_shard(
+    GBinderIpcPriv* priv,
+    guint32 handle)
+{
+    /* Handles are allocated sequentially */
+    return priv->remote_objects + (handle & (GBINDER_IPC_REGISTRY_SHARDS - 1));
+}
+
+static
+inline
+guint
+gbinder_ipc_remote_shard_index(
+    guint32 handle)
+{
+    return handle / GBINDER_IPC_REGISTRY_SHARDS;
+}
 
 static
-GBinderIpcTxHandler*
-gbinder_ipc_tx_handler_new(
-    void)
+GBinderRemoteObject*
+gbinder_ipc_remote_shard_lookup(
+    GBinderIpcRemoteShard* shard,
+    guint32 handle)
 {
-    GBinderIpcTxHandler* h = g_slice_new0(GBinderIpcTxHandler);
+    const guint index = gbinder_ipc_remote_shard_index(handle);
 
-    /* Note: pipe() calls can actually fail */
-    if (!pipe(h->txfd)) {
-        if (!pipe(h->pipefd)) {
-            return h;
-        } else {
-            GERR("Failed to create a tx pipe: %s", strerror(errno));
-        }
-        close(h->txfd[0]);
-        close(h->txfd[1]);
+    /* Caller holds shard->s.mutex */
+    if (index < shard->s.size) {
+        return shard->s.objects[index];
+    } else if (shard->s.overflow) {
+        return g_hash_table_lookup(shard->s.overflow,
+            GUINT_TO_POINTER(handle));
     } else {
-        GERR("Failed to create a tx pipe: %s", strerror(errno));
+        return NULL;
     }
-    g_slice_free(GBinderIpcTxHandler, h);
-    return NULL;
 }
 
 static
 void
-gbinder_ipc_tx_handler_free(
-    GBinderIpcTxHandler* h)
+gbinder_ipc_remote_shard_insert(
+    GBinderIpcRemoteShard* shard,
+    guint32 handle,
+    GBinderRemoteObject* obj)
 {
-    close(h->pipefd[0]);
-    close(h->pipefd[1]);
-    if (h->txfd[0] >= 0) {
-        close(h->txfd[0]);
-        close(h->txfd[1]);
+    const guint index = gbinder_ipc_remote_shard_index(handle);
+
+    /* Caller holds shard->s.mutex and has checked that the slot is empty */
+    if (index < (GBINDER_IPC_REMOTE_DENSE_MAX / GBINDER_IPC_REGISTRY_SHARDS)) {
+        if (index >= shard->s.size) {
+            guint size = MAX(shard->s.size, GBINDER_IPC_REMOTE_DENSE_MIN_SIZE);
+
+            while (size <= index) size *= 2;
+            shard->s.objects = g_renew(GBinderRemoteObject*,
+                shard->s.objects, size);
+            memset(shard->s.objects + shard->s.size, 0,
+                sizeof(GBinderRemoteObject*) * (size - shard->s.size));
+            shard->s.size = size;
+        }
+        shard->s.objects[index] = obj;
+    } else {
+        if (!shard->s.overflow) {
+            shard->s.overflow = g_hash_table_new(g_direct_hash,
+                g_direct_equal);
+        }
+        g_hash_table_insert(shard->s.overflow, GUINT_TO_POINTER(handle), obj);
     }
-    g_slice_free(GBinderIpcTxHandler, h);
+    shard->s.count++;
 }
 
 static
-GBinderLocalReply*
-gbinder_ipc_tx_handler_transact(
-    GBinderHandler* handler,
-    GBinderLocalObject* obj,
-    GBinderRemoteRequest* req,
-    guint code,
-    guint flags,
-    int* result)
+GBinderRemoteObject*
+gbinder_ipc_remote_shard_remove(
+    GBinderIpcRemoteShard* shard,
+    guint32 handle)
 {
-    GBinderIpcTxHandler* h = gbinder_ipc_tx_handler_new();
-    GBinderLocalReply* reply = NULL;
-    int status = -EFAULT;
-
-    if (h) {
-        GBinderIpcLooperTx* tx = gbinder_ipc_looper_tx_new(obj, code, flags,
-            req, h->txfd);
-        guint8 done = 0;
-        /* Handle transaction on the main thread */
-        GBinderEventLoopCallback* callback =
-            gbinder_idle_callback_schedule_new(gbinder_ipc_looper_tx_handle,
-                gbinder_ipc_looper_tx_ref(tx), gbinder_ipc_looper_tx_done);
+    const guint index = gbinder_ipc_remote_shard_index(handle);
+    GBinderRemoteObject* obj = NULL;
 
-        /* Wait for completion */
-        if (gbinder_ipc_wait(h->pipefd[0], tx->pipefd[0], &done) &&
-            done == TX_BLOCKED) {
-            /* Block until asynchronous transaction gets completed. */
-            done = 0;
-            if (gbinder_ipc_wait(h->pipefd[0], tx->pipefd[0], &done)) {
-                GASSERT(done == TX_DONE);
+    /* Caller holds shard->s.mutex */
+    if (index < shard->s.size) {
+        obj = shard->s.objects[index];
+        shard->s.objects[index] = NULL;
+    } else if (shard->s.overflow) {
+        const gpointer key = GUINT_TO_POINTER(handle);
+
+        obj = g_hash_table_lookup(shard->s.overflow, key);
+        if (obj) {
+            g_hash_table_remove(shard->s.overflow, key);
+            if (g_hash_table_size(shard->s.overflow) == 0) {
+                g_hash_table_unref(shard->s.overflow);
+                shard->s.overflow = NULL;
             }
         }
-
-        if (done) {
-            GASSERT(done == TX_DONE);
-            reply = gbinder_local_reply_ref(tx->reply);
-            status = tx->status;
-        }
-
-        if (!gbinder_ipc_looper_tx_unref(tx, TRUE)) {
-            /*
-             * This wasn't the last references meaning that
-             * gbinder_ipc_looper_tx_free() will close the
-             * descriptors and we will have to create a new
-             * pipe for the next transaction.
-             */
-            h->txfd[0] = h->txfd[1] = -1;
-        }
-
-        gbinder_idle_callback_destroy(callback);
-        gbinder_ipc_tx_handler_free(h);
     }
 
-    *result = status;
-    return reply;
+    if (obj && !--shard->s.count) {
+        /* Give the memory back when the shard becomes empty */
+        g_free(shard->s.objects);
+        shard->s.objects = NULL;
+        shard->s.size = 0;
+    }
+    return obj;
 }
 
-/*==========================================================================*
- * GBinderObjectRegistry
- *==========================================================================*/
-
 static
 void
 gbinder_ipc_invalidate_local_object_locked(
     GBinderIpc* self,
+    GBinderIpcRegistryShard* shard,
     GBinderLocalObject* obj)
 {
-    GBinderIpcPriv* priv = self->priv;
-
-    if (priv->local_objects && g_hash_table_remove(priv->local_objects, obj)) {
+    /* Caller holds shard->s.mutex */
+    if (shard->s.table && g_hash_table_remove(shard->s.table, obj)) {
         GVERBOSE_("%p %s", obj, gbinder_ipc_name(self));
-        if (g_hash_table_size(priv->local_objects) == 0) {
-            g_hash_table_unref(priv->local_objects);
-            priv->local_objects = NULL;
+        if (g_hash_table_size(shard->s.table) == 0) {
+            g_hash_table_unref(shard->s.table);
+            shard->s.table = NULL;
         }
     }
 }
@@ -1141,25 +1848,19 @@ static
 void
 gbinder_ipc_invalidate_remote_handle_locked(
     GBinderIpc* self,
+    GBinderIpcRemoteShard* shard,
     guint32 handle)
 {
-    GBinderIpcPriv* priv = self->priv;
-
-    /* Caller holds priv->remote_objects_mutex */
-    if (priv->remote_objects) {
-        const gpointer key = GINT_TO_POINTER(handle);
+    /* Caller holds shard->s.mutex */
 #if GUTIL_LOG_VERBOSE
-        const gpointer obj = g_hash_table_lookup(priv->remote_objects, key);
-#endif
+    GBinderRemoteObject* obj = gbinder_ipc_remote_shard_remove(shard, handle);
 
-        if (g_hash_table_remove(priv->remote_objects, key)) {
-            GVERBOSE_("handle %u %p %s", handle, obj, gbinder_ipc_name(self));
-            if (g_hash_table_size(priv->remote_objects) == 0) {
-                g_hash_table_unref(priv->remote_objects);
-                priv->remote_objects = NULL;
-            }
-        }
+    if (obj) {
+        GVERBOSE_("handle %u %p %s", handle, obj, gbinder_ipc_name(self));
     }
+#else
+    gbinder_ipc_remote_shard_remove(shard, handle);
+#endif
 }
 
 void
@@ -1167,12 +1868,12 @@ gbinder_ipc_invalidate_local_object(
     GBinderIpc* self,
     GBinderLocalObject* obj)
 {
-    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcRegistryShard* shard = gbinder_ipc_local_shard(self->priv, obj);
 
     /* Lock */
-    g_mutex_lock(&priv->local_objects_mutex);
-    gbinder_ipc_invalidate_local_object_locked(self, obj);
-    g_mutex_unlock(&priv->local_objects_mutex);
+    g_mutex_lock(&shard->s.mutex);
+    gbinder_ipc_invalidate_local_object_locked(self, shard, obj);
+    g_mutex_unlock(&shard->s.mutex);
     /* Unlock */
 }
 
@@ -1181,12 +1882,13 @@ gbinder_ipc_invalidate_remote_handle(
     GBinderIpc* self,
     guint32 handle)
 {
-    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcRemoteShard* shard = gbinder_ipc_remote_shard(self->priv,
+        handle);
 
     /* Lock */
-    g_mutex_lock(&priv->remote_objects_mutex);
-    gbinder_ipc_invalidate_remote_handle_locked(self, handle);
-    g_mutex_unlock(&priv->remote_objects_mutex);
+    g_mutex_lock(&shard->s.mutex);
+    gbinder_ipc_invalidate_remote_handle_locked(self, shard, handle);
+    g_mutex_unlock(&shard->s.mutex);
     /* Unlock */
 }
 
@@ -1215,14 +1917,14 @@ gbinder_ipc_local_object_disposed(
     GBinderIpc* self,
     GBinderLocalObject* obj)
 {
-    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcRegistryShard* shard = gbinder_ipc_local_shard(self->priv, obj);
 
     /* Lock */
-    g_mutex_lock(&priv->local_objects_mutex);
+    g_mutex_lock(&shard->s.mutex);
     if (g_atomic_int_get(&obj->object.ref_count) == 1) {
-        gbinder_ipc_invalidate_local_object_locked(self, obj);
+        gbinder_ipc_invalidate_local_object_locked(self, shard, obj);
     }
-    g_mutex_unlock(&priv->local_objects_mutex);
+    g_mutex_unlock(&shard->s.mutex);
     /* Unlock */
 }
 
@@ -1231,7 +1933,8 @@ gbinder_ipc_remote_object_disposed(
     GBinderIpc* self,
     GBinderRemoteObject* obj)
 {
-    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcRemoteShard* shard = gbinder_ipc_remote_shard(self->priv,
+        obj->handle);
 
     /*
      * Check of ref_count for 1 makes it possible (albeit quite unlikely)
@@ -1249,7 +1952,7 @@ gbinder_ipc_remote_object_disposed(
      *
      * We still have to invalidate the handle here because it's the last
      * point when GObject can be legitimately re-referenced and brought
-     * back to life. Which means that GBinderIpc mutex has to acquired
+     * back to life. Which means that the shard mutex has to acquired
      * twice during GBinderRemoteObject destruction.
      *
      * The same applies to GBinderLocalObject too, except that it calls
@@ -1257,11 +1960,11 @@ gbinder_ipc_remote_object_disposed(
      */
 
     /* Lock */
-    g_mutex_lock(&priv->remote_objects_mutex);
+    g_mutex_lock(&shard->s.mutex);
     if (g_atomic_int_get(&obj->object.ref_count) == 1) {
-        gbinder_ipc_invalidate_remote_handle_locked(self, obj->handle);
+        gbinder_ipc_invalidate_remote_handle_locked(self, shard, obj->handle);
     }
-    g_mutex_unlock(&priv->remote_objects_mutex);
+    g_mutex_unlock(&shard->s.mutex);
     /* Unlock */
 }
 
@@ -1270,18 +1973,18 @@ gbinder_ipc_register_local_object(
     GBinderIpc* self,
     GBinderLocalObject* obj)
 {
-    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcRegistryShard* shard = gbinder_ipc_local_shard(self->priv, obj);
 
     /* Lock */
-    g_mutex_lock(&priv->local_objects_mutex);
-    if (!priv->local_objects) {
-        priv->local_objects = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_mutex_lock(&shard->s.mutex);
+    if (!shard->s.table) {
+        shard->s.table = g_hash_table_new(g_direct_hash, g_direct_equal);
     }
-    if (!g_hash_table_contains(priv->local_objects, obj)) {
-        g_hash_table_insert(priv->local_objects, obj, obj);
+    if (!g_hash_table_contains(shard->s.table, obj)) {
+        g_hash_table_insert(shard->s.table, obj, obj);
         GVERBOSE_("%p %s", obj, gbinder_ipc_name(self));
     }
-    g_mutex_unlock(&priv->local_objects_mutex);
+    g_mutex_unlock(&shard->s.mutex);
     /* Unlock */
 
     gbinder_ipc_looper_check(self);
@@ -1296,20 +1999,23 @@ gbinder_ipc_priv_get_local_object(
     GBinderLocalObject* obj = NULL;
 
     if (pointer) {
+        GBinderIpcRegistryShard* shard = gbinder_ipc_local_shard(priv,
+            pointer);
+
         /* Lock */
-        g_mutex_lock(&priv->local_objects_mutex);
-        if (priv->local_objects) {
-            obj = g_hash_table_lookup(priv->local_objects, pointer);
-            if (obj) {
-                gbinder_local_object_ref(obj);
-            } else {
-                GWARN("Unknown local object %p %s", pointer, priv->name);
-            }
-        } else {
-            GWARN("Unknown local object %p %s", pointer, priv->name);
+        g_mutex_lock(&shard->s.mutex);
+        if (shard->s.table) {
+            obj = g_hash_table_lookup(shard->s.table, pointer);
+        }
+        if (obj) {
+            gbinder_local_object_ref(obj);
         }
-        g_mutex_unlock(&priv->local_objects_mutex);
+        g_mutex_unlock(&shard->s.mutex);
         /* Unlock */
+
+        if (!obj) {
+            GWARN("Unknown local object %p %s", pointer, priv->name);
+        }
     }
 
     return obj;
@@ -1323,14 +2029,12 @@ gbinder_ipc_priv_get_remote_object(
     REMOTE_REGISTRY_CREATE create,
     gboolean maybe_dead)
 {
-    GBinderRemoteObject* obj = NULL;
-    void* key = GINT_TO_POINTER(handle);
+    GBinderIpcRemoteShard* shard = gbinder_ipc_remote_shard(priv, handle);
+    GBinderRemoteObject* obj;
 
     /* Lock */
-    g_mutex_lock(&priv->remote_objects_mutex);
-    if (priv->remote_objects) {
-        obj = g_hash_table_lookup(priv->remote_objects, key);
-    }
+    g_mutex_lock(&shard->s.mutex);
+    obj = gbinder_ipc_remote_shard_lookup(shard, handle);
     if (obj) {
         gbinder_remote_object_ref(obj);
     } else if (create != REMOTE_REGISTRY_DONT_CREATE) {
@@ -1344,21 +2048,46 @@ gbinder_ipc_priv_get_remote_object(
             REMOTE_OBJECT_CREATE_DEAD : (create == REMOTE_REGISTRY_CAN_CREATE) ?
             REMOTE_OBJECT_CREATE_ALIVE :
             REMOTE_OBJECT_CREATE_ACQUIRED);
-        if (!priv->remote_objects) {
-            priv->remote_objects = g_hash_table_new
-                (g_direct_hash, g_direct_equal);
-        }
         GVERBOSE_("%p handle %u %s", obj, handle, gbinder_ipc_name(self));
-        g_hash_table_replace(priv->remote_objects, key, obj);
+        gbinder_ipc_remote_shard_insert(shard, handle, obj);
     } else {
         GWARN("Unknown handle %u %s", handle, priv->name);
     }
-    g_mutex_unlock(&priv->remote_objects_mutex);
+    g_mutex_unlock(&shard->s.mutex);
     /* Unlock */
 
     return obj;
 }
 
+/* Returns new references to all registered local objects */
+static
+GSList*
+gbinder_ipc_priv_local_objects(
+    GBinderIpcPriv* priv)
+{
+    GSList* list = NULL;
+    int i;
+
+    for (i = 0; i < GBINDER_IPC_REGISTRY_SHARDS; i++) {
+        GBinderIpcRegistryShard* shard = priv->local_objects + i;
+
+        /* Lock */
+        g_mutex_lock(&shard->s.mutex);
+        if (shard->s.table) {
+            GHashTableIter it;
+            gpointer value;
+
+            g_hash_table_iter_init(&it, shard->s.table);
+            while (g_hash_table_iter_next(&it, NULL, &value)) {
+                list = g_slist_prepend(list, gbinder_local_object_ref(value));
+            }
+        }
+        g_mutex_unlock(&shard->s.mutex);
+        /* Unlock */
+    }
+    return list;
+}
+
 GBinderLocalObject*
 gbinder_ipc_find_local_object(
     GBinderIpc* self,
@@ -1369,25 +2098,30 @@ gbinder_ipc_find_local_object(
 
     if (self)  {
         GBinderIpcPriv* priv = self->priv;
+        int i;
 
-        /* Lock */
-        g_mutex_lock(&priv->local_objects_mutex);
-        if (priv->local_objects) {
-            GHashTableIter it;
-            gpointer value;
-
-            g_hash_table_iter_init(&it, priv->local_objects);
-            while (g_hash_table_iter_next(&it, NULL, &value)) {
-                GBinderLocalObject* obj = GBINDER_LOCAL_OBJECT(value);
+        for (i = 0; i < GBINDER_IPC_REGISTRY_SHARDS && !found; i++) {
+            GBinderIpcRegistryShard* shard = priv->local_objects + i;
 
-                if (func(obj, user_data)) {
-                    found = gbinder_local_object_ref(obj);
-                    break;
+            /* Lock */
+            g_mutex_lock(&shard->s.mutex);
+            if (shard->s.table) {
+                GHashTableIter it;
+                gpointer value;
+
+                g_hash_table_iter_init(&it, shard->s.table);
+                while (g_hash_table_iter_next(&it, NULL, &value)) {
+                    GBinderLocalObject* obj = GBINDER_LOCAL_OBJECT(value);
+
+                    if (func(obj, user_data)) {
+                        found = gbinder_local_object_ref(obj);
+                        break;
+                    }
                 }
             }
+            g_mutex_unlock(&shard->s.mutex);
+            /* Unlock */
         }
-        g_mutex_unlock(&priv->local_objects_mutex);
-        /* Unlock */
     }
 
     return found;
@@ -1494,7 +2228,6 @@ gbinder_ipc_tx_free(
     GBinderIpc* self = pub->ipc;
     GBinderIpcPriv* priv = self->priv;
 
-    gbinder_idle_callback_unref(tx->completion);
     g_hash_table_remove(priv->tx_table, GINT_TO_POINTER(pub->id));
     tx->fn_free(tx);
 
@@ -1543,8 +2276,105 @@ gbinder_ipc_tx_priv_init(
     priv->fn_exec = fn_exec;
     priv->fn_done = fn_done;
     priv->fn_free = fn_free;
-    priv->completion = gbinder_idle_callback_new(gbinder_ipc_tx_done, priv,
-        gbinder_ipc_tx_free);
+}
+
+static
+gboolean
+gbinder_ipc_tx_pool_update_locked(
+    GBinderIpcPriv* priv,
+    GBINDER_TX_LANE lane)
+{
+    GThreadPool* pool = priv->tx_pool[lane];
+    const gint max = priv->tx_threads[lane]; /* Negative means no limit */
+
+    /* The pool is gone after gbinder_ipc_exit() */
+    return pool && g_thread_pool_set_max_threads(pool, (max < 0) ? -1 :
+        (gint)MIN((guint)max + priv->tx_abandoned[lane], G_MAXINT), NULL);
+}
+
+/*
+ * A worker stuck in a transaction which has passed its deadline is
+ * abandoned, i.e. the pool is temporarily allowed to have one more
+ * thread, so that a single hung remote can't exhaust the pool. The
+ * extra slot is returned when the stuck transaction finally completes.
+ */
+static
+void
+gbinder_ipc_tx_pool_adjust(
+    GBinderIpc* self,
+    GBINDER_TX_LANE lane,
+    int abandoned)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    /* Lock */
+    g_mutex_lock(&priv->tx_pool_mutex);
+    priv->tx_abandoned[lane] += abandoned;
+    gbinder_ipc_tx_pool_update_locked(priv, lane);
+    g_mutex_unlock(&priv->tx_pool_mutex);
+    /* Unlock */
+}
+
+/* Invoked on a thread from tx_pool before fn_exec */
+static
+gboolean
+gbinder_ipc_tx_begin(
+    GBinderIpcTxPriv* tx)
+{
+    if (!tx->deadline) {
+        return TRUE;
+    } else if (g_get_monotonic_time() >= tx->deadline) {
+        /* Expired in the queue, drop it without sending */
+        if (g_atomic_int_compare_and_exchange(&tx->state,
+            GBINDER_IPC_TX_QUEUED, GBINDER_IPC_TX_FINISHED)) {
+            GDEBUG("Transaction %lu expired in the queue", tx->pub.id);
+        }
+        return FALSE;
+    } else {
+        /* Fails if it has just timed out */
+        return g_atomic_int_compare_and_exchange(&tx->state,
+            GBINDER_IPC_TX_QUEUED, GBINDER_IPC_TX_RUNNING);
+    }
+}
+
+/* Invoked on a thread from tx_pool after fn_exec */
+static
+void
+gbinder_ipc_tx_end(
+    GBinderIpc* self,
+    GBinderIpcTxPriv* tx)
+{
+    if (tx->deadline && !g_atomic_int_compare_and_exchange(&tx->state,
+        GBINDER_IPC_TX_RUNNING, GBINDER_IPC_TX_FINISHED)) {
+        /* This worker has been abandoned, its reply is of no use */
+        GDEBUG("Transaction %lu completed after the deadline", tx->pub.id);
+        gbinder_ipc_tx_pool_adjust(self, tx->lane, -1);
+    }
+}
+
+/*
+ * Called when the deadline has passed. Returns FALSE if the transaction
+ * has finished in the meantime (and the completion is on its way).
+ */
+static
+gboolean
+gbinder_ipc_tx_time_out(
+    GBinderIpcTxPriv* tx)
+{
+    GBinderIpcTx* pub = &tx->pub;
+
+    if (g_atomic_int_compare_and_exchange(&tx->state,
+        GBINDER_IPC_TX_QUEUED, GBINDER_IPC_TX_TIMED_OUT)) {
+        GDEBUG("Transaction %lu timed out in the queue", pub->id);
+        return TRUE;
+    } else if (g_atomic_int_compare_and_exchange(&tx->state,
+        GBINDER_IPC_TX_RUNNING, GBINDER_IPC_TX_TIMED_OUT)) {
+        GWARN("Transaction %lu timed out, abandoning the worker", pub->id);
+        gbinder_ipc_tx_pool_adjust(pub->ipc, tx->lane, 1);
+        return TRUE;
+    } else {
+        return FALSE;
+    }
 }
 
 static
@@ -1564,6 +2394,7 @@ gbinder_ipc_tx_internal_free(
     GBinderIpcTxInternal* tx = gbinder_ipc_tx_internal_cast(priv);
     GBinderIpcTx* pub = &priv->pub;
 
+    gbinder_timeout_remove(tx->watchdog);
     gbinder_local_request_unref(tx->req);
     gbinder_remote_reply_unref(tx->reply);
     if (tx->fn_destroy) {
@@ -1580,11 +2411,52 @@ gbinder_ipc_tx_internal_done(
     GBinderIpcTxInternal* tx = gbinder_ipc_tx_internal_cast(priv);
     GBinderIpcTx* pub = &priv->pub;
 
+    if (tx->flags & GBINDER_TX_FLAG_ONEWAY) {
+        gbinder_ipc_stats_oneway(pub->ipc, tx->status);
+    } else {
+        gbinder_ipc_stats_call(pub->ipc, &pub->ipc->priv->async_calls,
+            tx->start, tx->status);
+    }
     if (tx->fn_reply) {
         tx->fn_reply(pub->ipc, tx->reply, tx->status, pub->user_data);
     }
 }
 
+/* Fires on the main thread when the deadline passes */
+static
+gboolean
+gbinder_ipc_tx_internal_watchdog(
+    gpointer data)
+{
+    GBinderIpcTxInternal* tx = data;
+    GBinderIpcTxPriv* priv = &tx->tx;
+    GBinderIpcTx* pub = &priv->pub;
+
+    tx->watchdog = NULL;
+    if (!pub->cancelled && gbinder_ipc_tx_time_out(priv)) {
+        GBinderIpc* ipc = pub->ipc;
+
+        /*
+         * Complete it right away. The worker may still be writing the
+         * reply into GBinderIpcTxInternal, leave those fields alone and
+         * let gbinder_ipc_tx_done() skip the transaction when it's done.
+         */
+        pub->cancelled = TRUE;
+        gbinder_ipc_stats_call(ipc, &ipc->priv->async_calls, tx->start,
+            -ETIMEDOUT);
+        if (tx->fn_reply) {
+            tx->fn_reply(ipc, NULL, -ETIMEDOUT, pub->user_data);
+        }
+        if (tx->fn_destroy) {
+            GDestroyNotify destroy = tx->fn_destroy;
+
+            tx->fn_destroy = NULL;
+            destroy(pub->user_data);
+        }
+    }
+    return G_SOURCE_REMOVE;
+}
+
 static
 void
 gbinder_ipc_tx_internal_exec(
@@ -1593,11 +2465,12 @@ gbinder_ipc_tx_internal_exec(
     GBinderIpcTxInternal* tx = gbinder_ipc_tx_internal_cast(priv);
     GBinderIpc* ipc = priv->pub.ipc;
 
+    /* These are accounted for by gbinder_ipc_tx_internal_done() */
     if (tx->flags & GBINDER_TX_FLAG_ONEWAY) {
-        tx->status = gbinder_ipc_transact_sync_oneway_worker(ipc, tx->handle,
+        tx->status = gbinder_ipc_transact_oneway_worker(ipc, tx->handle,
             tx->code, tx->req);
     } else {
-        tx->reply = gbinder_ipc_transact_sync_reply_worker(ipc, tx->handle,
+        tx->reply = gbinder_ipc_transact_reply_worker(ipc, tx->handle,
             tx->code, tx->req, &tx->status);
     }
 }
@@ -1628,6 +2501,7 @@ gbinder_ipc_tx_internal_new(
     tx->req = gbinder_local_request_ref(req);
     tx->fn_reply = reply;
     tx->fn_destroy = destroy;
+    tx->start = g_get_monotonic_time();
 
     return priv;
 }
@@ -1702,6 +2576,198 @@ gbinder_ipc_tx_custom_new(
     return priv;
 }
 
+/* Hands the transaction over to the tx_pool of the specified lane */
+static
+gulong
+gbinder_ipc_tx_push(
+    GBinderIpc* self,
+    GBinderIpcTxPriv* tx,
+    GBINDER_TX_LANE lane)
+{
+    GBinderIpcPriv* priv = self->priv;
+    const gulong id = tx->pub.id;
+
+    tx->lane = lane;
+    g_hash_table_insert(priv->tx_table, GINT_TO_POINTER(id), tx);
+    g_thread_pool_push(priv->tx_pool[lane], tx, NULL);
+    return id;
+}
+
+/*
+ * One-way transactions don't block, there's no need to involve tx_pool.
+ * They get queued and sent by a single idle callback (normally, with a
+ * single ioctl), then the completions are delivered in one go.
+ */
+static
+void
+gbinder_ipc_oneway_flush(
+    gpointer data)
+{
+    /* The last transaction may be holding the last reference */
+    GBinderIpc* self = gbinder_ipc_ref(THIS(data));
+    GBinderIpcPriv* priv = self->priv;
+    GPtrArray* queue = priv->oneway_queue;
+    GBinderDriverOneway* txs = g_new(GBinderDriverOneway, queue->len);
+    GBinderIpcTxPriv** sent = g_new(GBinderIpcTxPriv*, queue->len);
+    guint i, n = 0;
+
+    /* Transactions submitted by the callbacks go to the next batch */
+    priv->oneway_queue = g_ptr_array_new();
+    gbinder_idle_callback_unref(priv->oneway_flush);
+    priv->oneway_flush = NULL;
+
+    for (i = 0; i < queue->len; i++) {
+        GBinderIpcTxPriv* tx = queue->pdata[i];
+
+        if (!tx->pub.cancelled) {
+            GBinderIpcTxInternal* itx = gbinder_ipc_tx_internal_cast(tx);
+
+            txs[n].handle = itx->handle;
+            txs[n].code = itx->code;
+            txs[n].req = itx->req;
+            sent[n++] = tx;
+        } else {
+            GVERBOSE_("not executing transaction %lu (cancelled)", tx->pub.id);
+        }
+    }
+
+    if (n) {
+        /* NULL handler means that we are on the main thread */
+        gbinder_driver_transact_oneway(self->driver, &priv->object_registry,
+            NULL, txs, n);
+        for (i = 0; i < n; i++) {
+            gbinder_ipc_tx_internal_cast(sent[i])->status = txs[i].status;
+        }
+    }
+
+    for (i = 0; i < queue->len; i++) {
+        GBinderIpcTxPriv* tx = queue->pdata[i];
+
+        gbinder_ipc_tx_done(tx);
+        gbinder_ipc_tx_free(tx);
+    }
+
+    g_ptr_array_free(queue, TRUE);
+    g_free(sent);
+    g_free(txs);
+    gbinder_ipc_unref(self);
+}
+
+static
+gulong
+gbinder_ipc_oneway_push(
+    GBinderIpc* self,
+    GBinderIpcTxPriv* tx)
+{
+    GBinderIpcPriv* priv = self->priv;
+    const gulong id = tx->pub.id;
+
+    g_hash_table_insert(priv->tx_table, GINT_TO_POINTER(id), tx);
+    g_ptr_array_add(priv->oneway_queue, tx);
+    if (!priv->oneway_flush) {
+        priv->oneway_flush = gbinder_idle_callback_schedule_new(
+            gbinder_ipc_oneway_flush, self, NULL);
+    }
+    return id;
+}
+
+/*
+ * Completed transactions are pushed by tx_pool threads to a lock-free
+ * stack and handed to the main thread in bulk. Only the thread which
+ * finds the stack empty schedules the idle callback, so there's one
+ * main loop dispatch per burst of completions rather than one per
+ * transaction.
+ */
+static
+GBinderIpcTxPriv*
+gbinder_ipc_tx_completed_take(
+    GBinderIpcPriv* priv)
+{
+    GBinderIpcTxPriv* list;
+    GBinderIpcTxPriv* fifo = NULL;
+
+    do {
+        list = g_atomic_pointer_get(&priv->completed);
+    } while (list && !g_atomic_pointer_compare_and_exchange(&priv->completed,
+        list, NULL));
+
+    /* Restore the completion order */
+    while (list) {
+        GBinderIpcTxPriv* tx = list;
+
+        list = tx->next;
+        tx->next = fifo;
+        fifo = tx;
+    }
+    return fifo;
+}
+
+static
+void
+gbinder_ipc_tx_completed_proc(
+    gpointer data)
+{
+    /* The last transaction may be holding the last reference */
+    GBinderIpc* self = gbinder_ipc_ref(THIS(data));
+    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcTxPriv* tx = gbinder_ipc_tx_completed_take(priv);
+    int n = 0;
+
+    while (tx) {
+        GBinderIpcTxPriv* next = tx->next;
+
+        gbinder_ipc_tx_done(tx);
+        gbinder_ipc_tx_free(tx);
+        tx = next;
+        n++;
+    }
+    if (n) {
+        g_atomic_int_add(&priv->completed_depth, -n);
+        g_atomic_int_add(&priv->completions, n);
+        g_atomic_int_inc(&priv->completion_batches);
+        GVERBOSE_("%d completion(s)", n);
+    }
+    gbinder_ipc_unref(self);
+}
+
+static
+void
+gbinder_ipc_tx_completed_free(
+    gpointer data)
+{
+    gbinder_ipc_unref(THIS(data));
+}
+
+static
+void
+gbinder_ipc_tx_complete(
+    GBinderIpc* self,
+    GBinderIpcTxPriv* tx)
+{
+    GBinderIpcPriv* priv = self->priv;
+    GBinderIpcTxPriv* top;
+    gint depth, max;
+
+    do {
+        top = g_atomic_pointer_get(&priv->completed);
+        tx->next = top;
+    } while (!g_atomic_pointer_compare_and_exchange(&priv->completed,
+        top, tx));
+
+    depth = g_atomic_int_add(&priv->completed_depth, 1) + 1;
+    do {
+        max = g_atomic_int_get(&priv->completed_max_depth);
+    } while (depth > max && !g_atomic_int_compare_and_exchange
+        (&priv->completed_max_depth, max, depth));
+
+    if (!top) {
+        /* The callback is only needed until it's dispatched */
+        gbinder_idle_callback_unref(gbinder_idle_callback_schedule_new
+            (gbinder_ipc_tx_completed_proc, gbinder_ipc_ref(self),
+                gbinder_ipc_tx_completed_free));
+    }
+}
+
 /* Invoked on a thread from tx_pool */
 static
 void
@@ -1710,15 +2776,38 @@ gbinder_ipc_tx_proc(
     gpointer object)
 {
     GBinderIpcTxPriv* tx = data;
+    GBinderIpcPriv* priv = THIS(object)->priv;
+    GBinderThreadAttrSaved* saved = NULL;
 
-    if (!tx->pub.cancelled) {
-        tx->fn_exec(tx);
-    } else {
+    if (g_atomic_pointer_get(&priv->thread_attr)) {
+        GBinderThreadAttrPriv* attr;
+
+        /* Lock */
+        g_mutex_lock(&priv->tx_pool_mutex);
+        attr = gbinder_thread_attr_ref(priv->thread_attr);
+        g_mutex_unlock(&priv->tx_pool_mutex);
+        /* Unlock */
+
+        /*
+         * GLib may hand this thread over to another (non-exclusive)
+         * pool afterwards, the attributes must not go along with it.
+         */
+        saved = gbinder_thread_attr_push(attr);
+        gbinder_thread_attr_unref(attr);
+    }
+
+    GBINDER_PROBE2(tx_exec_start, tx->pub.id, tx->pub.cancelled);
+    if (tx->pub.cancelled) {
         GVERBOSE_("not executing transaction %lu (cancelled)", tx->pub.id);
+    } else if (gbinder_ipc_tx_begin(tx)) {
+        tx->fn_exec(tx);
+        gbinder_ipc_tx_end(THIS(object), tx);
     }
+    GBINDER_PROBE1(tx_exec_done, tx->pub.id);
+    gbinder_thread_attr_pop(saved);
 
     /* The result is handled by the main thread */
-    gbinder_idle_callback_schedule(tx->completion);
+    gbinder_ipc_tx_complete(THIS(object), tx);
 }
 
 /*==========================================================================*
@@ -1727,7 +2816,7 @@ gbinder_ipc_tx_proc(
 
 static
 GBinderRemoteReply*
-gbinder_ipc_transact_sync_reply_worker(
+gbinder_ipc_transact_reply_worker(
     GBinderIpc* self,
     guint32 handle,
     guint32 code,
@@ -1738,7 +2827,8 @@ gbinder_ipc_transact_sync_reply_worker(
     if (G_LIKELY(self)) {
         static const GBinderHandlerFunctions handler_fn = {
             .can_loop = NULL,
-            .transact = gbinder_ipc_tx_handler_transact
+            .transact = gbinder_ipc_tx_handler_transact,
+            .transact_direct = gbinder_ipc_tx_handler_transact_direct
         };
         GBinderHandler handler = { &handler_fn };
         GBinderIpcPriv* priv = self->priv;
@@ -1761,7 +2851,7 @@ gbinder_ipc_transact_sync_reply_worker(
 
 static
 int
-gbinder_ipc_transact_sync_oneway_worker(
+gbinder_ipc_transact_oneway_worker(
     GBinderIpc* self,
     guint32 handle,
     guint32 code,
@@ -1771,7 +2861,8 @@ gbinder_ipc_transact_sync_oneway_worker(
     if (G_LIKELY(self)) {
         static const GBinderHandlerFunctions handler_fn = {
             .can_loop = NULL,
-            .transact = gbinder_ipc_tx_handler_transact
+            .transact = gbinder_ipc_tx_handler_transact,
+            .transact_direct = gbinder_ipc_tx_handler_transact_direct
         };
         GBinderHandler handler = { &handler_fn };
         GBinderIpcPriv* priv = self->priv;
@@ -1783,6 +2874,44 @@ gbinder_ipc_transact_sync_oneway_worker(
     }
 }
 
+static
+GBinderRemoteReply*
+gbinder_ipc_transact_sync_reply_worker(
+    GBinderIpc* self,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* req,
+    int* status)
+{
+    const gint64 start = g_get_monotonic_time();
+    int ret;
+    GBinderRemoteReply* reply = gbinder_ipc_transact_reply_worker(self,
+        handle, code, req, &ret);
+
+    if (G_LIKELY(self)) {
+        gbinder_ipc_stats_call(self, &self->priv->sync_calls, start, ret);
+    }
+    if (status) *status = ret;
+    return reply;
+}
+
+static
+int
+gbinder_ipc_transact_sync_oneway_worker(
+    GBinderIpc* self,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* req)
+{
+    const int ret = gbinder_ipc_transact_oneway_worker(self, handle, code,
+        req);
+
+    if (G_LIKELY(self)) {
+        gbinder_ipc_stats_oneway(self, ret);
+    }
+    return ret;
+}
+
 const GBinderIpcSyncApi gbinder_ipc_sync_worker = {
     .sync_reply = gbinder_ipc_transact_sync_reply_worker,
     .sync_oneway = gbinder_ipc_transact_sync_oneway_worker
@@ -1799,14 +2928,37 @@ gbinder_ipc_transact_sync_reply_main(
     guint32 code,
     GBinderLocalRequest* req,
     int* status)
+{
+    return gbinder_ipc_transact_sync_reply_deadline(self, handle, code, req,
+        status, 0);
+}
+
+/*
+ * Synchronous transaction with a deadline. Like any other synchronous
+ * call, it's performed by the calling thread which keeps handling the
+ * incoming transactions while waiting for the reply. If the deadline
+ * passes, NULL is returned with -ETIMEDOUT status and the late reply
+ * (if any) will be discarded. Note that the calling thread can't send
+ * anything to the driver until the late reply arrives.
+ */
+GBinderRemoteReply*
+gbinder_ipc_transact_sync_reply_deadline(
+    GBinderIpc* self,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* req,
+    int* status,
+    gint64 deadline)
 {
     if (G_LIKELY(self)) {
         GBinderIpcPriv* priv = self->priv;
         GBinderObjectRegistry* reg = &priv->object_registry;
         GBinderRemoteReply* reply = gbinder_remote_reply_new(reg);
-        int ret = gbinder_driver_transact(self->driver, reg, NULL, handle,
-            code, req, reply);
+        const gint64 start = g_get_monotonic_time();
+        int ret = gbinder_driver_transact_deadline(self->driver, reg, NULL,
+            handle, code, req, reply, deadline);
 
+        gbinder_ipc_stats_call(self, &priv->sync_calls, start, ret);
         if (status) *status = ret;
         if (ret == GBINDER_STATUS_OK || !gbinder_remote_reply_is_empty(reply)) {
             return reply;
@@ -1828,9 +2980,11 @@ gbinder_ipc_transact_sync_oneway_main(
 {
     if (G_LIKELY(self)) {
         GBinderIpcPriv* priv = self->priv;
+        const int ret = gbinder_driver_transact(self->driver,
+            &priv->object_registry, NULL, handle, code, req, NULL);
 
-        return gbinder_driver_transact(self->driver, &priv->object_registry,
-            NULL, handle, code, req, NULL);
+        gbinder_ipc_stats_oneway(self, ret);
+        return ret;
     } else {
         return (-EINVAL);
     }
@@ -1845,6 +2999,39 @@ const GBinderIpcSyncApi gbinder_ipc_sync_main = {
  * Interface
  *==========================================================================*/
 
+static
+gboolean
+gbinder_ipc_config_boolean(
+    const char* key)
+{
+    GKeyFile* k = gbinder_config_get();
+
+    return k && g_key_file_get_boolean(k, GBINDER_CONFIG_GROUP_GENERAL,
+        key, NULL);
+}
+
+static
+void
+gbinder_ipc_config_tx_threads(
+    GBinderIpc* self,
+    GBINDER_TX_LANE lane,
+    const char* key)
+{
+    GKeyFile* k = gbinder_config_get();
+
+    if (k) {
+        GError* error = NULL;
+        const int val = g_key_file_get_integer(k,
+            GBINDER_CONFIG_GROUP_GENERAL, key, &error);
+
+        if (error) {
+            g_error_free(error);
+        } else if (val > 0) {
+            gbinder_ipc_set_tx_threads(self, lane, val);
+        }
+    }
+}
+
 GBinderIpc*
 gbinder_ipc_new(
     const char* dev,
@@ -1879,6 +3066,20 @@ gbinder_ipc_new(
             self->dev = priv->dev = g_strdup(dev);
             priv->key = key;
             self->priv->object_registry.io = gbinder_driver_io(driver);
+            priv->blocking_loopers =
+                gbinder_ipc_config_boolean(CONF_BLOCKING_LOOPERS);
+            priv->main_loop_polling =
+                gbinder_ipc_config_boolean(CONF_MAIN_LOOP_POLLING);
+            gbinder_ipc_set_stats(self,
+                gbinder_ipc_config_boolean(CONF_STATS));
+            gbinder_ipc_set_stats_transaction(self,
+                gbinder_ipc_config_boolean(CONF_STATS_TRANSACTION));
+            gbinder_ipc_config_tx_threads(self, GBINDER_TX_LANE_NORMAL,
+                CONF_TX_THREADS);
+            gbinder_ipc_config_tx_threads(self, GBINDER_TX_LANE_URGENT,
+                CONF_URGENT_TX_THREADS);
+            priv->thread_attr = gbinder_thread_attr_config();
+            gbinder_trace_config();
             /* gbinder_ipc_dispose will remove iself from the table */
             if (!gbinder_ipc_table) {
                 gbinder_ipc_table = g_hash_table_new(g_str_hash, g_str_equal);
@@ -1971,17 +3172,54 @@ gbinder_ipc_transact(
     GBinderIpcReplyFunc reply,
     GDestroyNotify destroy,
     void* user_data)
+{
+    return gbinder_ipc_transact_deadline(self, handle, code, flags, req,
+        reply, destroy, user_data, 0);
+}
+
+/*
+ * If the deadline passes while the transaction is still queued, it gets
+ * dropped without being sent. If it's already in progress, the worker
+ * is abandoned. Either way, the reply callback gets invoked with NULL
+ * reply and -ETIMEDOUT status as soon as the deadline passes. One-way
+ * transactions don't block and ignore the deadline.
+ */
+gulong
+gbinder_ipc_transact_deadline(
+    GBinderIpc* self,
+    guint32 handle,
+    guint32 code,
+    guint32 flags,
+    GBinderLocalRequest* req,
+    GBinderIpcReplyFunc reply,
+    GDestroyNotify destroy,
+    void* user_data,
+    gint64 deadline)
 {
     if (G_LIKELY(self)) {
-        GBinderIpcPriv* priv = self->priv;
         GBinderIpcTxPriv* tx = gbinder_ipc_tx_internal_new(self,
             gbinder_ipc_tx_get_id(self), handle, code, flags, req, reply,
             destroy, user_data);
-        const gulong id = tx->pub.id;
 
-        g_hash_table_insert(priv->tx_table, GINT_TO_POINTER(id), tx);
-        g_thread_pool_push(priv->tx_pool, tx, NULL);
-        return id;
+        GBINDER_TRACE(GBINDER_TRACE_TX_QUEUED, tx->pub.id, handle, code);
+        if (flags & GBINDER_TX_FLAG_ONEWAY) {
+            return gbinder_ipc_oneway_push(self, tx);
+        } else {
+            if (deadline > 0) {
+                GBinderIpcTxInternal* itx = gbinder_ipc_tx_internal_cast(tx);
+                const gint64 usec = MAX(deadline - g_get_monotonic_time(), 0);
+
+                /* Until it's actually executed */
+                itx->status = (-ETIMEDOUT);
+                itx->watchdog = gbinder_timeout_add((guint)
+                    MIN((usec + 999) / 1000, G_MAXUINT),
+                    gbinder_ipc_tx_internal_watchdog, itx);
+                tx->deadline = deadline;
+            }
+            return gbinder_ipc_tx_push(self, tx,
+                (flags & GBINDER_TX_FLAG_URGENT) ?
+                GBINDER_TX_LANE_URGENT : GBINDER_TX_LANE_NORMAL);
+        }
     } else {
         return 0;
     }
@@ -1996,14 +3234,9 @@ gbinder_ipc_transact_custom(
     void* user_data)
 {
     if (G_LIKELY(self)) {
-        GBinderIpcPriv* priv = self->priv;
-        GBinderIpcTxPriv* tx = gbinder_ipc_tx_custom_new(self,
-            gbinder_ipc_tx_get_id(self), exec, done, destroy, user_data);
-        const gulong id = tx->pub.id;
-
-        g_hash_table_insert(priv->tx_table, GINT_TO_POINTER(id), tx);
-        g_thread_pool_push(priv->tx_pool, tx, NULL);
-        return id;
+        return gbinder_ipc_tx_push(self, gbinder_ipc_tx_custom_new(self,
+            gbinder_ipc_tx_get_id(self), exec, done, destroy, user_data),
+            GBINDER_TX_LANE_NORMAL);
     } else {
         return 0;
     }
@@ -2028,18 +3261,299 @@ gbinder_ipc_cancel(
     }
 }
 
+void
+gbinder_ipc_get_stats(
+    GBinderIpc* self,
+    GBinderStats* stats) /* Since 1.1.51 */
+{
+    if (G_LIKELY(stats)) {
+        memset(stats, 0, sizeof(*stats));
+        if (G_LIKELY(self)) {
+            GBinderIpcPriv* priv = self->priv;
+            GBinderDriverStats driver;
+            const GBinderIpcLooper* l;
+
+            /* Lock */
+            g_mutex_lock(&priv->stats_mutex);
+            stats->sync_calls = priv->sync_calls;
+            stats->async_calls = priv->async_calls;
+            stats->incoming = priv->incoming;
+            g_mutex_unlock(&priv->stats_mutex);
+            /* Unlock */
+
+            stats->oneway_calls = (guint)
+                g_atomic_int_get(&priv->oneway_calls);
+            stats->failed_calls = (guint)
+                g_atomic_int_get(&priv->failed_calls);
+            if (priv->tx_pool[GBINDER_TX_LANE_NORMAL]) {
+                GThreadPool* pool = priv->tx_pool[GBINDER_TX_LANE_NORMAL];
+
+                stats->tx_pool_threads = g_thread_pool_get_num_threads(pool);
+                stats->tx_pool_queued = g_thread_pool_unprocessed(pool);
+            }
+            if (priv->tx_pool[GBINDER_TX_LANE_URGENT]) {
+                GThreadPool* pool = priv->tx_pool[GBINDER_TX_LANE_URGENT];
+
+                stats->urgent_pool_threads =
+                    g_thread_pool_get_num_threads(pool);
+                stats->urgent_pool_queued = g_thread_pool_unprocessed(pool);
+            }
+            stats->completion_queue_depth = (guint)
+                g_atomic_int_get(&priv->completed_depth);
+            stats->completion_queue_max_depth = (guint)
+                g_atomic_int_get(&priv->completed_max_depth);
+            stats->completion_batches = (guint)
+                g_atomic_int_get(&priv->completion_batches);
+            stats->completions = (guint)
+                g_atomic_int_get(&priv->completions);
+
+            /* Lock */
+            g_mutex_lock(&priv->looper_mutex);
+            for (l = priv->primary_loopers; l; l = l->next) {
+                stats->primary_loopers++;
+            }
+            for (l = priv->blocked_loopers; l; l = l->next) {
+                stats->blocked_loopers++;
+            }
+            stats->spawned_loopers = priv->spawned_loopers;
+            g_mutex_unlock(&priv->looper_mutex);
+            /* Unlock */
+
+            gbinder_driver_get_stats(self->driver, &driver);
+            stats->ioctls = driver.ioctls;
+            stats->transactions = driver.transactions;
+            stats->bytes_written = driver.bytes_written;
+            stats->bytes_read = driver.bytes_read;
+            memcpy(stats->bc, driver.bc, sizeof(stats->bc));
+            memcpy(stats->br, driver.br, sizeof(stats->br));
+        }
+    }
+}
+
+void
+gbinder_ipc_stats_incoming(
+    GBinderIpc* self,
+    gint64 usec)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    /* Lock */
+    g_mutex_lock(&priv->stats_mutex);
+    gbinder_stats_latency_add(&priv->incoming, usec);
+    g_mutex_unlock(&priv->stats_mutex);
+    /* Unlock */
+}
+
+gboolean
+gbinder_ipc_stats_enabled(
+    GBinderIpc* self)
+{
+    return G_LIKELY(self) && self->priv->stats_enabled;
+}
+
+void
+gbinder_ipc_set_stats(
+    GBinderIpc* self,
+    gboolean enabled)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    /* Dumping the stats makes no sense without collecting them */
+    priv->stats_enabled = enabled || priv->stats_transaction;
+    gbinder_driver_set_stats(self->driver, priv->stats_enabled);
+}
+
+gboolean
+gbinder_ipc_stats_transaction_enabled(
+    GBinderIpc* self)
+{
+    return G_LIKELY(self) && self->priv->stats_transaction;
+}
+
+void
+gbinder_ipc_set_stats_transaction(
+    GBinderIpc* self,
+    gboolean enabled)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    priv->stats_transaction = enabled;
+    if (enabled) {
+        gbinder_ipc_set_stats(self, TRUE);
+    }
+}
+
 gboolean
 gbinder_ipc_set_max_threads(
     GBinderIpc* self,
     gint max)
 {
-    return g_thread_pool_set_max_threads(self->priv->tx_pool, max, NULL);
+    GBinderIpcPriv* priv = self->priv;
+    gboolean ok;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    priv->max_spawned_loopers = (max < 0) ?
+        GBINDER_IPC_MAX_SPAWNED_LOOPERS : max;
+    gbinder_ipc_looper_update_max_threads_locked(self);
+    if (priv->spawn_pending) {
+        gbinder_ipc_looper_spawn_locked(self);
+    }
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
+
+    /* Lock */
+    g_mutex_lock(&priv->tx_pool_mutex);
+    priv->tx_threads[GBINDER_TX_LANE_NORMAL] = MAX(max, -1);
+    ok = gbinder_ipc_tx_pool_update_locked(priv, GBINDER_TX_LANE_NORMAL);
+    g_mutex_unlock(&priv->tx_pool_mutex);
+    /* Unlock */
+
+    return ok;
+}
+
+gboolean
+gbinder_ipc_set_tx_threads(
+    GBinderIpc* self,
+    GBINDER_TX_LANE lane,
+    guint max_threads) /* Since 1.1.51 */
+{
+    if (G_LIKELY(self) && (guint)lane < GBINDER_IPC_TX_LANES &&
+        max_threads > 0) {
+        GBinderIpcPriv* priv = self->priv;
+        gboolean ok;
+
+        GDEBUG("%s lane %d: %u tx thread(s)", self->dev, lane, max_threads);
+
+        /* Lock */
+        g_mutex_lock(&priv->tx_pool_mutex);
+        priv->tx_threads[lane] = MIN(max_threads, G_MAXINT);
+        ok = gbinder_ipc_tx_pool_update_locked(priv, lane);
+        g_mutex_unlock(&priv->tx_pool_mutex);
+        /* Unlock */
+
+        return ok;
+    }
+    return FALSE;
+}
+
+gboolean
+gbinder_ipc_set_thread_attr(
+    GBinderIpc* self,
+    const GBinderThreadAttr* attr) /* Since 1.1.51 */
+{
+    if (G_LIKELY(self)) {
+        GBinderThreadAttrPriv* priv_attr = gbinder_thread_attr_new(attr);
+
+        if (priv_attr || !attr) {
+            GBinderIpcPriv* priv = self->priv;
+            GBinderThreadAttrPriv* prev;
+
+            /* Lock */
+            g_mutex_lock(&priv->tx_pool_mutex);
+            prev = priv->thread_attr;
+            g_atomic_pointer_set(&priv->thread_attr, priv_attr);
+            g_mutex_unlock(&priv->tx_pool_mutex);
+            /* Unlock */
+
+            gbinder_thread_attr_unref(prev);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+guint
+gbinder_ipc_get_tx_threads(
+    GBinderIpc* self,
+    GBINDER_TX_LANE lane) /* Since 1.1.51 */
+{
+    if (G_LIKELY(self) && (guint)lane < GBINDER_IPC_TX_LANES) {
+        GBinderIpcPriv* priv = self->priv;
+        guint n = 0;
+
+        /* Lock */
+        g_mutex_lock(&priv->tx_pool_mutex);
+        if (priv->tx_pool[lane]) {
+            /* Abandoned workers are not counted */
+            n = (priv->tx_threads[lane] < 0) ? G_MAXUINT :
+                (guint)priv->tx_threads[lane];
+        }
+        g_mutex_unlock(&priv->tx_pool_mutex);
+        /* Unlock */
+
+        return n;
+    }
+    return 0;
+}
+
+guint
+gbinder_ipc_get_tx_abandoned(
+    GBinderIpc* self,
+    GBINDER_TX_LANE lane)
+{
+    if (G_LIKELY(self) && (guint)lane < GBINDER_IPC_TX_LANES) {
+        GBinderIpcPriv* priv = self->priv;
+        guint n;
+
+        /* Lock */
+        g_mutex_lock(&priv->tx_pool_mutex);
+        n = priv->tx_abandoned[lane];
+        g_mutex_unlock(&priv->tx_pool_mutex);
+        /* Unlock */
+
+        return n;
+    }
+    return 0;
+}
+
+void
+gbinder_ipc_set_blocking_loopers(
+    GBinderIpc* self,
+    gboolean blocking)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    priv->blocking_loopers = blocking;
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
+}
+
+void
+gbinder_ipc_set_main_loop_polling(
+    GBinderIpc* self,
+    gboolean polling)
+{
+    GBinderIpcPriv* priv = self->priv;
+
+    /* Lock */
+    g_mutex_lock(&priv->looper_mutex);
+    priv->main_loop_polling = polling;
+    g_mutex_unlock(&priv->looper_mutex);
+    /* Unlock */
 }
 
 /*==========================================================================*
  * Internals
  *==========================================================================*/
 
+static
+gpointer
+gbinder_ipc_shards_new(
+    gsize shard_size)
+{
+    const gsize size = shard_size * GBINDER_IPC_REGISTRY_SHARDS;
+    void* shards = NULL;
+
+    if (posix_memalign(&shards, GBINDER_IPC_CACHE_LINE, size)) {
+        g_error("Failed to allocate %u bytes", (guint)size);
+    }
+    memset(shards, 0, size);
+    return shards;
+}
+
 static
 void
 gbinder_ipc_init(
@@ -2053,13 +3567,28 @@ gbinder_ipc_init(
     };
     GBinderIpcPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self, THIS_TYPE,
         GBinderIpcPriv);
+    int i;
 
     g_mutex_init(&priv->looper_mutex);
-    g_mutex_init(&priv->local_objects_mutex);
-    g_mutex_init(&priv->remote_objects_mutex);
+    g_mutex_init(&priv->stats_mutex);
+    g_mutex_init(&priv->tx_pool_mutex);
+    priv->local_objects = gbinder_ipc_shards_new
+        (sizeof(GBinderIpcRegistryShard));
+    priv->remote_objects = gbinder_ipc_shards_new
+        (sizeof(GBinderIpcRemoteShard));
+    for (i = 0; i < GBINDER_IPC_REGISTRY_SHARDS; i++) {
+        g_mutex_init(&priv->local_objects[i].s.mutex);
+        g_mutex_init(&priv->remote_objects[i].s.mutex);
+    }
     priv->tx_table = g_hash_table_new(g_direct_hash, g_direct_equal);
-    priv->tx_pool = g_thread_pool_new(gbinder_ipc_tx_proc, self,
-        GBINDER_IPC_MAX_TX_THREADS, FALSE, NULL);
+    priv->oneway_queue = g_ptr_array_new();
+    priv->tx_threads[GBINDER_TX_LANE_NORMAL] = GBINDER_IPC_MAX_TX_THREADS;
+    priv->tx_threads[GBINDER_TX_LANE_URGENT] =
+        GBINDER_IPC_MAX_URGENT_TX_THREADS;
+    for (i = 0; i < GBINDER_IPC_TX_LANES; i++) {
+        priv->tx_pool[i] = g_thread_pool_new(gbinder_ipc_tx_proc, self,
+            priv->tx_threads[i], FALSE, NULL);
+    }
     priv->object_registry.f = &object_registry_functions;
     priv->self = self;
     self->priv = priv;
@@ -2073,6 +3602,7 @@ gbinder_ipc_stop_loopers(
     GBinderIpcPriv* priv = self->priv;
     GBinderIpcLooper* loopers = NULL;
 
+    gbinder_ipc_poll_stop(self);
     do {
         GBinderIpcLooper* tmp;
 
@@ -2136,17 +3666,32 @@ gbinder_ipc_finalize(
 {
     GBinderIpc* self = THIS(object);
     GBinderIpcPriv* priv = self->priv;
+    int i;
 
-    GASSERT(!priv->local_objects);
-    GASSERT(!priv->remote_objects);
     g_mutex_clear(&priv->looper_mutex);
-    g_mutex_clear(&priv->local_objects_mutex);
-    g_mutex_clear(&priv->remote_objects_mutex);
-    if (priv->tx_pool) {
-        g_thread_pool_free(priv->tx_pool, FALSE, TRUE);
+    g_mutex_clear(&priv->stats_mutex);
+    g_mutex_clear(&priv->tx_pool_mutex);
+    gbinder_thread_attr_unref(priv->thread_attr);
+    for (i = 0; i < GBINDER_IPC_REGISTRY_SHARDS; i++) {
+        GASSERT(!priv->local_objects[i].s.table);
+        GASSERT(!priv->remote_objects[i].s.count);
+        GASSERT(!priv->remote_objects[i].s.objects);
+        g_mutex_clear(&priv->local_objects[i].s.mutex);
+        g_mutex_clear(&priv->remote_objects[i].s.mutex);
+    }
+    free(priv->local_objects);
+    free(priv->remote_objects);
+    for (i = 0; i < GBINDER_IPC_TX_LANES; i++) {
+        if (priv->tx_pool[i]) {
+            g_thread_pool_free(priv->tx_pool[i], FALSE, TRUE);
+        }
     }
     GASSERT(!g_hash_table_size(priv->tx_table));
     g_hash_table_unref(priv->tx_table);
+    GASSERT(!priv->oneway_flush);
+    GASSERT(!priv->completed);
+    GASSERT(!priv->oneway_queue->len);
+    g_ptr_array_free(priv->oneway_queue, TRUE);
     gbinder_driver_unref(self->driver);
     g_free(priv->dev);
     g_free(priv->key);
@@ -2170,7 +3715,7 @@ void
 gbinder_ipc_exit()
 {
     GHashTableIter it;
-    gpointer key, value;
+    gpointer value;
     GSList* ipcs = NULL;
     GSList* i;
 
@@ -2189,55 +3734,67 @@ gbinder_ipc_exit()
         GBinderIpc* ipc = THIS(i->data);
         GBinderIpcPriv* priv = ipc->priv;
         GSList* local_objs = NULL;
-        GSList* tx_keys = NULL;
-        GSList* k;
+        GBinderIpcTxPriv* tx;
+        GBinderIpcTxPriv* next;
         GSList* l;
+        int k;
 
         /* Terminate looper threads */
         GVERBOSE_("%s", ipc->dev);
         gbinder_ipc_stop_loopers(ipc);
 
         /* Make sure pooled transaction complete too */
-        if (priv->tx_pool) {
-            GThreadPool* pool = priv->tx_pool;
+        for (k = 0; k < GBINDER_IPC_TX_LANES; k++) {
+            GThreadPool* pool;
+
+            /* Lock */
+            g_mutex_lock(&priv->tx_pool_mutex);
+            pool = priv->tx_pool[k];
+            priv->tx_pool[k] = NULL;
+            g_mutex_unlock(&priv->tx_pool_mutex);
+            /* Unlock */
+
+            if (pool) {
+                g_thread_pool_free(pool, FALSE, TRUE);
+            }
+        }
 
-            priv->tx_pool = NULL;
-            g_thread_pool_free(pool, FALSE, TRUE);
+        /* Drop the one-way transactions which haven't been sent yet */
+        if (priv->oneway_flush) {
+            GPtrArray* queue = priv->oneway_queue;
+            guint n;
+
+            gbinder_idle_callback_destroy(priv->oneway_flush);
+            priv->oneway_flush = NULL;
+            priv->oneway_queue = g_ptr_array_new();
+            for (n = 0; n < queue->len; n++) {
+                GBinderIpcTxPriv* tx = queue->pdata[n];
+
+                GVERBOSE_("tx %lu", tx->pub.id);
+                gbinder_ipc_tx_free(tx);
+            }
+            g_ptr_array_free(queue, TRUE);
         }
 
         /*
          * Since this function is supposed to be invoked on the main thread,
          * there's no need to synchronize access to priv->tx_table. In any
-         * case, this must be the last thread associated with this object.
+         * case, this must be the last thread associated with this object
+         * and all pooled transactions are sitting in the completion queue.
+         * The idle callback will find the queue empty.
          */
-        g_hash_table_iter_init(&it, priv->tx_table);
-        while (g_hash_table_iter_next(&it, &key, NULL)) {
-            tx_keys = g_slist_append(tx_keys, key);
-        }
-        for (k = tx_keys; k; k = k->next) {
-            GBinderIpcTxPriv* tx = g_hash_table_lookup(priv->tx_table, k->data);
-
+        for (tx = gbinder_ipc_tx_completed_take(priv); tx; tx = next) {
+            next = tx->next;
             GVERBOSE_("tx %lu", tx->pub.id);
-            gbinder_idle_callback_cancel(tx->completion);
+            g_atomic_int_add(&priv->completed_depth, -1);
+            gbinder_ipc_tx_free(tx);
         }
 
         /* The above loop must destroy all uncompleted transactions */
         GASSERT(!g_hash_table_size(priv->tx_table));
-        g_slist_free(tx_keys);
-
-        /* Lock */
-        g_mutex_lock(&priv->local_objects_mutex);
-        if (priv->local_objects) {
-            g_hash_table_iter_init(&it, priv->local_objects);
-            while (g_hash_table_iter_next(&it, NULL, &value)) {
-                local_objs = g_slist_append(local_objs,
-                    gbinder_local_object_ref(value));
-            }
-        }
-        g_mutex_unlock(&priv->local_objects_mutex);
-        /* Unlock */
 
         /* Drop remote references */
+        local_objs = gbinder_ipc_priv_local_objects(priv);
         for (l = local_objs; l; l = l->next) {
             GBinderLocalObject* obj = GBINDER_LOCAL_OBJECT(l->data);
 
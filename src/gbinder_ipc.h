@@ -35,6 +35,8 @@
 
 #include "gbinder_types_p.h"
 
+#include <gbinder_threads.h>
+
 #include <glib-object.h>
 
 typedef struct gbinder_ipc_priv GBinderIpcPriv;
@@ -201,6 +203,30 @@ gbinder_ipc_transact(
     void* user_data)
     GBINDER_INTERNAL;
 
+/* Deadlines are g_get_monotonic_time() based, zero means no deadline */
+gulong
+gbinder_ipc_transact_deadline(
+    GBinderIpc* ipc,
+    guint32 handle,
+    guint32 code,
+    guint32 flags, /* GBINDER_TX_FLAG_xxx */
+    GBinderLocalRequest* req,
+    GBinderIpcReplyFunc func,
+    GDestroyNotify destroy,
+    void* user_data,
+    gint64 deadline)
+    GBINDER_INTERNAL;
+
+GBinderRemoteReply*
+gbinder_ipc_transact_sync_reply_deadline(
+    GBinderIpc* ipc,
+    guint32 handle,
+    guint32 code,
+    GBinderLocalRequest* req,
+    int* status,
+    gint64 deadline)
+    GBINDER_INTERNAL;
+
 gulong
 gbinder_ipc_transact_custom(
     GBinderIpc* ipc,
@@ -236,13 +262,77 @@ gbinder_ipc_remote_object_disposed(
     GBinderRemoteObject* obj)
     GBINDER_INTERNAL;
 
-/* Needed by unit tests */
+/*
+ * Limits the number of transaction worker threads and the number of
+ * additional loopers which the kernel may ask us to spawn. Negative
+ * value removes the limit for the workers, but the number of spawned
+ * loopers is still capped (by 15). Zero disables both.
+ */
 gboolean
 gbinder_ipc_set_max_threads(
     GBinderIpc* ipc,
     gint max_threads)
     GBINDER_INTERNAL;
 
+/* Number of workers stuck in transactions which have timed out */
+guint
+gbinder_ipc_get_tx_abandoned(
+    GBinderIpc* ipc,
+    GBINDER_TX_LANE lane)
+    GBINDER_INTERNAL;
+
+/*
+ * Makes the primary loopers block in BINDER_WRITE_READ rather than
+ * poll the binder fd. Only affects the loopers started after this call.
+ */
+void
+gbinder_ipc_set_blocking_loopers(
+    GBinderIpc* ipc,
+    gboolean blocking)
+    GBINDER_INTERNAL;
+
+/*
+ * Handle incoming commands on the main thread instead of starting the
+ * loopers. Must be called before the loopers are needed (i.e. before
+ * any local objects are created).
+ */
+void
+gbinder_ipc_set_main_loop_polling(
+    GBinderIpc* ipc,
+    gboolean polling)
+    GBINDER_INTERNAL;
+
+/* Handler time of an incoming transaction, for gbinder_ipc_get_stats() */
+void
+gbinder_ipc_stats_incoming(
+    GBinderIpc* ipc,
+    gint64 usec)
+    GBINDER_INTERNAL;
+
+/* Whether transaction statistics are being collected */
+gboolean
+gbinder_ipc_stats_enabled(
+    GBinderIpc* ipc)
+    GBINDER_INTERNAL;
+
+void
+gbinder_ipc_set_stats(
+    GBinderIpc* ipc,
+    gboolean enabled)
+    GBINDER_INTERNAL;
+
+/* Whether local objects answer GBINDER_STATS_TRANSACTION */
+gboolean
+gbinder_ipc_stats_transaction_enabled(
+    GBinderIpc* ipc)
+    GBINDER_INTERNAL;
+
+void
+gbinder_ipc_set_stats_transaction(
+    GBinderIpc* ipc,
+    gboolean enabled)
+    GBINDER_INTERNAL;
+
 /* Declared for unit tests */
 void
 gbinder_ipc_exit(
@@ -30,6 +30,8 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#define _GNU_SOURCE  /* SCHED_BATCH */
+
 #include "gbinder_driver.h"
 #include "gbinder_ipc.h"
 #include "gbinder_buffer_p.h"
@@ -37,18 +39,27 @@
 #include "gbinder_local_reply_p.h"
 #include "gbinder_remote_request.h"
 #include "gbinder_eventloop_p.h"
+#include "gbinder_stats_p.h"
+#include "gbinder_trace_p.h"
 #include "gbinder_writer.h"
 #include "gbinder_log.h"
 
 #include <gutil_strv.h>
 #include <gutil_macros.h>
 
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 struct gbinder_local_object_priv {
     char** ifaces;
     GBinderLocalTransactFunc txproc;
     void* user_data;
+    GBINDER_LOCAL_OBJECT_FLAGS flags;
+    GMutex stats_mutex;
+    GBinderStatsLatency stats;
+    GHashTable* code_stats;
 };
 
 typedef struct gbinder_local_object_acquire_data {
@@ -96,6 +107,26 @@ gbinder_local_object_create_reply(
         gbinder_local_object_protocol(self));
 }
 
+/*
+ * Interface names parsed from the RPC header are interned (unless the
+ * interface cache has overflown) so normally the pointers are equal.
+ * Otherwise, strcmp() is likely to bail out at the first few characters.
+ */
+static
+gboolean
+gbinder_local_object_is_hidl_base(
+    const char* iface)
+{
+    static gsize hidl_base_interned = 0;
+
+    if (g_once_init_enter(&hidl_base_interned)) {
+        g_once_init_leave(&hidl_base_interned, (gsize)
+            g_intern_static_string(hidl_base_interface));
+    }
+    return iface && (iface == (const char*)hidl_base_interned ||
+        !strcmp(iface, hidl_base_interface));
+}
+
 static
 GBINDER_LOCAL_TRANSACTION_SUPPORT
 gbinder_local_object_default_can_handle_transaction(
@@ -103,6 +134,13 @@ gbinder_local_object_default_can_handle_transaction(
     const char* iface,
     guint code)
 {
+    GBinderLocalObjectPriv* priv = self->priv;
+
+    if (code == GBINDER_STATS_TRANSACTION &&
+        gbinder_ipc_stats_transaction_enabled(self->ipc)) {
+        return GBINDER_LOCAL_TRANSACTION_LOOPER;
+    }
+
     switch (code) {
     case GBINDER_PING_TRANSACTION:
     case GBINDER_INTERFACE_TRANSACTION:
@@ -110,13 +148,17 @@ gbinder_local_object_default_can_handle_transaction(
     case HIDL_PING_TRANSACTION:
     case HIDL_GET_DESCRIPTOR_TRANSACTION:
     case HIDL_DESCRIPTOR_CHAIN_TRANSACTION:
-        if (!g_strcmp0(iface, hidl_base_interface)) {
+        if (gbinder_local_object_is_hidl_base(iface)) {
             return GBINDER_LOCAL_TRANSACTION_LOOPER;
         }
         /* no break */
     default:
-        return self->priv->txproc ? GBINDER_LOCAL_TRANSACTION_SUPPORTED :
-            GBINDER_LOCAL_TRANSACTION_NOT_SUPPORTED;
+        if (priv->txproc) {
+            return (priv->flags & GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD) ?
+                GBINDER_LOCAL_TRANSACTION_DIRECT :
+                GBINDER_LOCAL_TRANSACTION_SUPPORTED;
+        }
+        return GBINDER_LOCAL_TRANSACTION_NOT_SUPPORTED;
     }
 }
 
@@ -230,6 +272,41 @@ gbinder_local_object_hidl_descriptor_chain_transaction(
     return reply;
 }
 
+static
+GBinderLocalReply*
+gbinder_local_object_stats_transaction(
+    GBinderLocalObject* self,
+    GBinderRemoteRequest* req,
+    int* status)
+{
+    GBinderLocalReply* reply = gbinder_local_object_create_reply(self);
+    GString* buf = g_string_new(NULL);
+    GBinderStatsLatency latency;
+    GBinderStats stats;
+    guint32* codes;
+    guint i, n;
+
+    GVERBOSE("  STATS_TRANSACTION");
+    gbinder_ipc_get_stats(self->ipc, &stats);
+    gbinder_stats_append(buf, &stats);
+    gbinder_local_object_get_stats(self, &latency);
+    gbinder_stats_append_latency(buf, "object", &latency);
+    codes = gbinder_local_object_get_stats_codes(self, &n);
+    for (i = 0; i < n; i++) {
+        char* name = g_strdup_printf("object.code_%u", codes[i]);
+
+        gbinder_local_object_get_code_stats(self, codes[i], &latency);
+        gbinder_stats_append_latency(buf, name, &latency);
+        g_free(name);
+    }
+    g_free(codes);
+
+    gbinder_local_reply_append_string16(reply, buf->str);
+    g_string_free(buf, TRUE);
+    *status = GBINDER_STATUS_OK;
+    return reply;
+}
+
 static
 GBinderLocalReply*
 gbinder_local_object_default_handle_looper_transaction(
@@ -257,6 +334,9 @@ gbinder_local_object_default_handle_looper_transaction(
     case HIDL_DESCRIPTOR_CHAIN_TRANSACTION:
         handler = gbinder_local_object_hidl_descriptor_chain_transaction;
         break;
+    case GBINDER_STATS_TRANSACTION:
+        handler = gbinder_local_object_stats_transaction;
+        break;
     default:
         if (status) *status = (-EBADMSG);
         return NULL;
@@ -391,8 +471,20 @@ gbinder_local_object_new(
     GBinderLocalTransactFunc txproc,
     void* user_data) /* Since 1.0.30 */
 {
-    return gbinder_local_object_new_with_type(GBINDER_TYPE_LOCAL_OBJECT,
-        ipc, ifaces, txproc, user_data);
+    return gbinder_local_object_new2(ipc, ifaces, txproc, user_data,
+        GBINDER_LOCAL_OBJECT_FLAGS_NONE);
+}
+
+GBinderLocalObject*
+gbinder_local_object_new2(
+    GBinderIpc* ipc,
+    const char* const* ifaces,
+    GBinderLocalTransactFunc txproc,
+    void* user_data,
+    GBINDER_LOCAL_OBJECT_FLAGS flags) /* Since 1.1.51 */
+{
+    return gbinder_local_object_new_with_type2(GBINDER_TYPE_LOCAL_OBJECT,
+        ipc, ifaces, txproc, user_data, flags);
 }
 
 GBinderLocalObject*
@@ -402,11 +494,26 @@ gbinder_local_object_new_with_type(
     const char* const* ifaces,
     GBinderLocalTransactFunc txproc,
     void* arg)
+{
+    return gbinder_local_object_new_with_type2(type, ipc, ifaces, txproc, arg,
+        GBINDER_LOCAL_OBJECT_FLAGS_NONE);
+}
+
+GBinderLocalObject*
+gbinder_local_object_new_with_type2(
+    GType type,
+    GBinderIpc* ipc,
+    const char* const* ifaces,
+    GBinderLocalTransactFunc txproc,
+    void* arg,
+    GBINDER_LOCAL_OBJECT_FLAGS flags)
 {
     if (G_LIKELY(ipc)) {
         GBinderLocalObject* obj = g_object_new(type, NULL);
 
         gbinder_local_object_init_base(obj, ipc, ifaces, txproc, arg);
+        /* Flags must be set before the object becomes visible to loopers */
+        obj->priv->flags = flags;
         gbinder_ipc_register_local_object(ipc, obj);
         return obj;
     }
@@ -532,6 +639,39 @@ gbinder_local_object_can_handle_transaction(
             (self, iface, code) : GBINDER_LOCAL_TRANSACTION_NOT_SUPPORTED;
 }
 
+static
+void
+gbinder_local_object_stats_add(
+    GBinderLocalObject* self,
+    guint code,
+    gint64 start)
+{
+    GBinderLocalObjectPriv* priv = self->priv;
+    const gint64 usec = g_get_monotonic_time() - start;
+    GBinderStatsLatency* latency;
+
+    /* Lock */
+    g_mutex_lock(&priv->stats_mutex);
+    gbinder_stats_latency_add(&priv->stats, usec);
+    if (!priv->code_stats) {
+        priv->code_stats = g_hash_table_new_full(g_direct_hash,
+            g_direct_equal, NULL, g_free);
+    }
+    latency = g_hash_table_lookup(priv->code_stats, GUINT_TO_POINTER(code));
+    if (!latency) {
+        latency = g_new0(GBinderStatsLatency, 1);
+        g_hash_table_insert(priv->code_stats, GUINT_TO_POINTER(code),
+            latency);
+    }
+    gbinder_stats_latency_add(latency, usec);
+    g_mutex_unlock(&priv->stats_mutex);
+    /* Unlock */
+
+    if (self->ipc) {
+        gbinder_ipc_stats_incoming(self->ipc, usec);
+    }
+}
+
 GBinderLocalReply*
 gbinder_local_object_handle_transaction(
     GBinderLocalObject* self,
@@ -541,8 +681,20 @@ gbinder_local_object_handle_transaction(
     int* status)
 {
     if (G_LIKELY(self)) {
-        return GBINDER_LOCAL_OBJECT_GET_CLASS(self)->handle_transaction
-            (self, req, code, flags, status);
+        gint64 start;
+        GBinderLocalReply* reply;
+
+        GBINDER_TRACE(GBINDER_TRACE_HANDLER_START, (uintptr_t)self, code, 0);
+        start = gbinder_ipc_stats_enabled(self->ipc) ?
+            g_get_monotonic_time() : 0;
+        reply = GBINDER_LOCAL_OBJECT_GET_CLASS(self)->
+            handle_transaction(self, req, code, flags, status);
+        if (start) {
+            gbinder_local_object_stats_add(self, code, start);
+        }
+        GBINDER_TRACE(GBINDER_TRACE_HANDLER_END, (uintptr_t)self, code,
+            status ? *status : 0);
+        return reply;
     } else {
         if (status) *status = (-EBADMSG);
         return NULL;
@@ -558,8 +710,20 @@ gbinder_local_object_handle_looper_transaction(
     int* status)
 {
     if (G_LIKELY(self)) {
-        return GBINDER_LOCAL_OBJECT_GET_CLASS(self)->handle_looper_transaction
-            (self, req, code, flags, status);
+        gint64 start;
+        GBinderLocalReply* reply;
+
+        GBINDER_TRACE(GBINDER_TRACE_HANDLER_START, (uintptr_t)self, code, 0);
+        start = gbinder_ipc_stats_enabled(self->ipc) ?
+            g_get_monotonic_time() : 0;
+        reply = GBINDER_LOCAL_OBJECT_GET_CLASS(self)->
+            handle_looper_transaction(self, req, code, flags, status);
+        if (start) {
+            gbinder_local_object_stats_add(self, code, start);
+        }
+        GBINDER_TRACE(GBINDER_TRACE_HANDLER_END, (uintptr_t)self, code,
+            status ? *status : 0);
+        return reply;
     } else {
         if (status) *status = -EBADMSG;
         return NULL;
@@ -625,6 +789,145 @@ gbinder_local_object_set_stability(
     }
 }
 
+gboolean
+gbinder_local_object_set_min_sched_policy(
+    GBinderLocalObject* self,
+    int policy,
+    int priority) /* Since 1.1.51 */
+{
+    if (G_LIKELY(self)) {
+        switch (policy) {
+        case SCHED_OTHER:
+        case SCHED_BATCH:
+            /* The priority is the nice value */
+            if (priority >= -20 && priority <= 19) {
+                break;
+            }
+            return FALSE;
+        case SCHED_FIFO:
+        case SCHED_RR:
+            if (priority >= 1 && priority <= 99) {
+                break;
+            }
+            return FALSE;
+        default:
+            return FALSE;
+        }
+        self->min_sched_policy = policy;
+        self->min_sched_priority = priority;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+void
+gbinder_local_object_set_inherit_rt(
+    GBinderLocalObject* self,
+    gboolean inherit_rt) /* Since 1.1.51 */
+{
+    if (G_LIKELY(self)) {
+        self->inherit_rt = inherit_rt;
+    }
+}
+
+void
+gbinder_local_object_get_stats(
+    GBinderLocalObject* self,
+    GBinderStatsLatency* stats) /* Since 1.1.51 */
+{
+    if (G_LIKELY(stats)) {
+        if (G_LIKELY(self)) {
+            GBinderLocalObjectPriv* priv = self->priv;
+
+            /* Lock */
+            g_mutex_lock(&priv->stats_mutex);
+            *stats = priv->stats;
+            g_mutex_unlock(&priv->stats_mutex);
+            /* Unlock */
+        } else {
+            memset(stats, 0, sizeof(*stats));
+        }
+    }
+}
+
+gboolean
+gbinder_local_object_get_code_stats(
+    GBinderLocalObject* self,
+    guint32 code,
+    GBinderStatsLatency* stats) /* Since 1.1.51 */
+{
+    gboolean found = FALSE;
+
+    if (G_LIKELY(self)) {
+        GBinderLocalObjectPriv* priv = self->priv;
+
+        /* Lock */
+        g_mutex_lock(&priv->stats_mutex);
+        if (priv->code_stats) {
+            const GBinderStatsLatency* latency = g_hash_table_lookup
+                (priv->code_stats, GUINT_TO_POINTER(code));
+
+            if (latency) {
+                if (stats) *stats = *latency;
+                found = TRUE;
+            }
+        }
+        g_mutex_unlock(&priv->stats_mutex);
+        /* Unlock */
+    }
+    if (!found && stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+    return found;
+}
+
+static
+int
+gbinder_local_object_code_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const guint32 code1 = *(const guint32*)a;
+    const guint32 code2 = *(const guint32*)b;
+
+    return (code1 < code2) ? -1 : (code1 > code2) ? 1 : 0;
+}
+
+guint32*
+gbinder_local_object_get_stats_codes(
+    GBinderLocalObject* self,
+    guint* count) /* Since 1.1.51 */
+{
+    guint32* codes = NULL;
+    guint n = 0;
+
+    if (G_LIKELY(self)) {
+        GBinderLocalObjectPriv* priv = self->priv;
+
+        /* Lock */
+        g_mutex_lock(&priv->stats_mutex);
+        if (priv->code_stats) {
+            GHashTableIter it;
+            gpointer key;
+
+            codes = g_new(guint32, g_hash_table_size(priv->code_stats));
+            g_hash_table_iter_init(&it, priv->code_stats);
+            while (g_hash_table_iter_next(&it, &key, NULL)) {
+                codes[n++] = GPOINTER_TO_UINT(key);
+            }
+        }
+        g_mutex_unlock(&priv->stats_mutex);
+        /* Unlock */
+
+        if (n) {
+            qsort(codes, n, sizeof(codes[0]),
+                gbinder_local_object_code_compare);
+        }
+    }
+    if (count) *count = n;
+    return codes;
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -637,7 +940,9 @@ gbinder_local_object_init(
     GBinderLocalObjectPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self,
         GBINDER_TYPE_LOCAL_OBJECT, GBinderLocalObjectPriv);
 
+    g_mutex_init(&priv->stats_mutex);
     self->priv = priv;
+    self->min_sched_policy = -1;
 }
 
 static
@@ -663,6 +968,10 @@ gbinder_local_object_finalize(
     gbinder_ipc_invalidate_local_object(self->ipc, self);
     gbinder_ipc_unref(self->ipc);
     g_strfreev(priv->ifaces);
+    if (priv->code_stats) {
+        g_hash_table_destroy(priv->code_stats);
+    }
+    g_mutex_clear(&priv->stats_mutex);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
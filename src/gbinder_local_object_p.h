@@ -60,12 +60,16 @@ struct gbinder_local_object {
     gint weak_refs;
     gint strong_refs;
     GBINDER_STABILITY_LEVEL stability;
+    int min_sched_policy; /* Negative if not set */
+    int min_sched_priority;
+    gboolean inherit_rt;
 };
 
 typedef enum gbinder_local_transaction_support {
     GBINDER_LOCAL_TRANSACTION_NOT_SUPPORTED,
     GBINDER_LOCAL_TRANSACTION_SUPPORTED,     /* On the main thread */
-    GBINDER_LOCAL_TRANSACTION_LOOPER         /* On the looper thread */
+    GBINDER_LOCAL_TRANSACTION_LOOPER,        /* On the looper thread */
+    GBINDER_LOCAL_TRANSACTION_DIRECT         /* Handler on the looper thread */
 } GBINDER_LOCAL_TRANSACTION_SUPPORT;
 
 typedef struct gbinder_local_object_class {
@@ -105,6 +109,16 @@ gbinder_local_object_new_with_type(
     void* user_data)
     GBINDER_INTERNAL;
 
+GBinderLocalObject*
+gbinder_local_object_new_with_type2(
+    GType type,
+    GBinderIpc* ipc,
+    const char* const* ifaces,
+    GBinderLocalTransactFunc txproc,
+    void* user_data,
+    GBINDER_LOCAL_OBJECT_FLAGS flags)
+    GBINDER_INTERNAL;
+
 void
 gbinder_local_object_init_base(
     GBinderLocalObject* self,
@@ -33,6 +33,7 @@
 #include "gbinder_local_reply_p.h"
 #include "gbinder_output_data.h"
 #include "gbinder_writer_p.h"
+#include "gbinder_recycler.h"
 #include "gbinder_buffer_p.h"
 #include "gbinder_log.h"
 
@@ -44,8 +45,30 @@ struct gbinder_local_reply {
     GBinderWriterData data;
     GBinderOutputData out;
     GBinderBufferContents* contents;
+    GBinderRecyclerLink link; /* For recycling */
 };
 
+/* Same process-wide recycling as for GBinderLocalRequest */
+#define GBINDER_LOCAL_REPLY_POOL_MAX (8)
+
+static GBinderRecycler gbinder_local_reply_pool =
+    GBINDER_RECYCLER_INIT(GBINDER_LOCAL_REPLY_POOL_MAX);
+
+static
+void
+gbinder_local_reply_destroy(
+    GBinderLocalReply* self)
+{
+    GBinderWriterData* data = &self->data;
+
+    gutil_int_array_free(data->offsets, TRUE);
+    g_byte_array_free(data->bytes, TRUE);
+    gbinder_cleanup_free(data->cleanup);
+    gbinder_arena_clear(&data->arena);
+    gbinder_buffer_contents_unref(self->contents);
+    gutil_slice_free(self);
+}
+
 GBINDER_INLINE_FUNC
 GBinderLocalReply*
 gbinder_local_reply_output_cast(
@@ -59,7 +82,11 @@ GUtilIntArray*
 gbinder_local_reply_output_offsets(
     GBinderOutputData* out)
 {
-    return gbinder_local_reply_output_cast(out)->data.offsets;
+    GUtilIntArray* offsets =
+        gbinder_local_reply_output_cast(out)->data.offsets;
+
+    /* Recycled objects may have an empty array */
+    return (offsets && offsets->count) ? offsets : NULL;
 }
 
 static
@@ -78,19 +105,31 @@ gbinder_local_reply_new(
     GASSERT(io);
     GASSERT(protocol);
     if (io && protocol) {
-        GBinderLocalReply* self = g_slice_new0(GBinderLocalReply);
-        GBinderWriterData* data = &self->data;
-        GBinderOutputData* out = &self->out;
+        GBinderRecyclerLink* link =
+            gbinder_recycler_take(&gbinder_local_reply_pool);
+        GBinderLocalReply* self;
+        GBinderWriterData* data;
+        GBinderOutputData* out;
 
         static const GBinderOutputDataFunctions local_reply_output_fn = {
             .offsets = gbinder_local_reply_output_offsets,
             .buffers_size = gbinder_local_reply_output_buffers_size
         };
 
+        if (link) {
+            /* Recycled reply, already reset */
+            self = G_CAST(link, GBinderLocalReply, link);
+            data = &self->data;
+        } else {
+            self = g_slice_new0(GBinderLocalReply);
+            data = &self->data;
+            data->bytes = g_byte_array_new();
+        }
+        out = &self->out;
         g_atomic_int_set(&self->refcount, 1);
         data->io = io;
         data->protocol = protocol;
-        out->bytes = data->bytes = g_byte_array_new();
+        out->bytes = data->bytes;
         out->f = &local_reply_output_fn;
         return self;
     }
@@ -117,13 +156,14 @@ void
 gbinder_local_reply_free(
     GBinderLocalReply* self)
 {
-    GBinderWriterData* data = &self->data;
-
-    gutil_int_array_free(data->offsets, TRUE);
-    g_byte_array_free(data->bytes, TRUE);
-    gbinder_cleanup_free(data->cleanup);
-    gbinder_buffer_contents_unref(self->contents);
-    gutil_slice_free(self);
+    if (gbinder_writer_data_reset(&self->data)) {
+        gbinder_buffer_contents_unref(self->contents);
+        self->contents = NULL;
+        if (gbinder_recycler_put(&gbinder_local_reply_pool, &self->link)) {
+            return;
+        }
+    }
+    gbinder_local_reply_destroy(self);
 }
 
 GBinderLocalReply*
@@ -163,6 +203,21 @@ gbinder_local_reply_contents(
     return G_LIKELY(self) ? self->contents :  NULL;
 }
 
+/* Runs at exit */
+void
+gbinder_local_reply_exit()
+{
+    GBinderRecyclerLink* link =
+        gbinder_recycler_drain(&gbinder_local_reply_pool);
+
+    while (link) {
+        GBinderRecyclerLink* next = link->next;
+
+        gbinder_local_reply_destroy(G_CAST(link, GBinderLocalReply, link));
+        link = next;
+    }
+}
+
 void
 gbinder_local_reply_cleanup(
     GBinderLocalReply* self,
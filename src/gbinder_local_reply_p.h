@@ -60,6 +60,13 @@ gbinder_local_reply_set_contents(
     GBinderObjectConverter* convert)
     GBINDER_INTERNAL;
 
+/* Runs at exit, declared here strictly for unit tests */
+void
+gbinder_local_reply_exit(
+    void)
+    GBINDER_DESTRUCTOR
+    GBINDER_INTERNAL;
+
 #endif /* GBINDER_LOCAL_REPLY_PRIVATE_H */
 
 /*
@@ -34,6 +34,7 @@
 #include "gbinder_rpc_protocol.h"
 #include "gbinder_output_data.h"
 #include "gbinder_writer_p.h"
+#include "gbinder_recycler.h"
 #include "gbinder_buffer_p.h"
 #include "gbinder_io.h"
 #include "gbinder_log.h"
@@ -45,8 +46,35 @@ struct gbinder_local_request {
     gint refcount;
     GBinderWriterData data;
     GBinderOutputData out;
+    GBinderRecyclerLink link; /* For recycling */
 };
 
+/*
+ * Released requests are kept in a small process-wide pool, together with
+ * their byte arrays, offset arrays and cleanup storage, and handed out
+ * again by gbinder_local_request_new(). That saves a bunch of mallocs
+ * per transaction. The pool is a lock-free stack, since requests are
+ * often built on one thread and released on another.
+ */
+#define GBINDER_LOCAL_REQUEST_POOL_MAX (8)
+
+static GBinderRecycler gbinder_local_request_pool =
+    GBINDER_RECYCLER_INIT(GBINDER_LOCAL_REQUEST_POOL_MAX);
+
+static
+void
+gbinder_local_request_destroy(
+    GBinderLocalRequest* self)
+{
+    GBinderWriterData* data = &self->data;
+
+    g_byte_array_free(data->bytes, TRUE);
+    gutil_int_array_free(data->offsets, TRUE);
+    gbinder_cleanup_free(data->cleanup);
+    gbinder_arena_clear(&data->arena);
+    g_slice_free(GBinderLocalRequest, self);
+}
+
 GBINDER_INLINE_FUNC
 GBinderLocalRequest*
 gbinder_local_request_output_cast(
@@ -60,7 +88,11 @@ GUtilIntArray*
 gbinder_local_request_output_offsets(
     GBinderOutputData* out)
 {
-    return gbinder_local_request_output_cast(out)->data.offsets;
+    GUtilIntArray* offsets =
+        gbinder_local_request_output_cast(out)->data.offsets;
+
+    /* Recycled objects may have an empty array */
+    return (offsets && offsets->count) ? offsets : NULL;
 }
 
 static
@@ -80,27 +112,44 @@ gbinder_local_request_new(
     GASSERT(io);
     GASSERT(protocol);
     if (io && protocol) {
-        GBinderLocalRequest* self = g_slice_new0(GBinderLocalRequest);
-        GBinderWriterData* writer = &self->data;
-        GBinderOutputData* out = &self->out;
+        GBinderRecyclerLink* link =
+            gbinder_recycler_take(&gbinder_local_request_pool);
+        GBinderLocalRequest* self;
+        GBinderWriterData* writer;
+        GBinderOutputData* out;
 
         static const GBinderOutputDataFunctions local_request_output_fn = {
             .offsets = gbinder_local_request_output_offsets,
             .buffers_size = gbinder_local_request_output_buffers_size
         };
 
-        g_atomic_int_set(&self->refcount, 1);
-        writer->io = io;
-        writer->protocol = protocol;
-        if (init) {
-            gsize size;
-            gconstpointer data = g_bytes_get_data(init, &size);
+        if (link) {
+            /* Recycled request, already reset */
+            self = G_CAST(link, GBinderLocalRequest, link);
+            writer = &self->data;
+            if (init) {
+                gsize size;
+                gconstpointer data = g_bytes_get_data(init, &size);
 
-            writer->bytes = g_byte_array_sized_new(size);
-            g_byte_array_append(writer->bytes, data, size);
+                g_byte_array_append(writer->bytes, data, size);
+            }
         } else {
-            writer->bytes = g_byte_array_new();
+            self = g_slice_new0(GBinderLocalRequest);
+            writer = &self->data;
+            if (init) {
+                gsize size;
+                gconstpointer data = g_bytes_get_data(init, &size);
+
+                writer->bytes = g_byte_array_sized_new(size);
+                g_byte_array_append(writer->bytes, data, size);
+            } else {
+                writer->bytes = g_byte_array_new();
+            }
         }
+        out = &self->out;
+        g_atomic_int_set(&self->refcount, 1);
+        writer->io = io;
+        writer->protocol = protocol;
         out->f = &local_request_output_fn;
         out->bytes = writer->bytes;
         return self;
@@ -157,12 +206,11 @@ void
 gbinder_local_request_free(
     GBinderLocalRequest* self)
 {
-    GBinderWriterData* data = &self->data;
-
-    g_byte_array_free(data->bytes, TRUE);
-    gutil_int_array_free(data->offsets, TRUE);
-    gbinder_cleanup_free(data->cleanup);
-    g_slice_free(GBinderLocalRequest, self);
+    if (gbinder_writer_data_reset(&self->data) &&
+        gbinder_recycler_put(&gbinder_local_request_pool, &self->link)) {
+        return;
+    }
+    gbinder_local_request_destroy(self);
 }
 
 GBinderLocalRequest*
@@ -195,6 +243,21 @@ gbinder_local_request_data(
     return G_LIKELY(self) ? &self->out :  NULL;
 }
 
+/* Runs at exit */
+void
+gbinder_local_request_exit()
+{
+    GBinderRecyclerLink* link =
+        gbinder_recycler_drain(&gbinder_local_request_pool);
+
+    while (link) {
+        GBinderRecyclerLink* next = link->next;
+
+        gbinder_local_request_destroy(G_CAST(link, GBinderLocalRequest, link));
+        link = next;
+    }
+}
+
 void
 gbinder_local_request_cleanup(
     GBinderLocalRequest* self,
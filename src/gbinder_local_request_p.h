@@ -70,6 +70,13 @@ gbinder_local_request_append_contents(
     GBinderObjectConverter* convert)
     GBINDER_INTERNAL;
 
+/* Runs at exit, declared here strictly for unit tests */
+void
+gbinder_local_request_exit(
+    void)
+    GBINDER_DESTRUCTOR
+    GBINDER_INTERNAL;
+
 #endif /* GBINDER_LOCAL_REQUEST_PRIVATE_H */
 
 /*
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_PROBES_H
+#define GBINDER_PROBES_H
+
+/*
+ * USDT probes (provider "libgbinder") for bpftrace, perf and friends.
+ * They get compiled in when <sys/sdt.h> is available (unless
+ * GBINDER_NO_SDT is defined) and cost a nop each when nobody is
+ * listening. Ready-made bpftrace scripts can be found in test/bpftrace.
+ *
+ * Keep the probe arguments cheap to evaluate, they are evaluated even
+ * when the probe is not enabled.
+ */
+
+#if !defined(GBINDER_NO_SDT) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    include <sys/sdt.h>
+#    define GBINDER_HAVE_SDT 1
+#  endif
+#endif
+
+#ifdef GBINDER_HAVE_SDT
+#  define GBINDER_PROBE1(name,a1) \
+    DTRACE_PROBE1(libgbinder,name,a1)
+#  define GBINDER_PROBE2(name,a1,a2) \
+    DTRACE_PROBE2(libgbinder,name,a1,a2)
+#  define GBINDER_PROBE3(name,a1,a2,a3) \
+    DTRACE_PROBE3(libgbinder,name,a1,a2,a3)
+#  define GBINDER_PROBE4(name,a1,a2,a3,a4) \
+    DTRACE_PROBE4(libgbinder,name,a1,a2,a3,a4)
+#else
+#  define GBINDER_PROBE1(name,a1) ((void)0)
+#  define GBINDER_PROBE2(name,a1,a2) ((void)0)
+#  define GBINDER_PROBE3(name,a1,a2,a3) ((void)0)
+#  define GBINDER_PROBE4(name,a1,a2,a3,a4) ((void)0)
+#endif
+
+#endif /* GBINDER_PROBES_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -33,6 +33,7 @@
 #include "gbinder_buffer_p.h"
 #include "gbinder_io.h"
 #include "gbinder_object_registry.h"
+#include "gbinder_utf.h"
 #include "gbinder_log.h"
 
 #include <gutil_macros.h>
@@ -752,8 +753,9 @@ gbinder_reader_read_hidl_vec1(
 }
 
 const char*
-gbinder_reader_read_hidl_string_c(
-    GBinderReader* reader) /* Since 1.0.23 */
+gbinder_reader_read_hidl_string_view(
+    GBinderReader* reader,
+    gsize* len) /* Since 1.1.51 */
 {
     GBinderIoBufferObject obj;
 
@@ -767,12 +769,25 @@ gbinder_reader_read_hidl_string_c(
             obj.data == str->data.str &&
             obj.size == str->len + 1 &&
             str->data.str[str->len] == 0) {
+            if (len) {
+                *len = str->len;
+            }
             return str->data.str;
         }
     }
+    if (len) {
+        *len = 0;
+    }
     return NULL;
 }
 
+const char*
+gbinder_reader_read_hidl_string_c(
+    GBinderReader* reader) /* Since 1.0.23 */
+{
+    return gbinder_reader_read_hidl_string_view(reader, NULL);
+}
+
 char*
 gbinder_reader_read_hidl_string(
     GBinderReader* reader)
@@ -781,9 +796,10 @@ gbinder_reader_read_hidl_string(
     return g_strdup(gbinder_reader_read_hidl_string_c(reader));
 }
 
-char**
-gbinder_reader_read_hidl_string_vec(
-    GBinderReader* reader)
+const GBinderHidlString*
+gbinder_reader_read_hidl_string_vec_view(
+    GBinderReader* reader,
+    gsize* count) /* Since 1.1.51 */
 {
     GBinderIoBufferObject obj;
 
@@ -796,7 +812,12 @@ gbinder_reader_read_hidl_string_vec(
 
         if (!next && !n) {
             /* Should this be considered an error? */
-            return g_new0(char*, 1);
+            static const GBinderHidlString empty = { { 0 }, 0, 0 };
+
+            if (count) {
+                *count = 0;
+            }
+            return &empty;
         } else if (gbinder_reader_read_buffer_object(reader, &obj) &&
                    /* The second buffer (if any) contains n hidl_string's */
                    obj.parent_offset == GBINDER_HIDL_VEC_BUFFER_OFFSET &&
@@ -804,7 +825,6 @@ gbinder_reader_read_hidl_string_vec(
                    obj.data == next &&
                    obj.size == (sizeof(GBinderHidlString) * n)) {
             const GBinderHidlString* strings = obj.data;
-            GPtrArray* list = g_ptr_array_sized_new(n + 1);
             guint i;
 
             /* Now we expect n buffers containing the actual data */
@@ -818,10 +838,7 @@ gbinder_reader_read_hidl_string_vec(
                     obj.data == s->data.str &&
                     obj.size == s->len + 1 &&
                     s->data.str[s->len] == 0) {
-                    char* name = g_strdup(s->data.str);
-
-                    g_ptr_array_add(list, name);
-                    GVERBOSE_("%u. %s", i + 1, name);
+                    GVERBOSE_("%u. %s", i + 1, s->data.str);
                 } else {
                     GWARN("Unexpected hidl_string buffer %p/%u vs %p/%u",
                         obj.data, (guint)obj.size, s->data.str, s->len);
@@ -830,15 +847,38 @@ gbinder_reader_read_hidl_string_vec(
             }
 
             if (i == n) {
-                g_ptr_array_add(list, NULL);
-                return (char**)g_ptr_array_free(list, FALSE);
+                if (count) {
+                    *count = n;
+                }
+                return strings;
             }
-
-            g_ptr_array_set_free_func(list, g_free);
-            g_ptr_array_free(list, TRUE);
         }
     }
     GWARN("Invalid hidl_vec<string>");
+    if (count) {
+        *count = 0;
+    }
+    return NULL;
+}
+
+char**
+gbinder_reader_read_hidl_string_vec(
+    GBinderReader* reader)
+{
+    gsize n;
+    const GBinderHidlString* strings =
+        gbinder_reader_read_hidl_string_vec_view(reader, &n);
+
+    if (strings) {
+        char** out = g_new(char*, n + 1);
+        gsize i;
+
+        for (i = 0; i < n; i++) {
+            out[i] = g_strdup(strings[i].data.str);
+        }
+        out[i] = NULL;
+        return out;
+    }
     return NULL;
 }
 
@@ -920,7 +960,7 @@ gbinder_reader_read_nullable_string16(
 
     if (gbinder_reader_read_nullable_string16_utf16(reader, &str, &len)) {
         if (out) {
-            *out = str ? g_utf16_to_utf8(str, len, NULL, NULL, NULL) : NULL;
+            *out = str ? gbinder_utf16_to_utf8(str, len) : NULL;
         }
         return TRUE;
     }
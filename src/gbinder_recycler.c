@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "gbinder_recycler.h"
+
+static
+void
+gbinder_recycler_push(
+    GBinderRecycler* self,
+    GBinderRecyclerLink* first,
+    GBinderRecyclerLink* last)
+{
+    GBinderRecyclerLink* top;
+
+    do {
+        top = g_atomic_pointer_get(&self->top);
+        last->next = top;
+    } while (!g_atomic_pointer_compare_and_exchange(&self->top, top, first));
+}
+
+gboolean
+gbinder_recycler_put(
+    GBinderRecycler* self,
+    GBinderRecyclerLink* link)
+{
+    if (g_atomic_int_add(&self->count, 1) < self->max) {
+        gbinder_recycler_push(self, link, link);
+        return TRUE;
+    } else {
+        g_atomic_int_add(&self->count, -1);
+        return FALSE;
+    }
+}
+
+GBinderRecyclerLink*
+gbinder_recycler_take(
+    GBinderRecycler* self)
+{
+    GBinderRecyclerLink* link;
+
+    /* Take the whole stack (popping just one entry is prone to ABA) */
+    do {
+        link = g_atomic_pointer_get(&self->top);
+    } while (link && !g_atomic_pointer_compare_and_exchange(&self->top,
+        link, NULL));
+
+    if (link) {
+        GBinderRecyclerLink* rest = link->next;
+
+        /* And put back what's left */
+        if (rest) {
+            GBinderRecyclerLink* last = rest;
+
+            while (last->next) {
+                last = last->next;
+            }
+            gbinder_recycler_push(self, rest, last);
+        }
+        g_atomic_int_add(&self->count, -1);
+        link->next = NULL;
+    }
+    return link;
+}
+
+GBinderRecyclerLink*
+gbinder_recycler_drain(
+    GBinderRecycler* self)
+{
+    GBinderRecyclerLink* link = g_atomic_pointer_get(&self->top);
+
+    /* Whatever gets released after this point is simply freed */
+    g_atomic_int_set(&self->count, self->max);
+    g_atomic_pointer_set(&self->top, NULL);
+    return link;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef GBINDER_RECYCLER_H
+#define GBINDER_RECYCLER_H
+
+#include "gbinder_types_p.h"
+
+/*
+ * Small lock-free stack of released objects waiting to be reused.
+ * The objects embed GBinderRecyclerLink and can be put back by any
+ * thread. Taking an entry detaches the whole stack and puts back the
+ * rest, which avoids the ABA problem. At most max objects are kept.
+ */
+
+typedef struct gbinder_recycler_link {
+    struct gbinder_recycler_link* next;
+} GBinderRecyclerLink;
+
+typedef struct gbinder_recycler {
+    GBinderRecyclerLink* top;
+    gint count;
+    gint max;
+} GBinderRecycler;
+
+#define GBINDER_RECYCLER_INIT(max) { NULL, 0, max }
+
+/* Returns FALSE if the recycler is full and the object has to be freed */
+gboolean
+gbinder_recycler_put(
+    GBinderRecycler* recycler,
+    GBinderRecyclerLink* link)
+    GBINDER_INTERNAL;
+
+GBinderRecyclerLink*
+gbinder_recycler_take(
+    GBinderRecycler* recycler)
+    GBINDER_INTERNAL;
+
+/* Empties the recycler for good, returns what it had */
+GBinderRecyclerLink*
+gbinder_recycler_drain(
+    GBinderRecycler* recycler)
+    GBINDER_INTERNAL;
+
+#endif /* GBINDER_RECYCLER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -32,6 +32,7 @@
 
 #include "gbinder_driver.h"
 #include "gbinder_ipc.h"
+#include "gbinder_probes.h"
 #include "gbinder_remote_object_p.h"
 #include "gbinder_servicemanager_p.h"
 #include "gbinder_eventloop_p.h"
@@ -130,6 +131,7 @@ gbinder_remote_object_handle_death_notification(
     /* This function is invoked from the looper thread, the caller has
      * checked the object pointer */
     GVERBOSE_("%p %u", self, self->handle);
+    GBINDER_PROBE2(death, self, self->handle);
     gbinder_idle_callback_invoke_later
         (gbinder_remote_object_handle_death_on_main_thread,
             gbinder_remote_object_ref(self), g_object_unref);
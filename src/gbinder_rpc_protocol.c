@@ -36,6 +36,7 @@
 #include "gbinder_reader.h"
 #include "gbinder_writer_p.h"
 #include "gbinder_config.h"
+#include "gbinder_utf.h"
 #include "gbinder_log.h"
 #include "gbinder_local_object_p.h"
 #include "gbinder_remote_object_p.h"
@@ -83,10 +84,204 @@ static const GBinderRpcProtocol DEFAULT_PROTOCOL;
 static const GBinderRpcProtocol* gbinder_rpc_protocol_default =
     &DEFAULT_PROTOCOL;
 
+/*==========================================================================*
+ * Interface name cache
+ *
+ * Each incoming transaction carries the interface name in its RPC header,
+ * and the number of distinct names seen by a process is normally small.
+ * Names are looked up by their raw bytes and handed out as interned
+ * strings, which saves the allocation (and UTF-16 => UTF-8 conversion
+ * in case of AIDL) and allows comparing them as pointers. The number of
+ * entries is capped so that a misbehaving peer can't make us intern an
+ * unlimited number of strings. Once the cache is full, names which are
+ * not there yet are handled the old way. Lookups and cache misses after
+ * the cache has filled up only take the lock in shared mode.
+ *==========================================================================*/
+
+#define GBINDER_RPC_IFACE_CACHE_MAX (256)
+
+typedef struct gbinder_rpc_iface_utf16 {
+    const gunichar2* utf16;
+    gsize len;
+} GBinderRpcIfaceUtf16;
+
+static GRWLock gbinder_rpc_iface_lock;
+static GHashTable* gbinder_rpc_iface_utf16_cache = NULL;
+static GHashTable* gbinder_rpc_iface_utf8_cache = NULL;
+
+static
+guint
+gbinder_rpc_iface_utf16_hash(
+    gconstpointer key)
+{
+    const GBinderRpcIfaceUtf16* k = key;
+    guint32 h = 2166136261u; /* FNV-1a */
+    gsize i;
+
+    for (i = 0; i < k->len; i++) {
+        h = (h ^ k->utf16[i]) * 16777619u;
+    }
+    return h;
+}
+
+static
+gboolean
+gbinder_rpc_iface_utf16_equal(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const GBinderRpcIfaceUtf16* k1 = a;
+    const GBinderRpcIfaceUtf16* k2 = b;
+
+    return k1->len == k2->len &&
+        !memcmp(k1->utf16, k2->utf16, k1->len * sizeof(gunichar2));
+}
+
+static
+const char*
+gbinder_rpc_iface_intern_utf16(
+    const gunichar2* utf16,
+    gsize len)
+{
+    GBinderRpcIfaceUtf16 key;
+    const char* iface = NULL;
+    gboolean full = FALSE;
+    char* utf8;
+
+    key.utf16 = utf16;
+    key.len = len;
+
+    /* Lock (shared, lookups are the common case) */
+    g_rw_lock_reader_lock(&gbinder_rpc_iface_lock);
+    if (gbinder_rpc_iface_utf16_cache) {
+        iface = g_hash_table_lookup(gbinder_rpc_iface_utf16_cache, &key);
+        full = g_hash_table_size(gbinder_rpc_iface_utf16_cache) >=
+            GBINDER_RPC_IFACE_CACHE_MAX;
+    }
+    g_rw_lock_reader_unlock(&gbinder_rpc_iface_lock);
+    /* Unlock */
+
+    if (iface || full) {
+        return iface;
+    }
+
+    /* Convert outside of the lock */
+    utf8 = gbinder_utf16_to_utf8(utf16, len);
+    if (utf8) {
+        GBinderRpcIfaceUtf16* found;
+
+        iface = g_intern_string(utf8);
+        g_free(utf8);
+
+        /* Lock */
+        g_rw_lock_writer_lock(&gbinder_rpc_iface_lock);
+        if (!gbinder_rpc_iface_utf16_cache) {
+            gbinder_rpc_iface_utf16_cache = g_hash_table_new_full
+                (gbinder_rpc_iface_utf16_hash, gbinder_rpc_iface_utf16_equal,
+                    g_free, NULL);
+        }
+
+        /* Another thread may have got here first */
+        found = g_hash_table_lookup(gbinder_rpc_iface_utf16_cache, &key);
+        if (!found && g_hash_table_size(gbinder_rpc_iface_utf16_cache) <
+            GBINDER_RPC_IFACE_CACHE_MAX) {
+            const gsize size = len * sizeof(gunichar2);
+            GBinderRpcIfaceUtf16* copy = g_malloc(sizeof(*copy) + size);
+            gunichar2* data = (gunichar2*)(copy + 1);
+
+            memcpy(data, utf16, size);
+            copy->utf16 = data;
+            copy->len = len;
+            g_hash_table_insert(gbinder_rpc_iface_utf16_cache, copy,
+                (gpointer)iface);
+        }
+        g_rw_lock_writer_unlock(&gbinder_rpc_iface_lock);
+        /* Unlock */
+    }
+    return iface;
+}
+
+static
+const char*
+gbinder_rpc_iface_intern_utf8(
+    const char* str)
+{
+    const char* iface = NULL;
+    gboolean full = FALSE;
+
+    /* Lock (shared, lookups are the common case) */
+    g_rw_lock_reader_lock(&gbinder_rpc_iface_lock);
+    if (gbinder_rpc_iface_utf8_cache) {
+        iface = g_hash_table_lookup(gbinder_rpc_iface_utf8_cache, str);
+        full = g_hash_table_size(gbinder_rpc_iface_utf8_cache) >=
+            GBINDER_RPC_IFACE_CACHE_MAX;
+    }
+    g_rw_lock_reader_unlock(&gbinder_rpc_iface_lock);
+    /* Unlock */
+
+    if (!iface && !full) {
+        iface = g_intern_string(str);
+
+        /* Lock */
+        g_rw_lock_writer_lock(&gbinder_rpc_iface_lock);
+        if (!gbinder_rpc_iface_utf8_cache) {
+            gbinder_rpc_iface_utf8_cache = g_hash_table_new(g_str_hash,
+                g_str_equal);
+        }
+        if (g_hash_table_size(gbinder_rpc_iface_utf8_cache) <
+            GBINDER_RPC_IFACE_CACHE_MAX) {
+            /* Replacing the same interned string is harmless */
+            g_hash_table_insert(gbinder_rpc_iface_utf8_cache,
+                (gpointer)iface, (gpointer)iface);
+        }
+        g_rw_lock_writer_unlock(&gbinder_rpc_iface_lock);
+        /* Unlock */
+    }
+    return iface;
+}
+
+static
+void
+gbinder_rpc_iface_cache_clear()
+{
+    /* Interned strings stay valid */
+    g_rw_lock_writer_lock(&gbinder_rpc_iface_lock);
+    if (gbinder_rpc_iface_utf16_cache) {
+        g_hash_table_destroy(gbinder_rpc_iface_utf16_cache);
+        gbinder_rpc_iface_utf16_cache = NULL;
+    }
+    if (gbinder_rpc_iface_utf8_cache) {
+        g_hash_table_destroy(gbinder_rpc_iface_utf8_cache);
+        gbinder_rpc_iface_utf8_cache = NULL;
+    }
+    g_rw_lock_writer_unlock(&gbinder_rpc_iface_lock);
+}
+
 /*==========================================================================*
  * Common AIDL protocol
  *==========================================================================*/
 
+static
+const char*
+gbinder_rpc_protocol_aidl_read_iface(
+    GBinderReader* reader,
+    char** iface)
+{
+    const gunichar2* utf16;
+    gsize len;
+
+    *iface = NULL;
+    if (gbinder_reader_read_nullable_string16_utf16(reader, &utf16, &len) &&
+        utf16) {
+        const char* interned = gbinder_rpc_iface_intern_utf16(utf16, len);
+
+        /* Allocate a copy if the cache is full */
+        return interned ? interned :
+            (*iface = gbinder_utf16_to_utf8(utf16, len));
+    }
+    return NULL;
+}
+
 static
 void
 gbinder_rpc_protocol_aidl_write_fmq_grantor_descriptor(
@@ -220,13 +415,11 @@ gbinder_rpc_protocol_aidl_read_rpc_header(
 {
     if (txcode > GBINDER_TRANSACTION(0,0,0)) {
         /* Internal transaction e.g. GBINDER_DUMP_TRANSACTION etc. */
-        *iface = NULL;
     } else if (gbinder_reader_read_int32(reader, NULL)) {
-        *iface = gbinder_reader_read_string16(reader);
-    } else {
-        *iface = NULL;
+        return gbinder_rpc_protocol_aidl_read_iface(reader, iface);
     }
-    return *iface;
+    *iface = NULL;
+    return NULL;
 }
 
 static const GBinderRpcProtocol gbinder_rpc_protocol_aidl = {
@@ -268,14 +461,12 @@ gbinder_rpc_protocol_aidl2_read_rpc_header(
 {
     if (txcode > GBINDER_TRANSACTION(0,0,0)) {
         /* Internal transaction e.g. GBINDER_DUMP_TRANSACTION etc. */
-        *iface = NULL;
     } else if (gbinder_reader_read_int32(reader, NULL) /* flags */ &&
         gbinder_reader_read_int32(reader, NULL) /* work source */) {
-        *iface = gbinder_reader_read_string16(reader);
-    } else {
-        *iface = NULL;
+        return gbinder_rpc_protocol_aidl_read_iface(reader, iface);
     }
-    return *iface;
+    *iface = NULL;
+    return NULL;
 }
 
 static const GBinderRpcProtocol gbinder_rpc_protocol_aidl2 = {
@@ -311,16 +502,14 @@ gbinder_rpc_protocol_aidl3_read_rpc_header(
     char** iface)
 {
     if (txcode > GBINDER_TRANSACTION(0,0,0)) {
-        *iface = NULL;
+        /* Internal transaction */
     } else if (gbinder_reader_read_int32(reader, NULL) /* flags */ &&
         gbinder_reader_read_int32(reader, NULL) /* work source */ &&
         gbinder_reader_read_int32(reader, NULL) /* sys header */) {
-        *iface = gbinder_reader_read_string16(reader);
-    } else {
-        *iface = NULL;
+        return gbinder_rpc_protocol_aidl_read_iface(reader, iface);
     }
-
-    return *iface;
+    *iface = NULL;
+    return NULL;
 }
 
 static
@@ -442,8 +631,16 @@ gbinder_rpc_protocol_hidl_read_rpc_header(
     guint32 txcode,
     char** iface)
 {
+    const char* str = gbinder_reader_read_string8(reader);
+
+    /* The string lives in the buffer, nothing to allocate anyway */
     *iface = NULL;
-    return gbinder_reader_read_string8(reader);
+    if (str) {
+        const char* interned = gbinder_rpc_iface_intern_utf8(str);
+
+        return interned ? interned : str;
+    }
+    return NULL;
 }
 
 void
@@ -573,6 +770,7 @@ gbinder_rpc_protocol_exit()
     }
     /* Reset the default too, mostly for unit testing */
     gbinder_rpc_protocol_default = &DEFAULT_PROTOCOL;
+    gbinder_rpc_iface_cache_clear();
 }
 
 /*==========================================================================*
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gbinder_stats_p.h"
+
+static
+guint
+gbinder_stats_latency_bucket(
+    guint64 usec)
+{
+    guint i = 0;
+
+    while (usec && i < (GBINDER_STATS_LATENCY_BUCKETS - 1)) {
+        usec >>= 1;
+        i++;
+    }
+    return i;
+}
+
+void
+gbinder_stats_latency_add(
+    GBinderStatsLatency* stats,
+    gint64 usec)
+{
+    const guint64 value = MAX(usec, 0);
+
+    stats->count++;
+    stats->total_usec += value;
+    if (stats->max_usec < value) {
+        stats->max_usec = value;
+    }
+    stats->buckets[gbinder_stats_latency_bucket(value)]++;
+}
+
+void
+gbinder_stats_latency_merge(
+    GBinderStatsLatency* dest,
+    const GBinderStatsLatency* src)
+{
+    guint i;
+
+    dest->count += src->count;
+    dest->total_usec += src->total_usec;
+    if (dest->max_usec < src->max_usec) {
+        dest->max_usec = src->max_usec;
+    }
+    for (i = 0; i < GBINDER_STATS_LATENCY_BUCKETS; i++) {
+        dest->buckets[i] += src->buckets[i];
+    }
+}
+
+void
+gbinder_stats_append_latency(
+    GString* buf,
+    const char* name,
+    const GBinderStatsLatency* stats)
+{
+    g_string_append_printf(buf, "%s.count: %" G_GUINT64_FORMAT "\n",
+        name, stats->count);
+    if (stats->count) {
+        guint i;
+
+        g_string_append_printf(buf, "%s.avg_usec: %" G_GUINT64_FORMAT "\n",
+            name, stats->total_usec / stats->count);
+        g_string_append_printf(buf, "%s.max_usec: %" G_GUINT64_FORMAT "\n",
+            name, stats->max_usec);
+        for (i = 0; i < GBINDER_STATS_LATENCY_BUCKETS; i++) {
+            if (stats->buckets[i]) {
+                /* Upper bound of the bucket, the last one has none */
+                if (i < (GBINDER_STATS_LATENCY_BUCKETS - 1)) {
+                    g_string_append_printf(buf, "%s.lt_%luus: %"
+                        G_GUINT64_FORMAT "\n", name, 1UL << i,
+                        stats->buckets[i]);
+                } else {
+                    g_string_append_printf(buf, "%s.ge_%luus: %"
+                        G_GUINT64_FORMAT "\n", name, 1UL << (i - 1),
+                        stats->buckets[i]);
+                }
+            }
+        }
+    }
+}
+
+static
+void
+gbinder_stats_append_commands(
+    GString* buf,
+    const char* prefix,
+    const guint* counts)
+{
+    guint i;
+
+    for (i = 0; i < GBINDER_STATS_MAX_COMMANDS; i++) {
+        if (counts[i]) {
+            g_string_append_printf(buf, "%s_%u: %u\n", prefix, i, counts[i]);
+        }
+    }
+}
+
+void
+gbinder_stats_append(
+    GString* buf,
+    const GBinderStats* stats)
+{
+    gbinder_stats_append_latency(buf, "sync_calls", &stats->sync_calls);
+    gbinder_stats_append_latency(buf, "async_calls", &stats->async_calls);
+    g_string_append_printf(buf, "oneway_calls: %u\n", stats->oneway_calls);
+    g_string_append_printf(buf, "failed_calls: %u\n", stats->failed_calls);
+    gbinder_stats_append_latency(buf, "incoming", &stats->incoming);
+    g_string_append_printf(buf, "tx_pool_threads: %u\n",
+        stats->tx_pool_threads);
+    g_string_append_printf(buf, "tx_pool_queued: %u\n",
+        stats->tx_pool_queued);
+    g_string_append_printf(buf, "urgent_pool_threads: %u\n",
+        stats->urgent_pool_threads);
+    g_string_append_printf(buf, "urgent_pool_queued: %u\n",
+        stats->urgent_pool_queued);
+    g_string_append_printf(buf, "completion_queue_depth: %u\n",
+        stats->completion_queue_depth);
+    g_string_append_printf(buf, "completion_queue_max_depth: %u\n",
+        stats->completion_queue_max_depth);
+    g_string_append_printf(buf, "completion_batches: %u\n",
+        stats->completion_batches);
+    g_string_append_printf(buf, "completions: %u\n", stats->completions);
+    g_string_append_printf(buf, "primary_loopers: %u\n",
+        stats->primary_loopers);
+    g_string_append_printf(buf, "blocked_loopers: %u\n",
+        stats->blocked_loopers);
+    g_string_append_printf(buf, "spawned_loopers: %u\n",
+        stats->spawned_loopers);
+    g_string_append_printf(buf, "ioctls: %u\n", stats->ioctls);
+    g_string_append_printf(buf, "transactions: %u\n", stats->transactions);
+    g_string_append_printf(buf, "bytes_written: %" G_GUINT64_FORMAT "\n",
+        stats->bytes_written);
+    g_string_append_printf(buf, "bytes_read: %" G_GUINT64_FORMAT "\n",
+        stats->bytes_read);
+    gbinder_stats_append_commands(buf, "bc", stats->bc);
+    gbinder_stats_append_commands(buf, "br", stats->br);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
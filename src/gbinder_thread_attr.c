@@ -0,0 +1,480 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE  /* pthread_setaffinity_np */
+
+#include "gbinder_thread_attr.h"
+#include "gbinder_config.h"
+#include "gbinder_log.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+/*
+ * Thread attributes can be set in the config:
+ *
+ * [General]
+ * ThreadPolicy = fifo
+ * ThreadPriority = 10
+ * ThreadNice = -5
+ * ThreadAffinity = 2-3
+ * ThreadStackSize = 131072
+ *
+ * ThreadPolicy is one of other, batch, idle, fifo or rr. ThreadPriority
+ * only makes sense for fifo and rr, ThreadNice for the others. If only
+ * ThreadNice is given, the policy is assumed to be "other".
+ */
+#define CONF_THREAD_POLICY "ThreadPolicy"
+#define CONF_THREAD_PRIORITY "ThreadPriority"
+#define CONF_THREAD_NICE "ThreadNice"
+#define CONF_THREAD_AFFINITY "ThreadAffinity"
+#define CONF_THREAD_STACK_SIZE "ThreadStackSize"
+
+struct gbinder_thread_attr_priv {
+    gint refcount;
+    guint id;
+    int policy;
+    int priority;
+    int nice;
+    gboolean pin;
+    cpu_set_t cpus;
+    gsize stack_size;
+    gint warned;
+};
+
+/* What gbinder_thread_attr_pop() restores */
+struct gbinder_thread_attr_saved {
+    int policy; /* Negative if scheduling hasn't been saved */
+    struct sched_param param;
+    int nice;
+    gboolean pinned; /* TRUE if cpus have been saved */
+    cpu_set_t cpus;
+};
+
+/* Id of the attributes which have been applied to the thread */
+static GPrivate gbinder_thread_attr_applied = G_PRIVATE_INIT(NULL);
+static gint gbinder_thread_attr_restore_warned = FALSE;
+
+static
+gboolean
+gbinder_thread_attr_realtime(
+    int policy)
+{
+    return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+static
+gboolean
+gbinder_thread_attr_parse_cpu(
+    char* str,
+    guint* cpu)
+{
+    char* end = NULL;
+    unsigned long val;
+
+    str = g_strstrip(str);
+    if (g_ascii_isdigit(*str)) {
+        errno = 0;
+        val = strtoul(str, &end, 10);
+        if (!errno && !*end && val < CPU_SETSIZE) {
+            *cpu = (guint)val;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Parses the list like "0-1,3" */
+static
+gboolean
+gbinder_thread_attr_parse_cpus(
+    const char* list,
+    cpu_set_t* cpus)
+{
+    char** ranges = g_strsplit(list, ",", -1);
+    char** ptr = ranges;
+    gboolean ok = (*ptr != NULL);
+
+    CPU_ZERO(cpus);
+    while (ok && *ptr) {
+        char** range = g_strsplit(*ptr++, "-", 3);
+        guint first = 0, last = 0;
+
+        ok = gbinder_thread_attr_parse_cpu(range[0], &first);
+        if (ok) {
+            if (range[1]) {
+                ok = !range[2] &&
+                    gbinder_thread_attr_parse_cpu(range[1], &last) &&
+                    first <= last;
+            } else {
+                last = first;
+            }
+        }
+        if (ok) {
+            guint cpu;
+
+            for (cpu = first; cpu <= last; cpu++) {
+                CPU_SET(cpu, cpus);
+            }
+        }
+        g_strfreev(range);
+    }
+    g_strfreev(ranges);
+    return ok;
+}
+
+static
+int
+gbinder_thread_attr_parse_policy(
+    const char* name)
+{
+    static const struct gbinder_thread_policy_name {
+        const char* name;
+        int policy;
+    } policies[] = {
+        { "other", SCHED_OTHER },
+        { "batch", SCHED_BATCH },
+        { "idle", SCHED_IDLE },
+        { "fifo", SCHED_FIFO },
+        { "rr", SCHED_RR }
+    };
+    char* str = g_strstrip(g_strdup(name));
+    int policy = -1;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(policies) && policy < 0; i++) {
+        if (!g_ascii_strcasecmp(str, policies[i].name)) {
+            policy = policies[i].policy;
+        }
+    }
+    g_free(str);
+    return policy;
+}
+
+static
+gboolean
+gbinder_thread_attr_config_int(
+    GKeyFile* k,
+    const char* key,
+    int* value)
+{
+    GError* error = NULL;
+    const int val = g_key_file_get_integer(k, GBINDER_CONFIG_GROUP_GENERAL,
+        key, &error);
+
+    if (error) {
+        g_error_free(error);
+        return FALSE;
+    } else {
+        *value = val;
+        return TRUE;
+    }
+}
+
+static
+void
+gbinder_thread_attr_free(
+    GBinderThreadAttrPriv* self)
+{
+    g_slice_free(GBinderThreadAttrPriv, self);
+}
+
+static
+int
+gbinder_thread_attr_set_sched(
+    pthread_t thread,
+    int policy,
+    const struct sched_param* param,
+    int nice)
+{
+    int err = pthread_setschedparam(thread, policy, param);
+
+    if (!err && !gbinder_thread_attr_realtime(policy) &&
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) < 0) {
+        err = errno;
+    }
+    return err;
+}
+
+static
+void
+gbinder_thread_attr_set(
+    GBinderThreadAttrPriv* self)
+{
+    const pthread_t thread = pthread_self();
+    int err = 0;
+
+    if (self->policy >= 0) {
+        struct sched_param param;
+
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = self->priority;
+        err = gbinder_thread_attr_set_sched(thread, self->policy, &param,
+            self->nice);
+    }
+    if (!err && self->pin) {
+        err = pthread_setaffinity_np(thread, sizeof(self->cpus), &self->cpus);
+    }
+    if (err) {
+        /* Most likely, lack of privileges. Complain only once */
+        if (g_atomic_int_compare_and_exchange(&self->warned, FALSE, TRUE)) {
+            GWARN("Failed to apply thread attributes: %s", strerror(err));
+        }
+    }
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+GBinderThreadAttrPriv*
+gbinder_thread_attr_new(
+    const GBinderThreadAttr* attr)
+{
+    if (attr) {
+        static gint gbinder_thread_attr_next_id = 1;
+        const int policy = attr->policy;
+        GBinderThreadAttrPriv* self = g_slice_new0(GBinderThreadAttrPriv);
+
+        if (policy >= 0) {
+            const gboolean rt = gbinder_thread_attr_realtime(policy);
+
+            if (policy != SCHED_OTHER && policy != SCHED_BATCH &&
+                policy != SCHED_IDLE && !rt) {
+                GWARN("Invalid scheduling policy %d", policy);
+                gbinder_thread_attr_free(self);
+                return NULL;
+            } else if (rt && (attr->priority < sched_get_priority_min(policy) ||
+                attr->priority > sched_get_priority_max(policy))) {
+                GWARN("Invalid priority %d", attr->priority);
+                gbinder_thread_attr_free(self);
+                return NULL;
+            } else if (!rt && (attr->nice < -20 || attr->nice > 19)) {
+                GWARN("Invalid nice value %d", attr->nice);
+                gbinder_thread_attr_free(self);
+                return NULL;
+            }
+            self->priority = rt ? attr->priority : 0;
+            self->nice = rt ? 0 : attr->nice;
+        }
+        self->policy = MAX(policy, -1);
+        if (attr->cpus) {
+            if (gbinder_thread_attr_parse_cpus(attr->cpus, &self->cpus)) {
+                self->pin = TRUE;
+            } else {
+                GWARN("Invalid CPU list \"%s\"", attr->cpus);
+                gbinder_thread_attr_free(self);
+                return NULL;
+            }
+        }
+        if (attr->stack_size && attr->stack_size < PTHREAD_STACK_MIN) {
+            GWARN("Stack size %lu is too small", (gulong)attr->stack_size);
+            gbinder_thread_attr_free(self);
+            return NULL;
+        }
+        self->stack_size = attr->stack_size;
+        self->id = (guint)g_atomic_int_add(&gbinder_thread_attr_next_id, 1);
+        g_atomic_int_set(&self->refcount, 1);
+        return self;
+    }
+    return NULL;
+}
+
+GBinderThreadAttrPriv*
+gbinder_thread_attr_config(
+    void)
+{
+    GKeyFile* k = gbinder_config_get();
+
+    if (k) {
+        GBinderThreadAttr attr;
+        GBinderThreadAttrPriv* self;
+        char* policy = g_key_file_get_string(k, GBINDER_CONFIG_GROUP_GENERAL,
+            CONF_THREAD_POLICY, NULL);
+        char* cpus = g_key_file_get_string(k, GBINDER_CONFIG_GROUP_GENERAL,
+            CONF_THREAD_AFFINITY, NULL);
+        gboolean configured = (cpus != NULL);
+        int stack_size = 0;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.policy = -1;
+        attr.cpus = cpus;
+        if (policy) {
+            attr.policy = gbinder_thread_attr_parse_policy(policy);
+            if (attr.policy < 0) {
+                GWARN("Invalid %s \"%s\"", CONF_THREAD_POLICY, policy);
+            }
+            configured = TRUE;
+        }
+        configured |= gbinder_thread_attr_config_int(k, CONF_THREAD_PRIORITY,
+            &attr.priority);
+        if (gbinder_thread_attr_config_int(k, CONF_THREAD_NICE, &attr.nice)) {
+            if (attr.policy < 0 && !policy) {
+                attr.policy = SCHED_OTHER;
+            }
+            configured = TRUE;
+        }
+        if (gbinder_thread_attr_config_int(k, CONF_THREAD_STACK_SIZE,
+            &stack_size)) {
+            attr.stack_size = MAX(stack_size, 0);
+            configured = TRUE;
+        }
+
+        self = configured ? gbinder_thread_attr_new(&attr) : NULL;
+        g_free(policy);
+        g_free(cpus);
+        return self;
+    }
+    return NULL;
+}
+
+GBinderThreadAttrPriv*
+gbinder_thread_attr_ref(
+    GBinderThreadAttrPriv* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->refcount > 0);
+        g_atomic_int_inc(&self->refcount);
+    }
+    return self;
+}
+
+void
+gbinder_thread_attr_unref(
+    GBinderThreadAttrPriv* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->refcount > 0);
+        if (g_atomic_int_dec_and_test(&self->refcount)) {
+            gbinder_thread_attr_free(self);
+        }
+    }
+}
+
+gboolean
+gbinder_thread_attr_init_pthread(
+    GBinderThreadAttrPriv* self,
+    pthread_attr_t* pthread_attr)
+{
+    if (self && self->stack_size && !pthread_attr_init(pthread_attr)) {
+        const int err = pthread_attr_setstacksize(pthread_attr,
+            self->stack_size);
+
+        if (!err) {
+            return TRUE;
+        }
+        GWARN("Failed to set stack size: %s", strerror(err));
+        pthread_attr_destroy(pthread_attr);
+    }
+    return FALSE;
+}
+
+void
+gbinder_thread_attr_apply(
+    GBinderThreadAttrPriv* self)
+{
+    if (self && g_private_get(&gbinder_thread_attr_applied) !=
+        GUINT_TO_POINTER(self->id)) {
+        /* Even if it fails, there's no point in trying again */
+        g_private_set(&gbinder_thread_attr_applied,
+            GUINT_TO_POINTER(self->id));
+        gbinder_thread_attr_set(self);
+    }
+}
+
+GBinderThreadAttrSaved*
+gbinder_thread_attr_push(
+    GBinderThreadAttrPriv* self)
+{
+    if (self) {
+        const pthread_t thread = pthread_self();
+        GBinderThreadAttrSaved* saved = g_slice_new0(GBinderThreadAttrSaved);
+
+        if (self->policy < 0 || pthread_getschedparam(thread,
+            &saved->policy, &saved->param)) {
+            saved->policy = -1;
+        } else if (!gbinder_thread_attr_realtime(saved->policy)) {
+            errno = 0;
+            saved->nice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+            if (errno) {
+                saved->policy = -1;
+            }
+        }
+        saved->pinned = self->pin && !pthread_getaffinity_np(thread,
+            sizeof(saved->cpus), &saved->cpus);
+        gbinder_thread_attr_set(self);
+        return saved;
+    }
+    return NULL;
+}
+
+void
+gbinder_thread_attr_pop(
+    GBinderThreadAttrSaved* saved)
+{
+    if (saved) {
+        const pthread_t thread = pthread_self();
+        int err = 0;
+
+        if (saved->policy >= 0) {
+            err = gbinder_thread_attr_set_sched(thread, saved->policy,
+                &saved->param, saved->nice);
+        }
+        if (saved->pinned) {
+            const int err2 = pthread_setaffinity_np(thread,
+                sizeof(saved->cpus), &saved->cpus);
+
+            if (!err) {
+                err = err2;
+            }
+        }
+        if (err && g_atomic_int_compare_and_exchange
+            (&gbinder_thread_attr_restore_warned, FALSE, TRUE)) {
+            GWARN("Failed to restore thread attributes: %s", strerror(err));
+        }
+        g_slice_free(GBinderThreadAttrSaved, saved);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_THREAD_ATTR_H
+#define GBINDER_THREAD_ATTR_H
+
+#include <gbinder_threads.h>
+
+#include "gbinder_types_p.h"
+
+#include <pthread.h>
+
+/* Returns NULL if attr is NULL or invalid */
+GBinderThreadAttrPriv*
+gbinder_thread_attr_new(
+    const GBinderThreadAttr* attr)
+    GBINDER_INTERNAL;
+
+/* Returns NULL if nothing is configured */
+GBinderThreadAttrPriv*
+gbinder_thread_attr_config(
+    void)
+    GBINDER_INTERNAL;
+
+GBinderThreadAttrPriv*
+gbinder_thread_attr_ref(
+    GBinderThreadAttrPriv* attr)
+    GBINDER_INTERNAL;
+
+void
+gbinder_thread_attr_unref(
+    GBinderThreadAttrPriv* attr)
+    GBINDER_INTERNAL;
+
+/* Returns TRUE if pthread_attr has been initialized */
+gboolean
+gbinder_thread_attr_init_pthread(
+    GBinderThreadAttrPriv* attr,
+    pthread_attr_t* pthread_attr)
+    GBINDER_INTERNAL;
+
+/* Applies the attributes to the calling thread (unless already done) */
+void
+gbinder_thread_attr_apply(
+    GBinderThreadAttrPriv* attr)
+    GBINDER_INTERNAL;
+
+/*
+ * Temporarily applies the attributes to the calling thread, which may
+ * belong to somebody else (e.g. a shared GThreadPool worker). Returns
+ * what gbinder_thread_attr_pop() needs to restore the previous state.
+ */
+GBinderThreadAttrSaved*
+gbinder_thread_attr_push(
+    GBinderThreadAttrPriv* attr)
+    GBINDER_INTERNAL;
+
+void
+gbinder_thread_attr_pop(
+    GBinderThreadAttrSaved* saved)
+    GBINDER_INTERNAL;
+
+#endif /* GBINDER_THREAD_ATTR_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "gbinder_trace_p.h"
+#include "gbinder_config.h"
+#include "gbinder_log.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/syscall.h>
+
+/*
+ * Tracing can be turned on by the config:
+ *
+ * [General]
+ * TraceBufferSize = 4096
+ *
+ * The value is the number of records per thread, rounded up to the
+ * next power of two. The buffers are allocated on demand, when the
+ * thread records its first event, and get reused by other threads
+ * after the owner exits. They are never freed (but that's a debugging
+ * facility after all).
+ */
+#define CONF_TRACE_BUFFER_SIZE "TraceBufferSize"
+#define DEFAULT_TRACE_BUFFER_SIZE (4096)
+#define MAX_TRACE_BUFFER_SIZE (1024*1024)
+
+typedef struct gbinder_trace_ring GBinderTraceRing;
+struct gbinder_trace_ring {
+    GBinderTraceRing* next;
+    GBinderTraceRecord* records;
+    guint size;   /* Power of two */
+    guint head;   /* Total number of records written, modulo 2^32 */
+    gint full;    /* Head has wrapped around at least once */
+    gboolean owned;
+    guint32 tid;
+};
+
+static
+void
+gbinder_trace_ring_release(
+    gpointer data);
+
+guint gbinder_trace_size = 0;
+static GMutex gbinder_trace_mutex;
+static GBinderTraceRing* gbinder_trace_rings = NULL;
+static GPrivate gbinder_trace_ring_key =
+    G_PRIVATE_INIT(gbinder_trace_ring_release);
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+gbinder_trace_ring_release(
+    gpointer data)
+{
+    GBinderTraceRing* ring = data;
+
+    /* Lock */
+    g_mutex_lock(&gbinder_trace_mutex);
+    ring->owned = FALSE;
+    g_mutex_unlock(&gbinder_trace_mutex);
+    /* Unlock */
+}
+
+static
+GBinderTraceRing*
+gbinder_trace_ring_get(
+    guint size)
+{
+    GBinderTraceRing* ring = g_private_get(&gbinder_trace_ring_key);
+
+    if (G_UNLIKELY(!ring)) {
+        /* Lock */
+        g_mutex_lock(&gbinder_trace_mutex);
+        for (ring = gbinder_trace_rings; ring; ring = ring->next) {
+            if (!ring->owned && ring->size == size) {
+                break;
+            }
+        }
+        if (!ring) {
+            ring = g_malloc0(sizeof(GBinderTraceRing) +
+                size * sizeof(GBinderTraceRecord));
+            ring->records = (GBinderTraceRecord*)(ring + 1);
+            ring->size = size;
+            ring->next = gbinder_trace_rings;
+            gbinder_trace_rings = ring;
+        }
+        ring->owned = TRUE;
+        ring->tid = (guint32)syscall(SYS_gettid);
+        g_mutex_unlock(&gbinder_trace_mutex);
+        /* Unlock */
+        g_private_set(&gbinder_trace_ring_key, ring);
+    }
+    return ring;
+}
+
+static
+void
+gbinder_trace_ring_collect(
+    GBinderTraceRing* ring,
+    GByteArray* out,
+    GBinderTraceRecord* copy)
+{
+    const guint mask = ring->size - 1;
+    const guint h1 = g_atomic_int_get(&ring->head);
+    guint h2, n, i;
+
+    /*
+     * The owner keeps writing while we are copying. Whatever it wrote
+     * between h1 and h2 may have overwritten the oldest records, those
+     * are dropped.
+     */
+    memcpy(copy, ring->records, ring->size * sizeof(GBinderTraceRecord));
+    h2 = g_atomic_int_get(&ring->head);
+    if (!g_atomic_int_get(&ring->full)) {
+        n = h1;
+    } else if (h2 - h1 < ring->size - 1) {
+        n = ring->size - 1 - (h2 - h1);
+    } else {
+        n = 0;
+    }
+
+    for (i = h1 - n; i != h1; i++) {
+        g_byte_array_append(out, (void*)(copy + (i & mask)),
+            sizeof(GBinderTraceRecord));
+    }
+}
+
+static
+gboolean
+gbinder_trace_write(
+    int fd,
+    const guint8* data,
+    gsize size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+
+        if (written >= 0) {
+            data += written;
+            size -= written;
+        } else if (errno != EINTR) {
+            GWARN("Failed to write trace: %s", strerror(errno));
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*==========================================================================*
+ * Internal interface
+ *==========================================================================*/
+
+void
+gbinder_trace_add(
+    GBINDER_TRACE_EVENT event,
+    guint64 arg1,
+    guint32 arg2,
+    guint32 arg3)
+{
+    const guint size = g_atomic_int_get(&gbinder_trace_size);
+
+    /* Tracing may have been stopped in the meantime */
+    if (size) {
+        GBinderTraceRing* ring = gbinder_trace_ring_get(size);
+        const guint head = ring->head;
+        GBinderTraceRecord* rec = ring->records + (head & (ring->size - 1));
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        rec->nsec = (guint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        rec->tid = ring->tid;
+        rec->event = event;
+        rec->reserved = 0;
+        rec->arg1 = arg1;
+        rec->arg2 = arg2;
+        rec->arg3 = arg3;
+
+        /* Only the owner thread modifies the head */
+        g_atomic_int_set(&ring->head, head + 1);
+        if (G_UNLIKELY((head + 1) == ring->size)) {
+            g_atomic_int_set(&ring->full, TRUE);
+        }
+    }
+}
+
+void
+gbinder_trace_config(
+    void)
+{
+    GKeyFile* k = gbinder_config_get();
+
+    if (k && !g_atomic_int_get(&gbinder_trace_size)) {
+        GError* error = NULL;
+        const int val = g_key_file_get_integer(k,
+            GBINDER_CONFIG_GROUP_GENERAL, CONF_TRACE_BUFFER_SIZE, &error);
+
+        if (error) {
+            g_error_free(error);
+        } else if (val > 0) {
+            gbinder_trace_start(val);
+        }
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+gbinder_trace_start(
+    guint size) /* Since 1.1.51 */
+{
+    guint n = 1;
+
+    if (!size) size = DEFAULT_TRACE_BUFFER_SIZE;
+    while (n < MIN(size, MAX_TRACE_BUFFER_SIZE)) {
+        n <<= 1;
+    }
+    GDEBUG("Tracing %u records per thread", n);
+    g_atomic_int_set(&gbinder_trace_size, n);
+}
+
+void
+gbinder_trace_stop(
+    void) /* Since 1.1.51 */
+{
+    g_atomic_int_set(&gbinder_trace_size, 0);
+}
+
+gboolean
+gbinder_trace_dump(
+    int fd) /* Since 1.1.51 */
+{
+    gboolean ok = FALSE;
+
+    if (fd >= 0) {
+        GByteArray* out = g_byte_array_new();
+        GBinderTraceHeader header;
+        GBinderTraceRing* ring;
+        GBinderTraceRecord* copy = NULL;
+        guint copy_size = 0;
+
+        memset(&header, 0, sizeof(header));
+        g_byte_array_append(out, (void*)&header, sizeof(header));
+
+        /* Lock */
+        g_mutex_lock(&gbinder_trace_mutex);
+        for (ring = gbinder_trace_rings; ring; ring = ring->next) {
+            if (copy_size < ring->size) {
+                g_free(copy);
+                copy_size = ring->size;
+                copy = g_new(GBinderTraceRecord, copy_size);
+            }
+            gbinder_trace_ring_collect(ring, out, copy);
+        }
+        g_mutex_unlock(&gbinder_trace_mutex);
+        /* Unlock */
+
+        header.magic = GBINDER_TRACE_MAGIC;
+        header.version = GBINDER_TRACE_VERSION;
+        header.record_size = sizeof(GBinderTraceRecord);
+        header.count = (out->len - sizeof(header)) / header.record_size;
+        memcpy(out->data, &header, sizeof(header));
+        GDEBUG("Dumping %u trace records", header.count);
+        ok = gbinder_trace_write(fd, out->data, out->len);
+        g_byte_array_free(out, TRUE);
+        g_free(copy);
+    }
+    return ok;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -34,6 +34,7 @@
 
 #include <gbinder_types.h>
 
+typedef struct gbinder_arena GBinderArena;
 typedef struct gbinder_buffer_contents GBinderBufferContents;
 typedef struct gbinder_buffer_contents_list GBinderBufferContentsList;
 typedef struct gbinder_cleanup GBinderCleanup;
@@ -46,6 +47,8 @@ typedef struct gbinder_output_data GBinderOutputData;
 typedef struct gbinder_proxy_object GBinderProxyObject;
 typedef struct gbinder_rpc_protocol GBinderRpcProtocol;
 typedef struct gbinder_servicepoll GBinderServicePoll;
+typedef struct gbinder_thread_attr_priv GBinderThreadAttrPriv;
+typedef struct gbinder_thread_attr_saved GBinderThreadAttrSaved;
 typedef struct gbinder_ipc_looper_tx GBinderIpcLooperTx;
 typedef struct gbinder_ipc_sync_api GBinderIpcSyncApi;
 
@@ -59,6 +62,7 @@ typedef struct gbinder_ipc_sync_api GBinderIpcSyncApi;
 #define GBINDER_SHELL_COMMAND_TRANSACTION GBINDER_TRANSACTION('C','M','D')
 #define GBINDER_INTERFACE_TRANSACTION     GBINDER_TRANSACTION('N','T','F')
 #define GBINDER_SYSPROPS_TRANSACTION      GBINDER_TRANSACTION('S','P','R')
+#define GBINDER_STATS_TRANSACTION         GBINDER_TRANSACTION('S','T','S')
 
 /* platform/system/tools/hidl/Interface.cpp */
 #define HIDL_FOURCC(c2,c3,c4)                     GBINDER_FOURCC(0x0f,c2,c3,c4)
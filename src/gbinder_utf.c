@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gbinder_utf.h"
+
+#include <string.h>
+
+/*
+ * Vectorized loops process 16 bytes (or 16 UTF-16 units) per iteration,
+ * the rest is handled by the scalar code. SSE2 is always there on x86_64
+ * and NEON on aarch64, so no runtime detection is needed.
+ */
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define GBINDER_UTF_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define GBINDER_UTF_NEON
+#endif
+
+#define ASCII_MASK_8 (0x80)
+#define ASCII_MASK_16 (0xff80)
+#define ASCII_MASK_64 G_GUINT64_CONSTANT(0x8080808080808080)
+
+gsize
+gbinder_utf8_ascii_len(
+    const char* utf8,
+    gsize len)
+{
+    const guint8* ptr = (const guint8*)utf8;
+    gsize i = 0;
+
+#if defined(GBINDER_UTF_SSE2)
+    for (; i + 16 <= len; i += 16) {
+        const int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)
+            (ptr + i)));
+
+        if (mask) {
+            return i + g_bit_nth_lsf(mask, -1);
+        }
+    }
+#elif defined(GBINDER_UTF_NEON)
+    while (i + 16 <= len && vmaxvq_u8(vld1q_u8(ptr + i)) < ASCII_MASK_8) {
+        i += 16;
+    }
+#endif
+
+    for (; i + 8 <= len; i += 8) {
+        guint64 word;
+
+        memcpy(&word, ptr + i, sizeof(word));
+        if (word & ASCII_MASK_64) {
+            break;
+        }
+    }
+    while (i < len && !(ptr[i] & ASCII_MASK_8)) {
+        i++;
+    }
+    return i;
+}
+
+void
+gbinder_utf8_ascii_to_utf16(
+    gunichar2* utf16,
+    const char* ascii,
+    gsize len)
+{
+    const guint8* ptr = (const guint8*)ascii;
+    gsize i = 0;
+
+#if defined(GBINDER_UTF_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= len; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(ptr + i));
+
+        _mm_storeu_si128((__m128i*)(utf16 + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(utf16 + i + 8),
+            _mm_unpackhi_epi8(v, zero));
+    }
+#elif defined(GBINDER_UTF_NEON)
+    for (; i + 16 <= len; i += 16) {
+        const uint8x16_t v = vld1q_u8(ptr + i);
+
+        vst1q_u16(utf16 + i, vmovl_u8(vget_low_u8(v)));
+        vst1q_u16(utf16 + i + 8, vmovl_high_u8(v));
+    }
+#endif
+
+    for (; i < len; i++) {
+        utf16[i] = ptr[i];
+    }
+}
+
+gsize
+gbinder_utf16_ascii_to_utf8(
+    char* ascii,
+    const gunichar2* utf16,
+    gsize len)
+{
+    guint8* out = (guint8*)ascii;
+    gsize i = 0;
+
+#if defined(GBINDER_UTF_SSE2)
+    const __m128i mask = _mm_set1_epi16(ASCII_MASK_16);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= len; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(utf16 + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(utf16 + i + 8));
+        const __m128i high = _mm_and_si128(_mm_or_si128(a, b), mask);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff) {
+            break;
+        }
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+    }
+#elif defined(GBINDER_UTF_NEON)
+    for (; i + 16 <= len; i += 16) {
+        const uint16x8_t a = vld1q_u16(utf16 + i);
+        const uint16x8_t b = vld1q_u16(utf16 + i + 8);
+
+        if (vmaxvq_u16(vorrq_u16(a, b)) & ASCII_MASK_16) {
+            break;
+        }
+        vst1q_u8(out + i, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+    }
+#endif
+
+    for (; i < len && !(utf16[i] & ASCII_MASK_16); i++) {
+        out[i] = (guint8)utf16[i];
+    }
+    return i;
+}
+
+char*
+gbinder_utf16_to_utf8(
+    const gunichar2* utf16,
+    gsize len)
+{
+    char* utf8 = g_malloc(len + 1);
+
+    if (gbinder_utf16_ascii_to_utf8(utf8, utf16, len) == len) {
+        utf8[len] = 0;
+        return utf8;
+    } else {
+        g_free(utf8);
+        return g_utf16_to_utf8(utf16, len, NULL, NULL, NULL);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
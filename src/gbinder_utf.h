@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GBINDER_UTF_H
+#define GBINDER_UTF_H
+
+#include "gbinder_types_p.h"
+
+/*
+ * Most strings going through binder (interface names, service names,
+ * keys and such) are plain ASCII. These functions handle that case
+ * without going through the generic GLib converters.
+ */
+
+/* Returns the number of leading ASCII bytes */
+gsize
+gbinder_utf8_ascii_len(
+    const char* utf8,
+    gsize len)
+    GBINDER_INTERNAL;
+
+/* Input must be pure ASCII, output has room for len units */
+void
+gbinder_utf8_ascii_to_utf16(
+    gunichar2* utf16,
+    const char* ascii,
+    gsize len)
+    GBINDER_INTERNAL;
+
+/* Stops at the first non-ASCII unit, returns the number of bytes written */
+gsize
+gbinder_utf16_ascii_to_utf8(
+    char* ascii,
+    const gunichar2* utf16,
+    gsize len)
+    GBINDER_INTERNAL;
+
+/* Same as g_utf16_to_utf8 minus error reporting, faster for ASCII */
+char*
+gbinder_utf16_to_utf8(
+    const gunichar2* utf16,
+    gsize len)
+    GBINDER_INTERNAL;
+
+#endif /* GBINDER_UTF_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -35,13 +35,13 @@
 #include "gbinder_local_object.h"
 #include "gbinder_object_converter.h"
 #include "gbinder_rpc_protocol.h"
+#include "gbinder_utf.h"
 #include "gbinder_io.h"
 #include "gbinder_log.h"
 
 #include <gutil_intarray.h>
 #include <gutil_macros.h>
 #include <gutil_strv.h>
-#include <gutil_misc.h>
 
 #include <unistd.h>
 #include <stdint.h>
@@ -74,16 +74,30 @@ GBINDER_INLINE_FUNC GBinderWriterPriv* gbinder_writer_cast(GBinderWriter* pub)
 GBINDER_INLINE_FUNC GBinderWriterData* gbinder_writer_data(GBinderWriter* pub)
     { return G_LIKELY(pub) ? gbinder_writer_cast(pub)->data : NULL; }
 
+/*
+ * Drops the contents but keeps the storage allocated. Returns FALSE if
+ * the buffer has grown too large to be worth keeping around.
+ */
+gboolean
+gbinder_writer_data_reset(
+    GBinderWriterData* data)
+{
+    data->bytes_max = MAX(data->bytes_max, data->bytes->len);
+    g_byte_array_set_size(data->bytes, 0);
+    gutil_int_array_set_count(data->offsets, 0);
+    data->buffers_size = 0;
+    gbinder_cleanup_reset(data->cleanup);
+    gbinder_arena_rewind(&data->arena);
+    return data->bytes_max <= GBINDER_WRITER_REUSE_MAX;
+}
+
 void
 gbinder_writer_data_set_contents(
     GBinderWriterData* data,
     GBinderBuffer* buffer,
     GBinderObjectConverter* convert)
 {
-    g_byte_array_set_size(data->bytes, 0);
-    gutil_int_array_set_count(data->offsets, 0);
-    data->buffers_size = 0;
-    gbinder_cleanup_reset(data->cleanup);
+    gbinder_writer_data_reset(data);
     gbinder_writer_data_append_contents(data, buffer, 0, convert);
 }
 
@@ -349,6 +363,50 @@ gbinder_writer_overwrite_int32(
     }
 }
 
+void*
+gbinder_writer_reserve(
+    GBinderWriter* self,
+    gsize size) /* Since 1.1.51 */
+{
+    GBinderWriterData* data = gbinder_writer_data(self);
+
+    if (G_LIKELY(data) && G_LIKELY(size)) {
+        GByteArray* buf = data->bytes;
+        const gsize padded = G_ALIGN4(size);
+
+        if (G_LIKELY(padded >= size) && padded <= G_MAXUINT - buf->len) {
+            const guint offset = buf->len;
+            guint8* ptr;
+
+            g_byte_array_set_size(buf, offset + padded);
+            ptr = buf->data + offset;
+            if (padded > size) {
+                memset(ptr + size, 0, padded - size);
+            }
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+void
+gbinder_writer_size_hint(
+    GBinderWriter* self,
+    gsize size) /* Since 1.1.51 */
+{
+    GBinderWriterData* data = gbinder_writer_data(self);
+
+    if (G_LIKELY(data) && size > 0 && size <= G_MAXUINT - data->bytes->len) {
+        GByteArray* buf = data->bytes;
+        const guint len = buf->len;
+
+        /* GByteArray doesn't give the memory back when it shrinks */
+        g_byte_array_set_size(buf, len + size);
+        g_byte_array_set_size(buf, len);
+        data->bytes_max = MAX(data->bytes_max, len + size);
+    }
+}
+
 void
 gbinder_writer_append_int64(
     GBinderWriter* self,
@@ -548,22 +606,28 @@ gbinder_writer_data_append_string16_len(
     if (num_bytes > 0) {
         GByteArray* buf = data->bytes;
         const gsize old_size = buf->len;
-        glong len = g_utf8_strlen(utf8, num_bytes);
-        gsize padded_len = G_ALIGN4((len+1)*2);
+        const gboolean ascii =
+            gbinder_utf8_ascii_len(utf8, num_bytes) == (gsize)num_bytes;
+        glong len;
+        gsize padded_len;
         guint32* len_ptr;
         gunichar2* utf16_ptr;
         gunichar2* utf16 = NULL;
 
-        /* Create utf-16 string to make sure of its size */
-        if (len > 0) {
+        if (ascii) {
+            /* One UTF-16 unit per byte, convert right into the buffer */
+            len = num_bytes;
+        } else {
             glong utf16_len = 0;
 
+            /* Create utf-16 string to make sure of its size */
+            len = g_utf8_strlen(utf8, num_bytes);
             utf16 = g_utf8_to_utf16(utf8, num_bytes, NULL, &utf16_len, NULL);
             if (utf16) {
                 len = utf16_len;
-                padded_len = G_ALIGN4((len+1)*2);
             }
         }
+        padded_len = G_ALIGN4((len+1)*2);
 
         /* Preallocate space */
         g_byte_array_set_size(buf, old_size + padded_len + 4);
@@ -571,7 +635,9 @@ gbinder_writer_data_append_string16_len(
         utf16_ptr = (gunichar2*)(len_ptr + 1);
 
         /* Copy string */
-        if (utf16) {
+        if (ascii) {
+            gbinder_utf8_ascii_to_utf16(utf16_ptr, utf8, len);
+        } else if (utf16) {
             memcpy(utf16_ptr, utf16, len*2);
             g_free(utf16);
         }
@@ -1065,18 +1131,16 @@ gbinder_writer_data_append_hidl_vec(
     guint elemsize)
 {
     GBinderParent vec_parent;
-    GBinderHidlVec* vec = g_new0(GBinderHidlVec, 1);
+    GBinderHidlVec* vec = gbinder_arena_alloc0(&data->arena, sizeof(*vec));
     const gsize total = count * elemsize;
-    void* buf = gutil_memdup(base, total);
+    void* buf = gbinder_arena_memdup(&data->arena, base, total);
 
     /* Fill in the vector descriptor */
     if (buf) {
         vec->data.ptr = buf;
         vec->count = count;
-        data->cleanup = gbinder_cleanup_add(data->cleanup, g_free, buf);
     }
     vec->owns_buffer = TRUE;
-    data->cleanup = gbinder_cleanup_add(data->cleanup, g_free, vec);
 
     /* Every vector, even the one without data, requires two buffer objects */
     vec_parent.offset = GBINDER_HIDL_VEC_BUFFER_OFFSET;
@@ -1105,14 +1169,14 @@ gbinder_writer_data_append_hidl_string(
     const char* str)
 {
     GBinderParent str_parent;
-    GBinderHidlString* hidl_string = g_new0(GBinderHidlString, 1);
+    GBinderHidlString* hidl_string = gbinder_arena_alloc0(&data->arena,
+        sizeof(*hidl_string));
     const gsize len = str ? strlen(str) : 0;
 
     /* Fill in the string descriptor and store it */
     hidl_string->data.str = str;
     hidl_string->len = len;
     hidl_string->owns_buffer = TRUE;
-    data->cleanup = gbinder_cleanup_add(data->cleanup, g_free, hidl_string);
 
     /* Write the buffer object pointing to the string descriptor */
     str_parent.offset = GBINDER_HIDL_STRING_BUFFER_OFFSET;
@@ -1150,7 +1214,7 @@ gbinder_writer_data_append_hidl_string_vec(
     gssize count)
 {
     GBinderParent vec_parent;
-    GBinderHidlVec* vec = g_new0(GBinderHidlVec, 1);
+    GBinderHidlVec* vec = gbinder_arena_alloc0(&data->arena, sizeof(*vec));
     GBinderHidlString* strings = NULL;
     int i;
 
@@ -1161,13 +1225,12 @@ gbinder_writer_data_append_hidl_string_vec(
 
     /* Fill in the vector descriptor */
     if (count > 0) {
-        strings = g_new0(GBinderHidlString, count);
+        strings = gbinder_arena_alloc0(&data->arena,
+            sizeof(GBinderHidlString) * count);
         vec->data.ptr = strings;
-        data->cleanup = gbinder_cleanup_add(data->cleanup, g_free, strings);
     }
     vec->count = count;
     vec->owns_buffer = TRUE;
-    data->cleanup = gbinder_cleanup_add(data->cleanup, g_free, vec);
 
     /* Fill in string descriptors */
     for (i = 0; i < count; i++) {
@@ -1343,31 +1406,18 @@ gbinder_writer_data_append_remote_object(
     }
 }
 
-static
-void*
-gbinder_writer_alloc(
-    GBinderWriter* self,
-    gsize size,
-    gpointer (*alloc)(gsize),
-    void (*dealloc)(gpointer))
-{
-    GBinderWriterData* data = gbinder_writer_data(self);
-
-    if (G_LIKELY(data)) {
-        void* ptr = alloc(size);
-
-        data->cleanup = gbinder_cleanup_add(data->cleanup, dealloc, ptr);
-        return ptr;
-    }
-    return NULL;
-}
-
+/*
+ * These allocations live as long as the request (or reply) and come
+ * from the arena, which is deallocated in one go.
+ */
 void*
 gbinder_writer_malloc(
     GBinderWriter* self,
     gsize size) /* since 1.0.19 */
 {
-    return gbinder_writer_alloc(self, size, g_malloc, g_free);
+    GBinderWriterData* data = gbinder_writer_data(self);
+
+    return G_LIKELY(data) ? gbinder_arena_alloc(&data->arena, size) : NULL;
 }
 
 void*
@@ -1375,7 +1425,9 @@ gbinder_writer_malloc0(
     GBinderWriter* self,
     gsize size) /* since 1.0.19 */
 {
-    return gbinder_writer_alloc(self, size, g_malloc0, g_free);
+    GBinderWriterData* data = gbinder_writer_data(self);
+
+    return G_LIKELY(data) ? gbinder_arena_alloc0(&data->arena, size) : NULL;
 }
 
 char*
@@ -36,15 +36,18 @@
 
 #include <gbinder_writer.h>
 
+#include "gbinder_arena.h"
 #include "gbinder_cleanup.h"
 
 typedef struct gbinder_writer_data {
     const GBinderIo* io;
     const GBinderRpcProtocol* protocol;
     GByteArray* bytes;
+    gsize bytes_max; /* GByteArray never shrinks, that's how big it got */
     GUtilIntArray* offsets;
     gsize buffers_size;
     GBinderCleanup* cleanup;
+    GBinderArena arena; /* Temporary data, freed together with cleanup */
 } GBinderWriterData;
 
 void
@@ -54,6 +57,14 @@ gbinder_writer_init(
     guint offset)
     GBINDER_INTERNAL;
 
+/* Larger buffers are freed rather than recycled */
+#define GBINDER_WRITER_REUSE_MAX (16 * 1024)
+
+gboolean
+gbinder_writer_data_reset(
+    GBinderWriterData* data)
+    GBINDER_INTERNAL;
+
 void
 gbinder_writer_data_set_contents(
     GBinderWriterData* data,
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Decoder for the dumps produced by gbinder_trace_dump(). Prints the
+ * events in chronological order, along with the duration of ioctls and
+ * transaction handlers. With -t only the ioctls and handlers which took
+ * at least the specified number of microseconds are shown.
+ */
+
+#include <gbinder.h>
+
+#include <gutil_log.h>
+
+#include <stdlib.h>
+
+#define RET_OK          (0)
+#define RET_INVARG      (2)
+#define RET_ERR         (3)
+
+typedef struct app_options {
+    const char* file;
+    gint64 threshold;
+} AppOptions;
+
+typedef struct app_record {
+    const GBinderTraceRecord* rec;
+    guint index;
+} AppRecord;
+
+typedef struct app_thread {
+    guint64 ioctl_start;
+    GArray* handlers;
+} AppThread;
+
+static const char* app_event_names[] = {
+    NULL,
+    "TX_QUEUED",
+    "IOCTL_ENTER",
+    "IOCTL_EXIT",
+    "BR_TRANSACTION",
+    "HANDLER_START",
+    "HANDLER_END",
+    "REPLY_SENT"
+};
+
+static
+int
+app_record_compare(
+    const void* a,
+    const void* b)
+{
+    const AppRecord* r1 = a;
+    const AppRecord* r2 = b;
+
+    if (r1->rec->nsec != r2->rec->nsec) {
+        return (r1->rec->nsec < r2->rec->nsec) ? -1 : 1;
+    } else {
+        /* Keep the original order (which is chronological per thread) */
+        return (int)r1->index - (int)r2->index;
+    }
+}
+
+static
+void
+app_thread_free(
+    gpointer data)
+{
+    AppThread* thread = data;
+
+    g_array_free(thread->handlers, TRUE);
+    g_free(thread);
+}
+
+static
+AppThread*
+app_thread_get(
+    GHashTable* threads,
+    guint32 tid)
+{
+    AppThread* thread = g_hash_table_lookup(threads, GUINT_TO_POINTER(tid));
+
+    if (!thread) {
+        thread = g_new0(AppThread, 1);
+        thread->handlers = g_array_new(FALSE, FALSE, sizeof(guint64));
+        g_hash_table_insert(threads, GUINT_TO_POINTER(tid), thread);
+    }
+    return thread;
+}
+
+static
+void
+app_print(
+    const GBinderTraceRecord* rec,
+    guint64 start,
+    gint64 usec)
+{
+    const char* name = (rec->event < G_N_ELEMENTS(app_event_names)) ?
+        app_event_names[rec->event] : NULL;
+    GString* buf = g_string_new(NULL);
+
+    g_string_append_printf(buf, "%12.3f %6u ", (rec->nsec - start)/1e6,
+        rec->tid);
+    if (name) {
+        g_string_append_printf(buf, "%-15s", name);
+    } else {
+        g_string_append_printf(buf, "%-15u", rec->event);
+    }
+
+    switch (rec->event) {
+    case GBINDER_TRACE_TX_QUEUED:
+        g_string_append_printf(buf, "id=%" G_GUINT64_FORMAT " handle=%u "
+            "code=0x%08x", rec->arg1, rec->arg2, rec->arg3);
+        break;
+    case GBINDER_TRACE_IOCTL_ENTER:
+        g_string_append_printf(buf, "fd=%u write=%" G_GUINT64_FORMAT,
+            rec->arg2, rec->arg1);
+        break;
+    case GBINDER_TRACE_IOCTL_EXIT:
+        g_string_append_printf(buf, "fd=%u read=%" G_GUINT64_FORMAT " err=%d",
+            rec->arg2, rec->arg1, (gint32)rec->arg3);
+        break;
+    case GBINDER_TRACE_BR_TRANSACTION:
+        g_string_append_printf(buf, "target=0x%" G_GINT64_MODIFIER "x "
+            "code=0x%08x flags=0x%02x", rec->arg1, rec->arg2, rec->arg3);
+        break;
+    case GBINDER_TRACE_HANDLER_START:
+        g_string_append_printf(buf, "object=0x%" G_GINT64_MODIFIER "x "
+            "code=0x%08x", rec->arg1, rec->arg2);
+        break;
+    case GBINDER_TRACE_HANDLER_END:
+        g_string_append_printf(buf, "object=0x%" G_GINT64_MODIFIER "x "
+            "code=0x%08x status=%d", rec->arg1, rec->arg2, (gint32)rec->arg3);
+        break;
+    case GBINDER_TRACE_REPLY_SENT:
+        g_string_append_printf(buf, "status=%d err=%d", (gint32)rec->arg2,
+            (gint32)rec->arg3);
+        break;
+    default:
+        g_string_append_printf(buf, "%" G_GUINT64_FORMAT " %u %u",
+            rec->arg1, rec->arg2, rec->arg3);
+        break;
+    }
+
+    if (usec >= 0) {
+        g_string_append_printf(buf, " (%" G_GINT64_FORMAT " us)", usec);
+    }
+    printf("%s\n", buf->str);
+    g_string_free(buf, TRUE);
+}
+
+static
+gint64
+app_duration(
+    GHashTable* threads,
+    const GBinderTraceRecord* rec)
+{
+    AppThread* thread = app_thread_get(threads, rec->tid);
+    gint64 usec = -1;
+
+    switch (rec->event) {
+    case GBINDER_TRACE_IOCTL_ENTER:
+        thread->ioctl_start = rec->nsec;
+        break;
+    case GBINDER_TRACE_IOCTL_EXIT:
+        if (thread->ioctl_start) {
+            usec = (rec->nsec - thread->ioctl_start) / 1000;
+            thread->ioctl_start = 0;
+        }
+        break;
+    case GBINDER_TRACE_HANDLER_START:
+        /* Handlers may nest (e.g. while waiting for a sync reply) */
+        g_array_append_val(thread->handlers, rec->nsec);
+        break;
+    case GBINDER_TRACE_HANDLER_END:
+        if (thread->handlers->len) {
+            const guint last = thread->handlers->len - 1;
+
+            usec = (rec->nsec - g_array_index(thread->handlers,
+                guint64, last)) / 1000;
+            g_array_set_size(thread->handlers, last);
+        }
+        break;
+    }
+    return usec;
+}
+
+static
+int
+app_run(
+    const AppOptions* opt)
+{
+    int ret = RET_ERR;
+    gchar* data = NULL;
+    gsize size = 0;
+    GError* error = NULL;
+
+    if (g_file_get_contents(opt->file, &data, &size, &error)) {
+        GBinderTraceHeader header;
+
+        memset(&header, 0, sizeof(header));
+        if (size >= sizeof(header)) {
+            memcpy(&header, data, sizeof(header));
+        }
+        if (header.magic != GBINDER_TRACE_MAGIC ||
+            header.version != GBINDER_TRACE_VERSION ||
+            header.record_size < sizeof(GBinderTraceRecord)) {
+            GERR("%s: not a trace file", opt->file);
+        } else if (size < sizeof(header) +
+            (gsize)header.count * header.record_size) {
+            GERR("%s: truncated", opt->file);
+        } else {
+            const guint n = header.count;
+            AppRecord* records = g_new(AppRecord, n);
+            GHashTable* threads = g_hash_table_new_full(g_direct_hash,
+                g_direct_equal, NULL, app_thread_free);
+            guint i;
+
+            /* Records from different threads are interleaved by time */
+            for (i = 0; i < n; i++) {
+                records[i].rec = (GBinderTraceRecord*)(data +
+                    sizeof(header) + i * header.record_size);
+                records[i].index = i;
+            }
+            qsort(records, n, sizeof(AppRecord), app_record_compare);
+
+            for (i = 0; i < n; i++) {
+                const GBinderTraceRecord* rec = records[i].rec;
+                const gint64 usec = app_duration(threads, rec);
+
+                if (!opt->threshold || usec >= opt->threshold) {
+                    app_print(rec, records[0].rec->nsec, usec);
+                }
+            }
+            g_hash_table_destroy(threads);
+            g_free(records);
+            ret = RET_OK;
+        }
+        g_free(data);
+    } else {
+        GERR("%s", error->message);
+        g_error_free(error);
+    }
+    return ret;
+}
+
+static
+gboolean
+app_init(
+    AppOptions* opt,
+    int argc,
+    char* argv[])
+{
+    gboolean ok = FALSE;
+    gint threshold = 0;
+    GOptionEntry entries[] = {
+        { "threshold", 't', 0, G_OPTION_ARG_INT, &threshold,
+          "Only show ioctls and handlers longer than this", "USEC" },
+        { NULL }
+    };
+
+    GError* error = NULL;
+    GOptionContext* options = g_option_context_new("FILE");
+
+    gutil_log_timestamp = FALSE;
+    gutil_log_default.level = GLOG_LEVEL_DEFAULT;
+
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (g_option_context_parse(options, &argc, &argv, &error)) {
+        if (argc == 2 && threshold >= 0) {
+            opt->file = argv[1];
+            opt->threshold = threshold;
+            ok = TRUE;
+        } else {
+            char* help = g_option_context_get_help(options, TRUE, NULL);
+
+            fprintf(stderr, "%s", help);
+            g_free(help);
+        }
+    } else {
+        GERR("%s", error->message);
+        g_error_free(error);
+    }
+    g_option_context_free(options);
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    AppOptions opt;
+    int ret = RET_INVARG;
+
+    memset(&opt, 0, sizeof(opt));
+    if (app_init(&opt, argc, argv)) {
+        ret = app_run(&opt);
+    }
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
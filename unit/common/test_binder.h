@@ -57,6 +57,11 @@ test_binder_br_noop(
     int fd,
     TEST_BR_THREAD dest);
 
+void
+test_binder_br_spawn_looper(
+    int fd,
+    TEST_BR_THREAD dest);
+
 void
 test_binder_br_increfs(
     int fd,
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test_common.h"
+
+#include "gbinder_arena.h"
+
+static TestOpt test_opt;
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    GBinderArena arena;
+
+    memset(&arena, 0, sizeof(arena));
+    g_assert(!gbinder_arena_alloc(&arena, 0));
+    g_assert(!gbinder_arena_alloc0(&arena, 0));
+    g_assert(!gbinder_arena_memdup(&arena, NULL, 1));
+    g_assert(!gbinder_arena_memdup(&arena, &arena, 0));
+    g_assert(!arena.chunks);
+    gbinder_arena_clear(&arena);
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    static const char str[] = "foo";
+    GBinderArena arena;
+    guint8* prev = NULL;
+    char* copy;
+    int i;
+
+    memset(&arena, 0, sizeof(arena));
+
+    /* Allocations are 8-byte aligned and don't overlap */
+    for (i = 1; i < 2000; i++) {
+        guint8* ptr = gbinder_arena_alloc0(&arena, i % 13 + 1);
+
+        g_assert(ptr);
+        g_assert(!(GPOINTER_TO_SIZE(ptr) & 7));
+        g_assert(!ptr[i % 13]);
+        memset(ptr, 0xff, i % 13 + 1);
+        g_assert(ptr != prev);
+        prev = ptr;
+    }
+
+    copy = gbinder_arena_memdup(&arena, str, sizeof(str));
+    g_assert_cmpstr(copy, == ,str);
+
+    gbinder_arena_clear(&arena);
+    g_assert(!arena.chunks);
+    g_assert(!arena.left);
+}
+
+/*==========================================================================*
+ * large
+ *==========================================================================*/
+
+static
+void
+test_large(
+    void)
+{
+    const gsize big = 1024 * 1024;
+    GBinderArena arena;
+    guint8* small1;
+    guint8* small2;
+    guint8* large;
+
+    memset(&arena, 0, sizeof(arena));
+    small1 = gbinder_arena_alloc(&arena, 8);
+    g_assert(small1);
+
+    /* Large allocation doesn't replace the current chunk */
+    large = gbinder_arena_alloc(&arena, big);
+    g_assert(large);
+    memset(large, 0, big);
+    small2 = gbinder_arena_alloc(&arena, 8);
+    g_assert(small2 == small1 + 8);
+
+    gbinder_arena_clear(&arena);
+}
+
+/*==========================================================================*
+ * rewind
+ *==========================================================================*/
+
+static
+void
+test_rewind(
+    void)
+{
+    GBinderArena arena;
+    guint8* ptr;
+    int i;
+
+    /* Nothing to rewind */
+    memset(&arena, 0, sizeof(arena));
+    gbinder_arena_rewind(&arena);
+    g_assert(!arena.chunks);
+
+    /* A few regular chunks and a large one */
+    for (i = 0; i < 100; i++) {
+        g_assert(gbinder_arena_alloc(&arena, 100));
+    }
+    g_assert(gbinder_arena_alloc(&arena, 1024 * 1024));
+    g_assert(arena.chunks->next);
+
+    /* Only one chunk survives and gets reused */
+    gbinder_arena_rewind(&arena);
+    g_assert(arena.chunks);
+    g_assert(!arena.chunks->next);
+    ptr = gbinder_arena_alloc(&arena, 8);
+    g_assert(ptr);
+    gbinder_arena_rewind(&arena);
+    g_assert(gbinder_arena_alloc(&arena, 8) == ptr);
+
+    gbinder_arena_clear(&arena);
+    g_assert(!arena.chunks);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/arena/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("large"), test_large);
+    g_test_add_func(TEST_("rewind"), test_rewind);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
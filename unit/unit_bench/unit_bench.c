@@ -0,0 +1,512 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * These are not really tests but rather benchmarks. They run against
+ * the fake binder driver so the numbers only make sense relative to
+ * each other (e.g. before and after a change). Run with -v to see them.
+ */
+
+#include "test_binder.h"
+
+#include "gbinder_buffer_p.h"
+#include "gbinder_ipc.h"
+#include "gbinder_driver.h"
+#include "gbinder_local_object.h"
+#include "gbinder_local_request_p.h"
+#include "gbinder_object_registry.h"
+#include "gbinder_output_data.h"
+#include "gbinder_reader_p.h"
+#include "gbinder_rpc_protocol.h"
+#include "gbinder_remote_object.h"
+#include "gbinder_writer.h"
+
+#include <gutil_log.h>
+
+static TestOpt test_opt;
+static const char TMP_DIR_TEMPLATE[] = "gbinder-test-bench-XXXXXX";
+
+#define BENCH_COUNT (1000)
+
+static
+gboolean
+test_unref_ipc(
+    gpointer ipc)
+{
+    gbinder_ipc_unref(ipc);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_quit_when_destroyed(
+    gpointer loop,
+    GObject* obj)
+{
+    test_quit_later((GMainLoop*)loop);
+}
+
+static
+void
+test_bench_report(
+    const char* name,
+    guint count,
+    gint64 usec)
+{
+    g_test_message("%s: %u iterations, %.3f us/iteration", name, count,
+        (double)usec / count);
+}
+
+static
+void
+test_bench_report_driver(
+    const char* name,
+    GBinderDriver* driver)
+{
+    GBinderDriverStats stats;
+
+    gbinder_driver_get_stats(driver, &stats);
+    if (stats.transactions) {
+        g_test_message("%s: %u ioctls, %u transactions, %.2f ioctls/tx",
+            name, stats.ioctls, stats.transactions,
+            (double)stats.ioctls / stats.transactions);
+    }
+}
+
+/*==========================================================================*
+ * incoming
+ *
+ * Round trip of an incoming transaction: looper thread receives it,
+ * the handler produces the reply, looper sends the reply back.
+ *==========================================================================*/
+
+typedef struct test_bench_incoming {
+    GMainLoop* loop;
+    GBytes* data;
+    int fd;
+    gint count;
+    gint max;
+} TestBenchIncoming;
+
+static
+void
+test_bench_incoming_push(
+    TestBenchIncoming* test,
+    GBinderLocalObject* obj)
+{
+    GByteArray bytes;
+
+    bytes.data = (guint8*)g_bytes_get_data(test->data, NULL);
+    bytes.len = g_bytes_get_size(test->data);
+    test_binder_br_transaction(test->fd, LOOPER_THREAD, obj, 1, &bytes);
+    test_binder_br_transaction_complete(test->fd, LOOPER_THREAD);
+}
+
+static
+GBinderLocalReply*
+test_bench_incoming_proc(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status,
+    void* user_data)
+{
+    TestBenchIncoming* test = user_data;
+
+    /* This may be invoked on the looper thread */
+    if (g_atomic_int_add(&test->count, 1) + 1 < test->max) {
+        test_bench_incoming_push(test, obj);
+    } else {
+        test_quit_later(test->loop);
+    }
+    *status = GBINDER_STATUS_OK;
+    return gbinder_local_object_new_reply(obj);
+}
+
+static
+void
+test_bench_incoming_run2(
+    const char* name,
+    GBINDER_LOCAL_OBJECT_FLAGS flags,
+    gboolean blocking)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
+    GBinderLocalRequest* req = gbinder_local_request_new
+        (gbinder_driver_io(ipc->driver), gbinder_driver_protocol(ipc->driver),
+            NULL);
+    GBinderOutputData* data;
+    GBinderLocalObject* obj;
+    TestBenchIncoming test;
+    GBinderWriter writer;
+    gint64 start;
+
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, FALSE);
+    test.fd = gbinder_driver_fd(ipc->driver);
+    test.max = BENCH_COUNT;
+    gbinder_ipc_set_blocking_loopers(ipc, blocking);
+    obj = gbinder_local_object_new2(ipc, ifaces, test_bench_incoming_proc,
+        &test, flags);
+
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+    gbinder_writer_append_string8(&writer, "message");
+    data = gbinder_local_request_data(req);
+    test.data = g_bytes_new(data->bytes->data, data->bytes->len);
+
+    start = g_get_monotonic_time();
+    test_bench_incoming_push(&test, obj);
+    test_run(&test_opt, test.loop);
+    test_bench_report(name, test.count, g_get_monotonic_time() - start);
+    test_bench_report_driver(name, ipc->driver);
+    g_assert_cmpint(test.count, == ,test.max);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, test.loop);
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(req);
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, test.loop);
+
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_bytes_unref(test.data);
+    g_main_loop_unref(test.loop);
+}
+
+static
+void
+test_bench_incoming_run(
+    const char* name,
+    GBINDER_LOCAL_OBJECT_FLAGS flags)
+{
+    test_bench_incoming_run2(name, flags, FALSE);
+}
+
+static
+void
+test_incoming_run(
+    void)
+{
+    test_bench_incoming_run("incoming", GBINDER_LOCAL_OBJECT_FLAGS_NONE);
+}
+
+static
+void
+test_incoming(
+    void)
+{
+    test_run_in_context(&test_opt, test_incoming_run);
+}
+
+/*==========================================================================*
+ * incoming_direct
+ *==========================================================================*/
+
+static
+void
+test_incoming_direct_run(
+    void)
+{
+    test_bench_incoming_run("incoming_direct",
+        GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD);
+}
+
+static
+void
+test_incoming_direct(
+    void)
+{
+    test_run_in_context(&test_opt, test_incoming_direct_run);
+}
+
+/*==========================================================================*
+ * pingpong
+ *
+ * Same round trip handled right on the looper thread, looper polls the
+ * binder fd before each read. Compare with pingpong_blocking.
+ *==========================================================================*/
+
+static
+void
+test_pingpong_run(
+    void)
+{
+    test_bench_incoming_run2("pingpong",
+        GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD, FALSE);
+}
+
+static
+void
+test_pingpong(
+    void)
+{
+    test_run_in_context(&test_opt, test_pingpong_run);
+}
+
+/*==========================================================================*
+ * pingpong_blocking
+ *
+ * Looper blocks in BINDER_WRITE_READ without polling.
+ *==========================================================================*/
+
+static
+void
+test_pingpong_blocking_run(
+    void)
+{
+    test_bench_incoming_run2("pingpong_blocking",
+        GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD, TRUE);
+}
+
+static
+void
+test_pingpong_blocking(
+    void)
+{
+    test_run_in_context(&test_opt, test_pingpong_blocking_run);
+}
+
+/*==========================================================================*
+ * registry
+ *
+ * Several threads concurrently looking up local objects and remote
+ * handles, like loopers handling incoming transactions do.
+ *==========================================================================*/
+
+#define BENCH_REGISTRY_THREADS (4)
+#define BENCH_REGISTRY_OBJECTS (64)
+#define BENCH_REGISTRY_LOOKUPS (100 * BENCH_COUNT)
+
+typedef struct test_bench_registry {
+    GBinderObjectRegistry* reg;
+    GBinderLocalObject* local[BENCH_REGISTRY_OBJECTS];
+    GBinderRemoteObject* remote[BENCH_REGISTRY_OBJECTS];
+} TestBenchRegistry;
+
+static
+gpointer
+test_bench_registry_thread(
+    gpointer data)
+{
+    TestBenchRegistry* test = data;
+    guint i;
+
+    for (i = 0; i < BENCH_REGISTRY_LOOKUPS; i++) {
+        const guint k = i % BENCH_REGISTRY_OBJECTS;
+        GBinderLocalObject* local = gbinder_object_registry_get_local
+            (test->reg, test->local[k]);
+        GBinderRemoteObject* remote = gbinder_object_registry_get_remote
+            (test->reg, k + 1, REMOTE_REGISTRY_DONT_CREATE);
+
+        g_assert(local == test->local[k]);
+        g_assert(remote == test->remote[k]);
+        gbinder_local_object_unref(local);
+        gbinder_remote_object_unref(remote);
+    }
+    return NULL;
+}
+
+static
+void
+test_registry_run(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GThread* threads[BENCH_REGISTRY_THREADS];
+    TestBenchRegistry test;
+    gint64 start;
+    int i;
+
+    memset(&test, 0, sizeof(test));
+    test.reg = gbinder_ipc_object_registry(ipc);
+    for (i = 0; i < BENCH_REGISTRY_OBJECTS; i++) {
+        test.local[i] = gbinder_local_object_new(ipc, NULL, NULL, NULL);
+        test.remote[i] = gbinder_object_registry_get_remote(test.reg, i + 1,
+            REMOTE_REGISTRY_CAN_CREATE);
+        g_assert(test.remote[i]);
+    }
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < BENCH_REGISTRY_THREADS; i++) {
+        threads[i] = g_thread_new("registry", test_bench_registry_thread,
+            &test);
+    }
+    for (i = 0; i < BENCH_REGISTRY_THREADS; i++) {
+        g_thread_join(threads[i]);
+    }
+    test_bench_report("registry", BENCH_REGISTRY_THREADS *
+        BENCH_REGISTRY_LOOKUPS, g_get_monotonic_time() - start);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
+    for (i = 0; i < BENCH_REGISTRY_OBJECTS; i++) {
+        gbinder_local_object_unref(test.local[i]);
+        gbinder_remote_object_unref(test.remote[i]);
+    }
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, loop);
+
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_registry(
+    void)
+{
+    test_run_in_context(&test_opt, test_registry_run);
+}
+
+/*==========================================================================*
+ * string16
+ *
+ * UTF-8 <=> UTF-16 conversion of typical strings written and read by
+ * AIDL services, compared against plain GLib conversion.
+ *==========================================================================*/
+
+#define BENCH_STRING16_ROUNDS (10 * BENCH_COUNT)
+
+static const char* test_bench_string16_data[] = {
+    "android.os.IServiceManager",
+    "android.hardware.radio.IRadio/slot1",
+    "android.hardware.power.IPower/default",
+    "vendor.qti.hardware.radio.ims@1.0::IImsRadio",
+    "com.android.internal.telephony.ITelephony",
+    "ok",
+    "The quick brown fox jumps over the lazy dog, 0123456789 times",
+    "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, "
+    "\xe4\xb8\x96\xe7\x95\x8c" /* Non-ASCII */
+};
+
+static
+void
+test_string16(
+    void)
+{
+    const guint n = G_N_ELEMENTS(test_bench_string16_data);
+    GBinderDriver* driver = gbinder_driver_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderLocalRequest* req;
+    GBinderOutputData* out;
+    GBinderReaderData data;
+    GBinderReader reader;
+    GBinderWriter writer;
+    gint64 start, write_usec = 0, read_usec = 0;
+    guint i, k;
+
+    memset(&data, 0, sizeof(data));
+    for (i = 0; i < BENCH_STRING16_ROUNDS; i++) {
+        req = gbinder_local_request_new(gbinder_driver_io(driver),
+            gbinder_driver_protocol(driver), NULL);
+        gbinder_local_request_init_writer(req, &writer);
+        start = g_get_monotonic_time();
+        for (k = 0; k < n; k++) {
+            gbinder_writer_append_string16(&writer,
+                test_bench_string16_data[k]);
+        }
+        write_usec += g_get_monotonic_time() - start;
+
+        out = gbinder_local_request_data(req);
+        data.buffer = gbinder_buffer_new(driver, g_memdup(out->bytes->data,
+            out->bytes->len), out->bytes->len, NULL);
+        gbinder_reader_init(&reader, &data, 0, out->bytes->len);
+        start = g_get_monotonic_time();
+        for (k = 0; k < n; k++) {
+            char* str = gbinder_reader_read_string16(&reader);
+
+            g_assert_cmpstr(str, == ,test_bench_string16_data[k]);
+            g_free(str);
+        }
+        read_usec += g_get_monotonic_time() - start;
+        gbinder_buffer_free(data.buffer);
+        gbinder_local_request_unref(req);
+    }
+    test_bench_report("string16 write", BENCH_STRING16_ROUNDS * n, write_usec);
+    test_bench_report("string16 read", BENCH_STRING16_ROUNDS * n, read_usec);
+
+    /* Baseline */
+    start = g_get_monotonic_time();
+    for (i = 0; i < BENCH_STRING16_ROUNDS; i++) {
+        for (k = 0; k < n; k++) {
+            glong len = 0;
+            gunichar2* utf16 = g_utf8_to_utf16(test_bench_string16_data[k],
+                -1, NULL, &len, NULL);
+
+            g_free(g_utf16_to_utf8(utf16, len, NULL, NULL, NULL));
+            g_free(utf16);
+        }
+    }
+    test_bench_report("string16 glib", BENCH_STRING16_ROUNDS * n,
+        g_get_monotonic_time() - start);
+    gbinder_driver_unref(driver);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/bench/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    TestConfig test_config;
+    int result;
+
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+    g_type_init();
+    G_GNUC_END_IGNORE_DEPRECATIONS;
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("incoming"), test_incoming);
+    g_test_add_func(TEST_("incoming_direct"), test_incoming_direct);
+    g_test_add_func(TEST_("pingpong"), test_pingpong);
+    g_test_add_func(TEST_("pingpong_blocking"), test_pingpong_blocking);
+    g_test_add_func(TEST_("registry"), test_registry);
+    g_test_add_func(TEST_("string16"), test_string16);
+    test_init(&test_opt, argc, argv);
+    test_config_init(&test_config, TMP_DIR_TEMPLATE);
+    result = g_test_run();
+    test_config_cleanup(&test_config);
+    return result;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -87,6 +87,12 @@ test_null(
     g_assert(!gbinder_client_transact_sync_reply(NULL, 0, NULL, NULL));
     g_assert(gbinder_client_transact_sync_oneway(NULL, 0, NULL) == (-EINVAL));
     g_assert(!gbinder_client_transact(NULL, 0, 0, NULL, NULL, NULL, NULL));
+    g_assert(!gbinder_client_transact_sync_reply_timeout(NULL, 0, NULL, NULL,
+        0));
+    g_assert(!gbinder_client_transact_sync_reply_timeout(NULL, 0, NULL, NULL,
+        1000));
+    g_assert(!gbinder_client_transact_timeout(NULL, 0, 0, NULL, NULL, NULL,
+        NULL, 1000));
     gbinder_client_cancel(NULL, 0);
 }
 
@@ -274,7 +280,8 @@ static
 void
 test_sync_reply_tx(
     GBinderClient* client,
-    GBinderLocalRequest* req)
+    GBinderLocalRequest* req,
+    guint timeout_ms)
 {
     GBinderDriver* driver = gbinder_client_ipc(client)->driver;
     int fd = gbinder_driver_fd(driver);
@@ -299,7 +306,8 @@ test_sync_reply_tx(
     test_binder_br_noop(fd, THIS_THREAD);
     test_binder_br_reply(fd, THIS_THREAD, handle, code, data->bytes);
 
-    tx_reply = gbinder_client_transact_sync_reply(client, 0, req, &status);
+    tx_reply = gbinder_client_transact_sync_reply_timeout(client, 0, req,
+        &status, timeout_ms);
     g_assert(tx_reply);
     g_assert(status == GBINDER_STATUS_OK);
 
@@ -313,22 +321,38 @@ test_sync_reply_tx(
 
 static
 void
-test_sync_reply(
-    void)
+test_sync_reply_run(
+    guint timeout_ms)
 {
     GBinderClient* client = test_client_new(0, "foo");
     GBinderLocalRequest* req = gbinder_client_new_request(client);
 
-    test_sync_reply_tx(client, req);
+    test_sync_reply_tx(client, req, timeout_ms);
     gbinder_local_request_unref(req);
 
     /* Same but using the internal (empty) request */
-    test_sync_reply_tx(client, NULL);
+    test_sync_reply_tx(client, NULL, timeout_ms);
 
     gbinder_client_unref(client);
     test_binder_exit_wait(&test_opt, NULL);
 }
 
+static
+void
+test_sync_reply(
+    void)
+{
+    test_sync_reply_run(0);
+}
+
+static
+void
+test_sync_reply_timeout(
+    void)
+{
+    test_sync_reply_run(TEST_TIMEOUT_SEC * 1000);
+}
+
 /*==========================================================================*
  * reply
  *==========================================================================*/
@@ -380,7 +404,8 @@ test_reply_tx(
     GBinderClient* client,
     GBinderLocalRequest* req,
     GBinderClientReplyFunc done,
-    GDestroyNotify destroy)
+    GDestroyNotify destroy,
+    guint timeout_ms)
 {
     GBinderDriver* driver = gbinder_client_ipc(client)->driver;
     int fd = gbinder_driver_fd(driver);
@@ -403,7 +428,8 @@ test_reply_tx(
     test_binder_br_noop(fd, TX_THREAD);
     test_binder_br_reply(fd, TX_THREAD, handle, code, data->bytes);
 
-    id = gbinder_client_transact(client, 0, 0, req, done, destroy, loop);
+    id = gbinder_client_transact_timeout(client, 0, 0, req, done, destroy,
+        loop, timeout_ms);
     g_assert(id);
 
     test_run(&test_opt, loop);
@@ -416,17 +442,18 @@ static
 void
 test_reply(
     GBinderClientReplyFunc done,
-    GDestroyNotify destroy)
+    GDestroyNotify destroy,
+    guint timeout_ms)
 {
     GBinderClient* client = test_client_new(0, TEST_INTERFACE);
     GBinderLocalRequest* req = gbinder_client_new_request2(client, 0);
 
     g_assert(req);
-    test_reply_tx(client, req, done, destroy);
+    test_reply_tx(client, req, done, destroy, timeout_ms);
     gbinder_local_request_unref(req);
 
     /* Same but using the internal (empty) request */
-    test_reply_tx(client, NULL, done, destroy);
+    test_reply_tx(client, NULL, done, destroy, timeout_ms);
 
     gbinder_client_unref(client);
     test_binder_exit_wait(&test_opt, NULL);
@@ -437,7 +464,7 @@ void
 test_reply_ok1(
     void)
 {
-    test_reply(test_reply_ok_reply, test_reply_destroy);
+    test_reply(test_reply_ok_reply, test_reply_destroy, 0);
 }
 
 static
@@ -445,7 +472,7 @@ void
 test_reply_ok2(
     void)
 {
-    test_reply(NULL, test_reply_destroy);
+    test_reply(NULL, test_reply_destroy, 0);
 }
 
 static
@@ -453,7 +480,17 @@ void
 test_reply_ok3(
     void)
 {
-    test_reply(test_reply_ok_quit, NULL);
+    test_reply(test_reply_ok_quit, NULL, 0);
+}
+
+static
+void
+test_reply_timeout(
+    void)
+{
+    /* Completes well before the deadline */
+    test_reply(test_reply_ok_reply, test_reply_destroy,
+        TEST_TIMEOUT_SEC * 1000);
 }
 
 /*==========================================================================*
@@ -476,9 +513,11 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("no_header"), test_no_header);
     g_test_add_func(TEST_("sync_oneway"), test_sync_oneway);
     g_test_add_func(TEST_("sync_reply"), test_sync_reply);
+    g_test_add_func(TEST_("sync_reply/timeout"), test_sync_reply_timeout);
     g_test_add_func(TEST_("reply/ok1"), test_reply_ok1);
     g_test_add_func(TEST_("reply/ok2"), test_reply_ok2);
     g_test_add_func(TEST_("reply/ok3"), test_reply_ok3);
+    g_test_add_func(TEST_("reply/timeout"), test_reply_timeout);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
@@ -34,6 +34,8 @@
 
 #include "gbinder_driver.h"
 #include "gbinder_handler.h"
+#include "gbinder_ipc.h"
+#include "gbinder_local_object.h"
 #include "gbinder_local_request_p.h"
 #include "gbinder_output_data.h"
 #include "gbinder_rpc_protocol.h"
@@ -107,6 +109,128 @@ test_noop(
     test_binder_exit_wait(&test_opt, NULL);
 }
 
+/*==========================================================================*
+ * stats
+ *==========================================================================*/
+
+static
+void
+test_stats(
+    void)
+{
+    GBinderDriver* driver = gbinder_driver_new(GBINDER_DEFAULT_BINDER, NULL);
+    const int fd = gbinder_driver_fd(driver);
+    GBinderDriverStats stats;
+    int i;
+
+    gbinder_driver_get_stats(driver, &stats);
+    g_assert_cmpuint(stats.ioctls, == ,0);
+    g_assert_cmpuint(stats.transactions, == ,0);
+
+    /* These are supposed to be fetched with a single ioctl */
+    for (i = 0; i < 64; i++) {
+        test_binder_br_noop(fd, THIS_THREAD);
+    }
+    g_assert(gbinder_driver_read(driver, NULL, NULL) == 0);
+    gbinder_driver_get_stats(driver, &stats);
+    g_assert_cmpuint(stats.ioctls, == ,1);
+    g_assert_cmpuint(stats.transactions, == ,0);
+
+    gbinder_driver_unref(driver);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
+/*==========================================================================*
+ * queue
+ *==========================================================================*/
+
+static
+void
+test_queue(
+    void)
+{
+    GBinderDriver* driver = gbinder_driver_new(GBINDER_DEFAULT_BINDER, NULL);
+    const int fd = gbinder_driver_fd(driver);
+    GBinderDriverStats stats;
+    int i;
+
+    /* Three BC_INCREFS_DONE get written with a single ioctl */
+    for (i = 0; i < 3; i++) {
+        test_binder_br_increfs(fd, THIS_THREAD, NULL);
+    }
+    g_assert(gbinder_driver_read(driver, NULL, NULL) == 0);
+    gbinder_driver_get_stats(driver, &stats);
+    g_assert_cmpuint(stats.ioctls, == ,2);
+
+    /* Nothing is queued outside of gbinder_driver_read() */
+    g_assert(gbinder_driver_acquire(driver, 0));
+    gbinder_driver_get_stats(driver, &stats);
+    g_assert_cmpuint(stats.ioctls, == ,3);
+
+    /* And there's nothing to flush */
+    gbinder_driver_flush(driver);
+    gbinder_driver_get_stats(driver, &stats);
+    g_assert_cmpuint(stats.ioctls, == ,3);
+
+    gbinder_driver_unref(driver);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
+/*==========================================================================*
+ * reply
+ *==========================================================================*/
+
+static
+GBinderLocalReply*
+test_reply_proc(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status,
+    void* user_data)
+{
+    g_assert_cmpuint(code, == ,1);
+    *status = GBINDER_STATUS_OK;
+    return gbinder_local_object_new_reply(obj);
+}
+
+static
+void
+test_reply(
+    void)
+{
+    const char* const ifaces[] = { "test", NULL };
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderObjectRegistry* reg = gbinder_ipc_object_registry(ipc);
+    GBinderDriver* driver = gbinder_driver_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderLocalRequest* req = gbinder_driver_local_request_new(driver,
+        ifaces[0]);
+    GBinderLocalObject* obj = gbinder_local_object_new(ipc, ifaces,
+        test_reply_proc, NULL);
+    const int fd = gbinder_driver_fd(driver);
+    GBinderDriverStats stats;
+
+    test_binder_br_transaction(fd, THIS_THREAD, obj, 1,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_transaction_complete(fd, THIS_THREAD); /* For reply */
+
+    /*
+     * One ioctl to read the transaction, one to write the reply and
+     * read BR_TRANSACTION_COMPLETE and one to free the buffer.
+     */
+    g_assert(gbinder_driver_read(driver, reg, NULL) == 0);
+    gbinder_driver_get_stats(driver, &stats);
+    g_assert_cmpuint(stats.transactions, == ,1);
+    g_assert_cmpuint(stats.ioctls, == ,3);
+
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(req);
+    gbinder_driver_unref(driver);
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
 /*==========================================================================*
  * local_request
  *==========================================================================*/
@@ -150,6 +274,9 @@ int main(int argc, char* argv[])
     g_test_init(&argc, &argv, NULL);
     g_test_add_func(TEST_PREFIX "basic", test_basic);
     g_test_add_func(TEST_PREFIX "noop", test_noop);
+    g_test_add_func(TEST_PREFIX "stats", test_stats);
+    g_test_add_func(TEST_PREFIX "queue", test_queue);
+    g_test_add_func(TEST_PREFIX "reply", test_reply);
     g_test_add_func(TEST_PREFIX "local_request", test_local_request);
     test_init(&test_opt, argc, argv);
     test_config_init(&test_config, TMP_DIR_TEMPLATE);
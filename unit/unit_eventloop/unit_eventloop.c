@@ -33,6 +33,8 @@
 #include "test_common.h"
 #include "gbinder_eventloop_p.h"
 
+#include <unistd.h>
+
 static TestOpt test_opt;
 
 static int test_eventloop_timeout_add_called;
@@ -169,6 +171,10 @@ test_replace(
     gbinder_idle_callback_schedule(NULL);
     gbinder_idle_callback_cancel(NULL);
 
+    /* This one doesn't support watches */
+    g_assert(!gbinder_fd_watch_add(0, test_quit_cb, NULL));
+    gbinder_fd_watch_remove(NULL);
+
     gbinder_eventloop_set(NULL);
     g_assert_cmpint(test_eventloop_cleanup_called, == ,1);
 }
@@ -260,6 +266,32 @@ test_invoke(
     g_main_loop_unref(loop);
 }
 
+/*==========================================================================*
+ * watch
+ *==========================================================================*/
+
+static
+void
+test_watch(
+    void)
+{
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GBinderEventLoopWatch* watch;
+    const guint8 byte = 0;
+    int fd[2];
+
+    gbinder_eventloop_set(NULL);
+    g_assert(!pipe(fd));
+    watch = gbinder_fd_watch_add(fd[0], test_quit_cb, loop);
+    g_assert(watch);
+    g_assert_cmpint(write(fd[1], &byte, 1), == ,1);
+    test_run(&test_opt, loop);
+    gbinder_fd_watch_remove(watch);
+    close(fd[0]);
+    close(fd[1]);
+    g_main_loop_unref(loop);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -274,6 +306,7 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("timeout"), test_timeout);
     g_test_add_func(TEST_("callback"), test_callback);
     g_test_add_func(TEST_("invoke"), test_invoke);
+    g_test_add_func(TEST_("watch"), test_watch);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
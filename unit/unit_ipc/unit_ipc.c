@@ -39,6 +39,7 @@
 #include "gbinder_local_request_p.h"
 #include "gbinder_object_registry.h"
 #include "gbinder_output_data.h"
+#include "gbinder_remote_object_p.h"
 #include "gbinder_remote_reply.h"
 #include "gbinder_remote_request.h"
 #include "gbinder_rpc_protocol.h"
@@ -184,6 +185,50 @@ test_basic(
     test_binder_exit_wait(&test_opt, NULL);
 }
 
+/*==========================================================================*
+ * remote_registry
+ *==========================================================================*/
+
+static
+void
+test_remote_registry(
+    void)
+{
+    /* Dense, sparse and overflow handles */
+    static const guint32 handles[] = { 1, 2, 17, 1000, 0x10000, 0x7fffffff };
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderObjectRegistry* reg = gbinder_ipc_object_registry(ipc);
+    GBinderRemoteObject* obj[G_N_ELEMENTS(handles)];
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(handles); i++) {
+        g_assert(!gbinder_object_registry_get_remote(reg, handles[i],
+            REMOTE_REGISTRY_DONT_CREATE));
+        obj[i] = gbinder_object_registry_get_remote(reg, handles[i],
+            REMOTE_REGISTRY_CAN_CREATE);
+        g_assert(obj[i]);
+        g_assert_cmpuint(obj[i]->handle, == ,handles[i]);
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(handles); i++) {
+        GBinderRemoteObject* found = gbinder_object_registry_get_remote(reg,
+            handles[i], REMOTE_REGISTRY_DONT_CREATE);
+
+        g_assert(found == obj[i]);
+        gbinder_remote_object_unref(found);
+    }
+
+    /* Handles are removed from the registry with the last reference */
+    for (i = 0; i < G_N_ELEMENTS(handles); i++) {
+        gbinder_remote_object_unref(obj[i]);
+        g_assert(!gbinder_object_registry_get_remote(reg, handles[i],
+            REMOTE_REGISTRY_DONT_CREATE));
+    }
+
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
 /*==========================================================================*
  * protocol
  *==========================================================================*/
@@ -265,6 +310,88 @@ test_sync_oneway(
     test_binder_exit_wait(&test_opt, NULL);
 }
 
+/*==========================================================================*
+ * async_oneway_batch
+ *==========================================================================*/
+
+#define TEST_ONEWAY_BATCH (3)
+
+typedef struct test_async_oneway_batch {
+    GMainLoop* loop;
+    gulong id[TEST_ONEWAY_BATCH];
+    int done;
+} TestAsyncOnewayBatch;
+
+static
+void
+test_async_oneway_batch_done(
+    GBinderIpc* ipc,
+    GBinderRemoteReply* reply,
+    int status,
+    void* user_data)
+{
+    TestAsyncOnewayBatch* test = user_data;
+
+    g_assert(!status);
+    g_assert(!reply);
+    test->done++;
+    GDEBUG("%d completion(s)", test->done);
+    if (test->done == TEST_ONEWAY_BATCH) {
+        test_quit_later(test->loop);
+    }
+}
+
+static
+void
+test_async_oneway_batch_not_reached(
+    GBinderIpc* ipc,
+    GBinderRemoteReply* reply,
+    int status,
+    void* user_data)
+{
+    g_assert_not_reached();
+}
+
+static
+void
+test_async_oneway_batch(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    TestAsyncOnewayBatch test;
+    GBinderStats stats;
+    int i;
+
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, FALSE);
+    gbinder_ipc_set_stats(ipc, TRUE);
+
+    /* All of these get written with a single ioctl */
+    for (i = 0; i < TEST_ONEWAY_BATCH; i++) {
+        test_binder_br_transaction_complete(fd, TX_THREAD);
+        test.id[i] = gbinder_ipc_transact(ipc, 0, 1, GBINDER_TX_FLAG_ONEWAY,
+            req, test_async_oneway_batch_done, NULL, &test);
+        g_assert(test.id[i]);
+    }
+
+    /* Cancelled transaction is not sent and its callback is not invoked */
+    gbinder_ipc_cancel(ipc, gbinder_ipc_transact(ipc, 0, 1,
+        GBINDER_TX_FLAG_ONEWAY, req, test_async_oneway_batch_not_reached,
+        NULL, NULL));
+
+    test_run(&test_opt, test.loop);
+    g_assert_cmpint(test.done, == ,TEST_ONEWAY_BATCH);
+    gbinder_ipc_get_stats(ipc, &stats);
+    g_assert_cmpuint(stats.oneway_calls, == ,TEST_ONEWAY_BATCH);
+    g_assert_cmpuint(stats.failed_calls, == ,0);
+
+    gbinder_local_request_unref(req);
+    gbinder_ipc_unref(ipc);
+    g_main_loop_unref(test.loop);
+}
+
 /*==========================================================================*
  * sync_reply_ok
  *==========================================================================*/
@@ -670,106 +797,364 @@ test_transact_custom3(
 }
 
 /*==========================================================================*
- * transact_cancel
+ * transact_custom_batch
  *==========================================================================*/
 
+#define TEST_CUSTOM_BATCH (10)
+
+typedef struct test_transact_custom_batch {
+    GMainLoop* loop;
+    int done;
+} TestTransactCustomBatch;
+
 static
 void
-test_transact_cancel_destroy(
-    void* user_data)
+test_transact_custom_batch_done(
+    const GBinderIpcTx* tx)
 {
-    GVERBOSE_("");
-    test_quit_later((GMainLoop*)user_data);
+    TestTransactCustomBatch* test = tx->user_data;
+
+    test->done++;
+    GDEBUG("%d completion(s)", test->done);
+    if (test->done == TEST_CUSTOM_BATCH) {
+        test_quit_later(test->loop);
+    }
 }
 
 static
 void
-test_transact_cancel_exec(
+test_transact_custom_batch(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderStats stats;
+    TestTransactCustomBatch test;
+    int i;
+
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, FALSE);
+    for (i = 0; i < TEST_CUSTOM_BATCH; i++) {
+        g_assert(gbinder_ipc_transact_custom(ipc, NULL,
+            test_transact_custom_batch_done, NULL, &test));
+    }
+    test_run(&test_opt, test.loop);
+    g_assert_cmpint(test.done, == ,TEST_CUSTOM_BATCH);
+
+    /* Completions have been delivered in one or more batches */
+    gbinder_ipc_get_stats(ipc, &stats);
+    g_assert_cmpuint(stats.completions, == ,TEST_CUSTOM_BATCH);
+    g_assert_cmpuint(stats.completion_queue_depth, == ,0);
+    g_assert_cmpuint(stats.completion_queue_max_depth, >=, 1);
+    g_assert_cmpuint(stats.completion_queue_max_depth, <=, TEST_CUSTOM_BATCH);
+    g_assert_cmpuint(stats.completion_batches, >=, 1);
+    g_assert_cmpuint(stats.completion_batches, <=, TEST_CUSTOM_BATCH);
+
+    gbinder_ipc_exit();
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_main_loop_unref(test.loop);
+}
+
+/*==========================================================================*
+ * transact_urgent
+ *==========================================================================*/
+
+typedef struct test_transact_urgent {
+    GMainLoop* loop;
+    GMutex mutex;
+    GCond cond;
+    gboolean released;
+    gboolean urgent_done;
+} TestTransactUrgent;
+
+static
+void
+test_transact_urgent_blocker_exec(
     const GBinderIpcTx* tx)
 {
+    TestTransactUrgent* test = tx->user_data;
+
+    /* Occupies the only thread of the normal lane */
     GVERBOSE_("");
+    g_mutex_lock(&test->mutex);
+    while (!test->released) {
+        g_cond_wait(&test->cond, &test->mutex);
+    }
+    g_mutex_unlock(&test->mutex);
 }
 
 static
 void
-test_transact_cancel_done(
+test_transact_urgent_blocker_done(
     const GBinderIpcTx* tx)
 {
+    TestTransactUrgent* test = tx->user_data;
+
     GVERBOSE_("");
-    g_assert(tx->cancelled);
+    g_assert(test->urgent_done);
+    test_quit_later(test->loop);
 }
 
 static
 void
-test_transact_cancel(
+test_transact_urgent_done(
+    GBinderIpc* ipc,
+    GBinderRemoteReply* reply,
+    int status,
+    void* user_data)
+{
+    TestTransactUrgent* test = user_data;
+
+    /* Completes while the normal lane is still blocked */
+    GVERBOSE_("");
+    g_assert_cmpint(status, == ,GBINDER_STATUS_OK);
+    test->urgent_done = TRUE;
+    g_mutex_lock(&test->mutex);
+    test->released = TRUE;
+    g_cond_broadcast(&test->cond);
+    g_mutex_unlock(&test->mutex);
+}
+
+static
+void
+test_transact_urgent(
     void)
 {
     GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
-    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
-    gulong id = gbinder_ipc_transact_custom(ipc, test_transact_cancel_exec,
-        test_transact_cancel_done, test_transact_cancel_destroy, loop);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalReply* reply = test_local_reply_new(ipc);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    TestTransactUrgent test;
+
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, FALSE);
+    g_mutex_init(&test.mutex);
+    g_cond_init(&test.cond);
+
+    /* Invalid parameters */
+    g_assert(!gbinder_ipc_set_tx_threads(NULL, GBINDER_TX_LANE_NORMAL, 1));
+    g_assert(!gbinder_ipc_set_tx_threads(ipc, GBINDER_TX_LANE_NORMAL, 0));
+    g_assert(!gbinder_ipc_set_tx_threads(ipc, (GBINDER_TX_LANE)-1, 1));
+    g_assert(!gbinder_ipc_get_tx_threads(NULL, GBINDER_TX_LANE_NORMAL));
+    g_assert(!gbinder_ipc_get_tx_threads(ipc, (GBINDER_TX_LANE)-1));
+
+    /* No limit */
+    g_assert(gbinder_ipc_set_max_threads(ipc, -1));
+    g_assert_cmpuint(gbinder_ipc_get_tx_threads(ipc,
+        GBINDER_TX_LANE_NORMAL), == ,G_MAXUINT);
+
+    g_assert(gbinder_ipc_set_tx_threads(ipc, GBINDER_TX_LANE_NORMAL, 1));
+    g_assert(gbinder_ipc_set_tx_threads(ipc, GBINDER_TX_LANE_URGENT, 2));
+    g_assert_cmpuint(gbinder_ipc_get_tx_threads(ipc,
+        GBINDER_TX_LANE_NORMAL), == ,1);
+    g_assert_cmpuint(gbinder_ipc_get_tx_threads(ipc,
+        GBINDER_TX_LANE_URGENT), == ,2);
+
+    /* Block the normal lane and submit an urgent transaction */
+    g_assert(gbinder_ipc_transact_custom(ipc,
+        test_transact_urgent_blocker_exec, test_transact_urgent_blocker_done,
+        NULL, &test));
 
-    g_assert(id);
-    gbinder_ipc_cancel(ipc, id);
-    test_run(&test_opt, loop);
+    test_binder_br_noop(fd, TX_THREAD);
+    test_binder_br_transaction_complete(fd, TX_THREAD);
+    test_binder_br_noop(fd, TX_THREAD);
+    test_binder_br_reply(fd, TX_THREAD, 0, 1,
+        gbinder_local_reply_data(reply)->bytes);
+    g_assert(gbinder_ipc_transact(ipc, 0, 1, GBINDER_TX_FLAG_URGENT, req,
+        test_transact_urgent_done, NULL, &test));
+
+    test_run(&test_opt, test.loop);
+    g_assert(test.urgent_done);
 
+    gbinder_local_request_unref(req);
+    gbinder_local_reply_unref(reply);
     gbinder_ipc_unref(ipc);
-    test_binder_exit_wait(&test_opt, loop);
-    g_main_loop_unref(loop);
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_main_loop_unref(test.loop);
+    g_mutex_clear(&test.mutex);
+    g_cond_clear(&test.cond);
 }
 
 /*==========================================================================*
- * transact_cancel2
+ * transact_deadline
  *==========================================================================*/
 
+typedef struct test_transact_deadline {
+    GMainLoop* loop;
+    GMutex mutex;
+    GCond cond;
+    gboolean released;
+    gboolean timed_out;
+} TestTransactDeadline;
+
 static
-gboolean
-test_transact_cancel2_cancel(
-    gpointer data)
+void
+test_transact_deadline_blocker_exec(
+    const GBinderIpcTx* tx)
 {
-    const GBinderIpcTx* tx = data;
+    TestTransactDeadline* test = tx->user_data;
 
+    /* Occupies the only thread of the normal lane */
     GVERBOSE_("");
-    gbinder_ipc_cancel(tx->ipc, tx->id);
-    return G_SOURCE_REMOVE;
+    g_mutex_lock(&test->mutex);
+    while (!test->released) {
+        g_cond_wait(&test->cond, &test->mutex);
+    }
+    g_mutex_unlock(&test->mutex);
 }
 
 static
 void
-test_transact_cancel2_exec(
+test_transact_deadline_blocker_done(
     const GBinderIpcTx* tx)
 {
+    TestTransactDeadline* test = tx->user_data;
+
     GVERBOSE_("");
-    g_assert(!tx->cancelled);
-    g_main_context_invoke(NULL, test_transact_cancel2_cancel, (void*)tx);
+    g_assert(test->timed_out);
+    test_quit_later(test->loop);
 }
 
 static
 void
-test_transact_cancel2(
+test_transact_deadline_done(
+    GBinderIpc* ipc,
+    GBinderRemoteReply* reply,
+    int status,
+    void* user_data)
+{
+    TestTransactDeadline* test = user_data;
+
+    /* Times out while still sitting in the queue */
+    GVERBOSE_("");
+    g_assert(!reply);
+    g_assert_cmpint(status, == ,-ETIMEDOUT);
+    test->timed_out = TRUE;
+}
+
+static
+void
+test_transact_deadline_destroy(
+    void* user_data)
+{
+    TestTransactDeadline* test = user_data;
+
+    /* The late transaction gets dropped without being sent */
+    GVERBOSE_("");
+    g_assert(test->timed_out);
+    g_mutex_lock(&test->mutex);
+    test->released = TRUE;
+    g_cond_broadcast(&test->cond);
+    g_mutex_unlock(&test->mutex);
+}
+
+static
+void
+test_transact_deadline(
     void)
 {
     GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
-    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
-    /* Reusing test_transact_cancel_done and test_transact_cancel_destroy */
-    gulong id = gbinder_ipc_transact_custom(ipc, test_transact_cancel2_exec,
-        test_transact_cancel_done, test_transact_cancel_destroy, loop);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderStats stats;
+    TestTransactDeadline test;
+    int status = INT_MAX;
 
-    g_assert(id);
-    test_run(&test_opt, loop);
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, FALSE);
+    g_mutex_init(&test.mutex);
+    g_cond_init(&test.cond);
+    gbinder_ipc_set_stats(ipc, TRUE);
+
+    /* Invalid parameters */
+    g_assert(!gbinder_ipc_transact_deadline(NULL, 0, 1, 0, req, NULL, NULL,
+        NULL, 1));
+    g_assert(!gbinder_ipc_transact_sync_reply_deadline(NULL, 0, 1, req,
+        &status, 1));
+    g_assert_cmpint(status, == ,-EINVAL);
 
+    /* Block the normal lane */
+    g_assert(gbinder_ipc_set_tx_threads(ipc, GBINDER_TX_LANE_NORMAL, 1));
+    g_assert(gbinder_ipc_transact_custom(ipc,
+        test_transact_deadline_blocker_exec,
+        test_transact_deadline_blocker_done, NULL, &test));
+
+    /* The deadline has already passed, nothing gets sent */
+    status = INT_MAX;
+    g_assert(!gbinder_ipc_transact_sync_reply_deadline(ipc, 0, 1, req,
+        &status, g_get_monotonic_time() - 1));
+    g_assert_cmpint(status, == ,-ETIMEDOUT);
+
+    /* The watchdog completes the transaction stuck in the queue */
+    g_assert(gbinder_ipc_transact_deadline(ipc, 0, 1, 0, req,
+        test_transact_deadline_done, test_transact_deadline_destroy, &test,
+        g_get_monotonic_time() + 100000));
+
+    test_run(&test_opt, test.loop);
+    g_assert(test.timed_out);
+    gbinder_ipc_get_stats(ipc, &stats);
+    g_assert_cmpuint(stats.sync_calls.count, == ,1);
+    g_assert_cmpuint(stats.async_calls.count, == ,1);
+    g_assert_cmpuint(stats.failed_calls, == ,2);
+
+    gbinder_local_request_unref(req);
     gbinder_ipc_unref(ipc);
-    test_binder_exit_wait(&test_opt, loop);
-    g_main_loop_unref(loop);
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_main_loop_unref(test.loop);
+    g_mutex_clear(&test.mutex);
+    g_cond_clear(&test.cond);
 }
 
 /*==========================================================================*
- * transact_2way
+ * transact_deadline_abandon
  *==========================================================================*/
 
+typedef struct test_transact_deadline_abandon {
+    GMainLoop* loop;
+    GBinderIpc* ipc;
+    GBinderLocalObject* obj;
+    GBinderRemoteRequest* req;
+    gboolean timed_out;
+    gboolean extra_done;
+} TestTransactDeadlineAbandon;
+
+static
+gboolean
+test_transact_deadline_abandon_check(
+    gpointer user_data)
+{
+    TestTransactDeadlineAbandon* test = user_data;
+
+    /* Wait for the abandoned worker to return its slot */
+    if (gbinder_ipc_get_tx_abandoned(test->ipc, GBINDER_TX_LANE_NORMAL)) {
+        return G_SOURCE_CONTINUE;
+    } else {
+        GVERBOSE_("");
+        g_assert_cmpuint(gbinder_ipc_get_tx_threads(test->ipc,
+            GBINDER_TX_LANE_NORMAL), == ,1);
+        test_quit_later(test->loop);
+        return G_SOURCE_REMOVE;
+    }
+}
+
+static
+void
+test_transact_deadline_abandon_reply(
+    TestTransactDeadlineAbandon* test)
+{
+    /* Reply when both the request and the extra transaction are there */
+    if (test->req && test->extra_done) {
+        GBinderLocalReply* reply = gbinder_local_object_new_reply(test->obj);
+
+        GVERBOSE_("");
+        gbinder_remote_request_complete(test->req, reply, 0);
+        gbinder_local_reply_unref(reply);
+        g_timeout_add(10, test_transact_deadline_abandon_check, test);
+    }
+}
+
 static
 GBinderLocalReply*
-test_transact_2way_incoming_proc(
+test_transact_deadline_abandon_proc(
     GBinderLocalObject* obj,
     GBinderRemoteRequest* req,
     guint code,
@@ -777,25 +1162,57 @@ test_transact_2way_incoming_proc(
     int* status,
     void* user_data)
 {
-    int* incoming_call = user_data;
+    TestTransactDeadlineAbandon* test = user_data;
 
-    GVERBOSE_("\"%s\" %u", gbinder_remote_request_interface(req), code);
-    g_assert_cmpuint(flags, == ,0);
-    g_assert_cmpint(gbinder_remote_request_sender_pid(req), == ,getpid());
-    g_assert_cmpint(gbinder_remote_request_sender_euid(req), == ,geteuid());
-    g_assert_cmpstr(gbinder_remote_request_interface(req), == ,"test");
-    g_assert_cmpstr(gbinder_remote_request_read_string8(req), == ,"message");
-    g_assert_cmpuint(code, == ,2);
-    g_assert_cmpint(*incoming_call, == ,0);
-    (*incoming_call)++;
+    /* Doesn't answer until the caller has given up */
+    GVERBOSE_("");
+    g_assert(!test->req);
+    test->req = gbinder_remote_request_ref(req);
+    gbinder_remote_request_block(req);
+    test_transact_deadline_abandon_reply(test);
+    return NULL;
+}
 
-    *status = GBINDER_STATUS_OK;
-    return gbinder_local_object_new_reply(obj);
+static
+void
+test_transact_deadline_abandon_extra_done(
+    const GBinderIpcTx* tx)
+{
+    TestTransactDeadlineAbandon* test = tx->user_data;
+
+    /* This one could only run on the extra thread */
+    GVERBOSE_("");
+    test->extra_done = TRUE;
+    test_transact_deadline_abandon_reply(test);
 }
 
 static
 void
-test_transact_2way_run(
+test_transact_deadline_abandon_done(
+    GBinderIpc* ipc,
+    GBinderRemoteReply* reply,
+    int status,
+    void* user_data)
+{
+    TestTransactDeadlineAbandon* test = user_data;
+
+    /* Invoked once, the late reply is discarded */
+    GVERBOSE_("");
+    g_assert(!test->timed_out);
+    g_assert(!reply);
+    g_assert_cmpint(status, == ,-ETIMEDOUT);
+    test->timed_out = TRUE;
+
+    /* The stuck worker has been abandoned */
+    g_assert_cmpuint(gbinder_ipc_get_tx_abandoned(ipc,
+        GBINDER_TX_LANE_NORMAL), == ,1);
+    g_assert(gbinder_ipc_transact_custom(ipc, NULL,
+        test_transact_deadline_abandon_extra_done, NULL, test));
+}
+
+static
+void
+test_transact_deadline_abandon_run(
     void)
 {
     GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
@@ -803,116 +1220,511 @@ test_transact_2way_run(
     const char* dev = gbinder_driver_dev(ipc->driver);
     const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
     const char* const ifaces[] = { "test", NULL };
-    const guint32 handle = 0;
-    const guint32 code = 1;
-    int incoming_call = 0;
-    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
-    GBinderLocalObject* obj = gbinder_local_object_new
-        (ipc, ifaces, test_transact_2way_incoming_proc, &incoming_call);
     GBinderLocalRequest* req = test_local_request_new(ipc);
-    GBinderLocalRequest* incoming_req = test_local_request_new(ipc);
-    GBinderLocalReply* reply = test_local_reply_new(ipc);
+    TestTransactDeadlineAbandon test;
     GBinderWriter writer;
+    guint handle;
 
-    /* Prepare reply */
-    g_assert(gbinder_local_reply_append_string16(reply, TEST_REQ_PARAM_STR));
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, FALSE);
+    test.ipc = ipc;
+    test.obj = gbinder_local_object_new(ipc, ifaces,
+        test_transact_deadline_abandon_proc, &test);
+    handle = test_binder_register_object(fd, test.obj, AUTO_HANDLE);
 
-    /* Prepare incoming request */
     gbinder_local_request_init_writer(req, &writer);
     prot->write_rpc_header(&writer, "test");
     gbinder_writer_append_string8(&writer, "message");
 
-    test_binder_ignore_dead_object(fd);
-    test_binder_br_transaction(fd, TX_THREAD, obj, 2,
-        gbinder_local_request_data(req)->bytes);
-    test_binder_br_noop(fd, TX_THREAD);
-    test_binder_br_transaction_complete(fd, TX_THREAD);
-    test_binder_br_noop(fd, TX_THREAD);
-    test_binder_br_reply(fd, TX_THREAD, handle, code,
-        gbinder_local_reply_data(reply)->bytes);
-
-    /* NB. Reusing test_transact_ok_done and test_transact_ok_destroy */
-    g_assert(gbinder_ipc_transact(ipc, handle, code, 0, req,
-        test_transact_ok_done, test_transact_ok_destroy, loop));
+    /* The only worker gets stuck in the driver */
+    g_assert(gbinder_ipc_set_tx_threads(ipc, GBINDER_TX_LANE_NORMAL, 1));
+    g_assert(gbinder_ipc_transact_deadline(ipc, handle, 1, 0, req,
+        test_transact_deadline_abandon_done, NULL, &test,
+        g_get_monotonic_time() + 200000));
 
-    test_run(&test_opt, loop);
+    test_run(&test_opt, test.loop);
+    g_assert(test.timed_out);
+    g_assert(test.extra_done);
+    gbinder_remote_request_unref(test.req);
+    gbinder_local_request_unref(req);
 
     /* Now we need to wait until GBinderIpc is destroyed */
     GDEBUG("waiting for GBinderIpc to get destroyed");
-    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
-    gbinder_local_object_unref(obj);
-    gbinder_local_request_unref(req);
-    gbinder_local_request_unref(incoming_req);
-    gbinder_local_reply_unref(reply);
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, test.loop);
+    gbinder_local_object_unref(test.obj);
     g_idle_add(test_unref_ipc, ipc);
-    test_run(&test_opt, loop);
+    test_run(&test_opt, test.loop);
 
-    test_binder_exit_wait(&test_opt, loop);
-    g_main_loop_unref(loop);
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_main_loop_unref(test.loop);
 }
 
 static
 void
-test_transact_2way(
+test_transact_deadline_abandon(
     void)
 {
-    test_run_in_context(&test_opt, test_transact_2way_run);
+    test_run_in_context(&test_opt, test_transact_deadline_abandon_run);
 }
 
 /*==========================================================================*
- * transact_unhandled
+ * sync_reply_deadline
  *==========================================================================*/
 
 static
 void
-test_transact_unhandled_done(
-    GBinderIpc* ipc,
-    GBinderRemoteReply* reply,
-    int status,
+test_sync_reply_deadline(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalReply* late = test_local_reply_new(ipc);
+    GBinderLocalReply* reply = test_local_reply_new(ipc);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    const guint32 handle = 0;
+    const guint32 code = 1;
+    GBinderRemoteReply* tx_reply;
+    int status = INT_MAX;
+    char* result;
+
+    g_assert(gbinder_local_reply_append_string16(late, "late"));
+    g_assert(gbinder_local_reply_append_string16(reply, "foo"));
+
+    /* Nobody answers, the calling thread gives up waiting */
+    test_binder_ignore_dead_object(fd);
+    g_assert(!gbinder_ipc_transact_sync_reply_deadline(ipc, handle, code,
+        req, &status, g_get_monotonic_time() + 100000));
+    g_assert_cmpint(status, == ,-ETIMEDOUT);
+    g_assert(gbinder_driver_has_abandoned_tx(ipc->driver));
+
+    /* One-way transactions can still be sent from this thread */
+    test_binder_ignore_dead_object(fd);
+    test_binder_br_transaction_complete(fd, THIS_THREAD);
+    g_assert(gbinder_ipc_transact(ipc, handle, code, GBINDER_TX_FLAG_ONEWAY,
+        req, test_async_oneway_done, NULL, loop));
+    test_run(&test_opt, loop);
+    g_assert(gbinder_driver_has_abandoned_tx(ipc->driver));
+
+    /* Synchronous ones fail right away rather than block */
+    status = INT_MAX;
+    g_assert(!gbinder_ipc_sync_main.sync_reply(ipc, handle, code, req,
+        &status));
+    g_assert_cmpint(status, == ,-EBUSY);
+    g_assert(gbinder_driver_has_abandoned_tx(ipc->driver));
+
+    /* The late reply isn't mistaken for the one-way status */
+    test_binder_ignore_dead_object(fd);
+    test_binder_br_reply(fd, THIS_THREAD, handle, code,
+        gbinder_local_reply_data(late)->bytes);
+    test_binder_br_transaction_complete(fd, THIS_THREAD);
+    g_assert(gbinder_ipc_transact(ipc, handle, code, GBINDER_TX_FLAG_ONEWAY,
+        req, test_async_oneway_done, NULL, loop));
+    test_run(&test_opt, loop);
+    g_assert(!gbinder_driver_has_abandoned_tx(ipc->driver));
+
+    /* And the thread is good for synchronous transactions again */
+    test_binder_ignore_dead_object(fd);
+    test_binder_br_transaction_complete(fd, THIS_THREAD);
+    test_binder_br_reply(fd, THIS_THREAD, handle, code,
+        gbinder_local_reply_data(reply)->bytes);
+
+    status = INT_MAX;
+    tx_reply = gbinder_ipc_sync_main.sync_reply(ipc, handle, code, req,
+        &status);
+    g_assert(tx_reply);
+    g_assert_cmpint(status, == ,GBINDER_STATUS_OK);
+
+    result = gbinder_remote_reply_read_string16(tx_reply);
+    g_assert_cmpstr(result, == ,"foo");
+    g_free(result);
+
+    gbinder_remote_reply_unref(tx_reply);
+    gbinder_local_request_unref(req);
+    gbinder_local_reply_unref(late);
+    gbinder_local_reply_unref(reply);
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * transact_cancel
+ *==========================================================================*/
+
+static
+void
+test_transact_cancel_destroy(
+    void* user_data)
+{
+    GVERBOSE_("");
+    test_quit_later((GMainLoop*)user_data);
+}
+
+static
+void
+test_transact_cancel_exec(
+    const GBinderIpcTx* tx)
+{
+    GVERBOSE_("");
+}
+
+static
+void
+test_transact_cancel_done(
+    const GBinderIpcTx* tx)
+{
+    GVERBOSE_("");
+    g_assert(tx->cancelled);
+}
+
+static
+void
+test_transact_cancel(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    gulong id = gbinder_ipc_transact_custom(ipc, test_transact_cancel_exec,
+        test_transact_cancel_done, test_transact_cancel_destroy, loop);
+
+    g_assert(id);
+    gbinder_ipc_cancel(ipc, id);
+    test_run(&test_opt, loop);
+
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * transact_cancel2
+ *==========================================================================*/
+
+static
+gboolean
+test_transact_cancel2_cancel(
+    gpointer data)
+{
+    const GBinderIpcTx* tx = data;
+
+    GVERBOSE_("");
+    gbinder_ipc_cancel(tx->ipc, tx->id);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_transact_cancel2_exec(
+    const GBinderIpcTx* tx)
+{
+    GVERBOSE_("");
+    g_assert(!tx->cancelled);
+    g_main_context_invoke(NULL, test_transact_cancel2_cancel, (void*)tx);
+}
+
+static
+void
+test_transact_cancel2(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    /* Reusing test_transact_cancel_done and test_transact_cancel_destroy */
+    gulong id = gbinder_ipc_transact_custom(ipc, test_transact_cancel2_exec,
+        test_transact_cancel_done, test_transact_cancel_destroy, loop);
+
+    g_assert(id);
+    test_run(&test_opt, loop);
+
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * transact_2way
+ *==========================================================================*/
+
+static
+GBinderLocalReply*
+test_transact_2way_incoming_proc(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status,
     void* user_data)
 {
-    g_assert(!reply);
-    g_assert_cmpint(status, == ,GBINDER_STATUS_DEAD_OBJECT);
-    test_quit_later((GMainLoop*)user_data);
+    int* incoming_call = user_data;
+
+    GVERBOSE_("\"%s\" %u", gbinder_remote_request_interface(req), code);
+    g_assert_cmpuint(flags, == ,0);
+    g_assert_cmpint(gbinder_remote_request_sender_pid(req), == ,getpid());
+    g_assert_cmpint(gbinder_remote_request_sender_euid(req), == ,geteuid());
+    g_assert_cmpstr(gbinder_remote_request_interface(req), == ,"test");
+    g_assert_cmpstr(gbinder_remote_request_read_string8(req), == ,"message");
+    g_assert_cmpuint(code, == ,2);
+    g_assert_cmpint(*incoming_call, == ,0);
+    (*incoming_call)++;
+
+    *status = GBINDER_STATUS_OK;
+    return gbinder_local_object_new_reply(obj);
+}
+
+static
+void
+test_transact_2way_run(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
+    const guint32 handle = 0;
+    const guint32 code = 1;
+    int incoming_call = 0;
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GBinderLocalObject* obj = gbinder_local_object_new
+        (ipc, ifaces, test_transact_2way_incoming_proc, &incoming_call);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalRequest* incoming_req = test_local_request_new(ipc);
+    GBinderLocalReply* reply = test_local_reply_new(ipc);
+    GBinderWriter writer;
+
+    /* Prepare reply */
+    g_assert(gbinder_local_reply_append_string16(reply, TEST_REQ_PARAM_STR));
+
+    /* Prepare incoming request */
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+    gbinder_writer_append_string8(&writer, "message");
+
+    test_binder_ignore_dead_object(fd);
+    test_binder_br_transaction(fd, TX_THREAD, obj, 2,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_noop(fd, TX_THREAD);
+    test_binder_br_transaction_complete(fd, TX_THREAD);
+    test_binder_br_noop(fd, TX_THREAD);
+    test_binder_br_reply(fd, TX_THREAD, handle, code,
+        gbinder_local_reply_data(reply)->bytes);
+
+    /* NB. Reusing test_transact_ok_done and test_transact_ok_destroy */
+    g_assert(gbinder_ipc_transact(ipc, handle, code, 0, req,
+        test_transact_ok_done, test_transact_ok_destroy, loop));
+
+    test_run(&test_opt, loop);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    GDEBUG("waiting for GBinderIpc to get destroyed");
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(req);
+    gbinder_local_request_unref(incoming_req);
+    gbinder_local_reply_unref(reply);
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, loop);
+
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_transact_2way(
+    void)
+{
+    test_run_in_context(&test_opt, test_transact_2way_run);
+}
+
+/*==========================================================================*
+ * transact_unhandled
+ *==========================================================================*/
+
+static
+void
+test_transact_unhandled_done(
+    GBinderIpc* ipc,
+    GBinderRemoteReply* reply,
+    int status,
+    void* user_data)
+{
+    g_assert(!reply);
+    g_assert_cmpint(status, == ,GBINDER_STATUS_DEAD_OBJECT);
+    test_quit_later((GMainLoop*)user_data);
+}
+
+
+static
+void
+test_transact_unhandled_run(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderDriver* driver = ipc->driver;
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GBinderLocalRequest* req = gbinder_driver_local_request_new_ping(driver);
+
+    g_assert(gbinder_ipc_transact(ipc, 1 /* Non-existent object */,
+        gbinder_driver_protocol(driver)->ping_tx, 0, req,
+        test_transact_unhandled_done, NULL, loop));
+    gbinder_local_request_unref(req);
+    test_run(&test_opt, loop);
+
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_transact_unhandled(
+    void)
+{
+    test_run_in_context(&test_opt, test_transact_unhandled_run);
+}
+
+/*==========================================================================*
+ * transact_incoming
+ *==========================================================================*/
+
+static
+GBinderLocalReply*
+test_transact_incoming_proc(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status,
+    void* user_data)
+{
+    GVERBOSE_("\"%s\" %u", gbinder_remote_request_interface(req), code);
+    g_assert(!flags);
+    g_assert(gbinder_remote_request_sender_pid(req) == getpid());
+    g_assert(gbinder_remote_request_sender_euid(req) == geteuid());
+    g_assert(!g_strcmp0(gbinder_remote_request_interface(req), "test"));
+    g_assert(!g_strcmp0(gbinder_remote_request_read_string8(req), "message"));
+    g_assert(code == 1);
+    test_quit_later((GMainLoop*)user_data);
+
+    *status = GBINDER_STATUS_OK;
+    return gbinder_local_object_new_reply(obj);
+}
+
+static
+void
+test_transact_incoming_run(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GBinderLocalObject* obj = gbinder_local_object_new
+        (ipc, ifaces, test_transact_incoming_proc, loop);
+    GBinderLocalRequest* ping = test_local_request_new(ipc);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderWriter writer;
+
+    gbinder_local_request_init_writer(ping, &writer);
+    prot->write_ping(&writer);
+
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+    gbinder_writer_append_string8(&writer, "message");
+
+    test_binder_br_transaction(fd, LOOPER_THREAD, obj, prot->ping_tx,
+        gbinder_local_request_data(ping)->bytes);
+    test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
+    test_binder_br_transaction(fd, LOOPER_THREAD, obj, 1,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
+    test_run(&test_opt, loop);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    GDEBUG("waiting for GBinderIpc to get destroyed");
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(ping);
+    gbinder_local_request_unref(req);
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, loop);
+
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_transact_incoming(
+    void)
+{
+    test_run_in_context(&test_opt, test_transact_incoming_run);
 }
 
+/*==========================================================================*
+ * blocking_loopers
+ *==========================================================================*/
 
 static
 void
-test_transact_unhandled_run(
+test_blocking_loopers_run(
     void)
 {
     GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
-    GBinderDriver* driver = ipc->driver;
+    const int fd = gbinder_driver_fd(ipc->driver);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
     GMainLoop* loop = g_main_loop_new(NULL, FALSE);
-    GBinderLocalRequest* req = gbinder_driver_local_request_new_ping(driver);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalObject* obj;
+    GBinderWriter writer;
 
-    g_assert(gbinder_ipc_transact(ipc, 1 /* Non-existent object */,
-        gbinder_driver_protocol(driver)->ping_tx, 0, req,
-        test_transact_unhandled_done, NULL, loop));
+    /* Loopers started from now on don't poll */
+    gbinder_ipc_set_blocking_loopers(ipc, TRUE);
+    obj = gbinder_local_object_new(ipc, ifaces, test_transact_incoming_proc,
+        loop);
+
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+    gbinder_writer_append_string8(&writer, "message");
+
+    test_binder_br_transaction(fd, LOOPER_THREAD, obj, 1,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
+    test_run(&test_opt, loop);
+
+    /* The looper gets kicked out of the read at shutdown */
+    GDEBUG("waiting for GBinderIpc to get destroyed");
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
+    gbinder_local_object_unref(obj);
     gbinder_local_request_unref(req);
+    g_idle_add(test_unref_ipc, ipc);
     test_run(&test_opt, loop);
 
-    gbinder_ipc_unref(ipc);
     test_binder_exit_wait(&test_opt, loop);
     g_main_loop_unref(loop);
 }
 
 static
 void
-test_transact_unhandled(
+test_blocking_loopers(
     void)
 {
-    test_run_in_context(&test_opt, test_transact_unhandled_run);
+    test_run_in_context(&test_opt, test_blocking_loopers_run);
 }
 
 /*==========================================================================*
- * transact_incoming
+ * main_loop_polling
  *==========================================================================*/
 
 static
 GBinderLocalReply*
-test_transact_incoming_proc(
+test_main_loop_polling_proc(
     GBinderLocalObject* obj,
     GBinderRemoteRequest* req,
     guint code,
@@ -921,9 +1733,8 @@ test_transact_incoming_proc(
     void* user_data)
 {
     GVERBOSE_("\"%s\" %u", gbinder_remote_request_interface(req), code);
-    g_assert(!flags);
-    g_assert(gbinder_remote_request_sender_pid(req) == getpid());
-    g_assert(gbinder_remote_request_sender_euid(req) == geteuid());
+    /* There are no loopers, it's all done on the main thread */
+    g_assert(g_main_context_is_owner(g_main_context_default()));
     g_assert(!g_strcmp0(gbinder_remote_request_interface(req), "test"));
     g_assert(!g_strcmp0(gbinder_remote_request_read_string8(req), "message"));
     g_assert(code == 1);
@@ -935,7 +1746,7 @@ test_transact_incoming_proc(
 
 static
 void
-test_transact_incoming_run(
+test_main_loop_polling_run(
     void)
 {
     GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
@@ -944,22 +1755,18 @@ test_transact_incoming_run(
     const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
     const char* const ifaces[] = { "test", NULL };
     GMainLoop* loop = g_main_loop_new(NULL, FALSE);
-    GBinderLocalObject* obj = gbinder_local_object_new
-        (ipc, ifaces, test_transact_incoming_proc, loop);
-    GBinderLocalRequest* ping = test_local_request_new(ipc);
     GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalObject* obj;
     GBinderWriter writer;
 
-    gbinder_local_request_init_writer(ping, &writer);
-    prot->write_ping(&writer);
+    gbinder_ipc_set_main_loop_polling(ipc, TRUE);
+    obj = gbinder_local_object_new(ipc, ifaces, test_main_loop_polling_proc,
+        loop);
 
     gbinder_local_request_init_writer(req, &writer);
     prot->write_rpc_header(&writer, "test");
     gbinder_writer_append_string8(&writer, "message");
 
-    test_binder_br_transaction(fd, LOOPER_THREAD, obj, prot->ping_tx,
-        gbinder_local_request_data(ping)->bytes);
-    test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
     test_binder_br_transaction(fd, LOOPER_THREAD, obj, 1,
         gbinder_local_request_data(req)->bytes);
     test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
@@ -969,7 +1776,6 @@ test_transact_incoming_run(
     GDEBUG("waiting for GBinderIpc to get destroyed");
     g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
     gbinder_local_object_unref(obj);
-    gbinder_local_request_unref(ping);
     gbinder_local_request_unref(req);
     g_idle_add(test_unref_ipc, ipc);
     test_run(&test_opt, loop);
@@ -980,10 +1786,228 @@ test_transact_incoming_run(
 
 static
 void
-test_transact_incoming(
+test_main_loop_polling(
     void)
 {
-    test_run_in_context(&test_opt, test_transact_incoming_run);
+    test_run_in_context(&test_opt, test_main_loop_polling_run);
+}
+
+/*==========================================================================*
+ * transact_direct
+ *==========================================================================*/
+
+typedef struct test_transact_direct {
+    GMainLoop* loop;
+    GThread* main_thread;
+} TestTransactDirect;
+
+static
+GBinderLocalReply*
+test_transact_direct_proc(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status,
+    void* user_data)
+{
+    TestTransactDirect* test = user_data;
+
+    GVERBOSE_("\"%s\" %u", gbinder_remote_request_interface(req), code);
+    /* The handler is invoked on the looper thread */
+    g_assert(g_thread_self() != test->main_thread);
+    g_assert(!flags);
+    g_assert(!g_strcmp0(gbinder_remote_request_interface(req), "test"));
+    g_assert(!g_strcmp0(gbinder_remote_request_read_string8(req), "message"));
+    g_assert(code == 1);
+    test_quit_later(test->loop);
+
+    *status = GBINDER_STATUS_OK;
+    return gbinder_local_object_new_reply(obj);
+}
+
+static
+void
+test_transact_direct_run(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalObject* obj;
+    TestTransactDirect test;
+    GBinderWriter writer;
+
+    test.loop = g_main_loop_new(NULL, FALSE);
+    test.main_thread = g_thread_self();
+    obj = gbinder_local_object_new2(ipc, ifaces, test_transact_direct_proc,
+        &test, GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD);
+
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+    gbinder_writer_append_string8(&writer, "message");
+
+    test_binder_br_transaction(fd, LOOPER_THREAD, obj, 1,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
+    test_run(&test_opt, test.loop);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    GDEBUG("waiting for GBinderIpc to get destroyed");
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, test.loop);
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(req);
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, test.loop);
+
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_main_loop_unref(test.loop);
+}
+
+static
+void
+test_transact_direct(
+    void)
+{
+    test_run_in_context(&test_opt, test_transact_direct_run);
+}
+
+/*==========================================================================*
+ * spawn_looper
+ *==========================================================================*/
+
+typedef struct test_spawn_looper {
+    GMainLoop* loop;
+    GMutex mutex;
+    GCond cond;
+    gboolean released;
+    int fd;
+} TestSpawnLooper;
+
+static
+GBinderLocalReply*
+test_spawn_looper_proc(
+    GBinderLocalObject* obj,
+    GBinderRemoteRequest* req,
+    guint code,
+    guint flags,
+    int* status,
+    void* user_data)
+{
+    TestSpawnLooper* test = user_data;
+
+    GVERBOSE_("%u", code);
+    g_mutex_lock(&test->mutex);
+    if (code == 1) {
+        /* Second transaction can only be handled by the spawned looper */
+        while (!test->released) {
+            g_cond_wait(&test->cond, &test->mutex);
+        }
+        test_quit_later(test->loop);
+    } else if (code == 2) {
+        test->released = TRUE;
+        g_cond_broadcast(&test->cond);
+    } else {
+        /* Raising the limit starts the deferred looper */
+        g_assert_cmpuint(code, == ,3);
+        g_assert(gbinder_ipc_set_max_threads(obj->ipc, 1));
+    }
+    g_mutex_unlock(&test->mutex);
+
+    test_binder_br_transaction_complete(test->fd, THIS_THREAD); /* For reply */
+    *status = GBINDER_STATUS_OK;
+    return gbinder_local_object_new_reply(obj);
+}
+
+static
+void
+test_spawn_looper_run_with_limit(
+    int max_threads)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderLocalObject* obj;
+    TestSpawnLooper test;
+    GBinderWriter writer;
+
+    memset(&test, 0, sizeof(test));
+    g_mutex_init(&test.mutex);
+    g_cond_init(&test.cond);
+    test.loop = g_main_loop_new(NULL, FALSE);
+    test.fd = gbinder_driver_fd(ipc->driver);
+    obj = gbinder_local_object_new2(ipc, ifaces, test_spawn_looper_proc,
+        &test, GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD);
+    g_assert(gbinder_ipc_set_max_threads(ipc, max_threads));
+
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+
+    test_binder_br_spawn_looper(test.fd, LOOPER_THREAD);
+    if (!max_threads) {
+        /* BR_SPAWN_LOOPER gets declined and remains pending */
+        test_binder_br_transaction(test.fd, LOOPER_THREAD, obj, 3,
+            gbinder_local_request_data(req)->bytes);
+    }
+    test_binder_br_transaction(test.fd, LOOPER_THREAD, obj, 1,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_transaction(test.fd, LOOPER_THREAD, obj, 2,
+        gbinder_local_request_data(req)->bytes);
+    test_run(&test_opt, test.loop);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    GDEBUG("waiting for GBinderIpc to get destroyed");
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, test.loop);
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(req);
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, test.loop);
+
+    test_binder_exit_wait(&test_opt, test.loop);
+    g_main_loop_unref(test.loop);
+    g_mutex_clear(&test.mutex);
+    g_cond_clear(&test.cond);
+}
+
+static
+void
+test_spawn_looper_run(
+    void)
+{
+    test_spawn_looper_run_with_limit(1);
+}
+
+static
+void
+test_spawn_looper(
+    void)
+{
+    test_run_in_context(&test_opt, test_spawn_looper_run);
+}
+
+/*==========================================================================*
+ * spawn_looper_deferred
+ *==========================================================================*/
+
+static
+void
+test_spawn_looper_deferred_run(
+    void)
+{
+    test_spawn_looper_run_with_limit(0);
+}
+
+static
+void
+test_spawn_looper_deferred(
+    void)
+{
+    test_run_in_context(&test_opt, test_spawn_looper_deferred_run);
 }
 
 /*==========================================================================*
@@ -1171,6 +2195,57 @@ test_transact_async(
     test_run_in_context(&test_opt, test_transact_async_run);
 }
 
+/*==========================================================================*
+ * transact_direct_async
+ *==========================================================================*/
+
+static
+void
+test_transact_direct_async_run(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    const int fd = gbinder_driver_fd(ipc->driver);
+    const char* dev = gbinder_driver_dev(ipc->driver);
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    const char* const ifaces[] = { "test", NULL };
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GBinderLocalObject* obj = gbinder_local_object_new2
+        (ipc, ifaces, test_transact_async_proc, loop,
+            GBINDER_LOCAL_OBJECT_FLAG_LOOPER_THREAD);
+    GBinderLocalRequest* req = test_local_request_new(ipc);
+    GBinderWriter writer;
+
+    /* Blocked on the looper thread, completed on the main thread */
+    gbinder_local_request_init_writer(req, &writer);
+    prot->write_rpc_header(&writer, "test");
+    gbinder_writer_append_string8(&writer, "message");
+
+    test_binder_br_transaction(fd, LOOPER_THREAD, obj, 1,
+        gbinder_local_request_data(req)->bytes);
+    test_binder_br_transaction_complete(fd, LOOPER_THREAD); /* For reply */
+    test_run(&test_opt, loop);
+
+    /* Now we need to wait until GBinderIpc is destroyed */
+    GDEBUG("waiting for GBinderIpc to get destroyed");
+    g_object_weak_ref(G_OBJECT(ipc), test_quit_when_destroyed, loop);
+    gbinder_local_object_unref(obj);
+    gbinder_local_request_unref(req);
+    g_idle_add(test_unref_ipc, ipc);
+    test_run(&test_opt, loop);
+
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_transact_direct_async(
+    void)
+{
+    test_run_in_context(&test_opt, test_transact_direct_async_run);
+}
+
 /*==========================================================================*
  * transact_async_sync
  *==========================================================================*/
@@ -1356,8 +2431,10 @@ int main(int argc, char* argv[])
     g_test_init(&argc, &argv, NULL);
     g_test_add_func(TEST_("null"), test_null);
     g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("remote_registry"), test_remote_registry);
     g_test_add_func(TEST_("protocol"), test_protocol);
     g_test_add_func(TEST_("async_oneway"), test_async_oneway);
+    g_test_add_func(TEST_("async_oneway_batch"), test_async_oneway_batch);
     g_test_add_func(TEST_("sync_oneway"), test_sync_oneway);
     g_test_add_func(TEST_("sync_reply_ok"), test_sync_reply_ok);
     g_test_add_func(TEST_("sync_reply_error"), test_sync_reply_error);
@@ -1368,6 +2445,13 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("transact_custom"), test_transact_custom);
     g_test_add_func(TEST_("transact_custom2"), test_transact_custom2);
     g_test_add_func(TEST_("transact_custom3"), test_transact_custom3);
+    g_test_add_func(TEST_("transact_custom_batch"),
+        test_transact_custom_batch);
+    g_test_add_func(TEST_("transact_urgent"), test_transact_urgent);
+    g_test_add_func(TEST_("transact_deadline"), test_transact_deadline);
+    g_test_add_func(TEST_("transact_deadline_abandon"),
+        test_transact_deadline_abandon);
+    g_test_add_func(TEST_("sync_reply_deadline"), test_sync_reply_deadline);
     g_test_add_func(TEST_("transact_cancel"), test_transact_cancel);
     g_test_add_func(TEST_("transact_cancel2"), test_transact_cancel2);
     g_test_add_func(TEST_("transact_2way"), test_transact_2way);
@@ -1376,6 +2460,14 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("transact_status_reply"), test_transact_status_reply);
     g_test_add_func(TEST_("transact_async"), test_transact_async);
     g_test_add_func(TEST_("transact_async_sync"), test_transact_async_sync);
+    g_test_add_func(TEST_("blocking_loopers"), test_blocking_loopers);
+    g_test_add_func(TEST_("main_loop_polling"), test_main_loop_polling);
+    g_test_add_func(TEST_("transact_direct"), test_transact_direct);
+    g_test_add_func(TEST_("transact_direct_async"),
+        test_transact_direct_async);
+    g_test_add_func(TEST_("spawn_looper"), test_spawn_looper);
+    g_test_add_func(TEST_("spawn_looper_deferred"),
+        test_spawn_looper_deferred);
     g_test_add_func(TEST_("drop_remote_refs"), test_drop_remote_refs);
     g_test_add_func(TEST_("cancel_on_exit"), test_cancel_on_exit);
     test_init(&test_opt, argc, argv);
@@ -47,11 +47,16 @@
 #include <gutil_strv.h>
 #include <gutil_log.h>
 
+#include <sched.h>
 #include <errno.h>
 
 static TestOpt test_opt;
 static const char TMP_DIR_TEMPLATE[] = "gbinder-test-local-object-XXXXXX";
 
+#define BINDER_FLAG_ACCEPTS_FDS 0x100
+#define BINDER_FLAG_INHERIT_RT 0x800
+#define BINDER_FLAG_SCHED_POLICY_SHIFT 9
+
 /* android.hidl.base@1.0::IBase */
 #define TEST_BASE_INTERFACE_BYTES \
     'a', 'n', 'd', 'r', 'o', 'i', 'd', '.', \
@@ -814,6 +819,193 @@ test_release(
     test_run_in_context(&test_opt, test_release_run);
 }
 
+/*==========================================================================*
+ * sched_policy
+ *==========================================================================*/
+
+static
+guint32
+test_sched_policy_flags(
+    GBinderLocalObject* obj)
+{
+    GBinderLocalReply* reply = gbinder_local_object_new_reply(obj);
+    GBinderOutputData* data;
+    guint32 flags;
+
+    gbinder_local_reply_append_local_object(reply, obj);
+    data = gbinder_local_reply_data(reply);
+    g_assert_cmpuint(data->bytes->len, >= ,8);
+    memcpy(&flags, data->bytes->data + 4, sizeof(flags));
+    gbinder_local_reply_unref(reply);
+    return flags;
+}
+
+static
+void
+test_sched_policy(
+    void)
+{
+    static const char* const ifaces[] = { "foo", NULL };
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderLocalObject* obj = gbinder_local_object_new(ipc, ifaces,
+        NULL, NULL);
+
+    g_assert(!gbinder_local_object_set_min_sched_policy(NULL, SCHED_FIFO, 1));
+    gbinder_local_object_set_inherit_rt(NULL, TRUE);
+
+    /* No minimum by default */
+    g_assert_cmphex(test_sched_policy_flags(obj), == ,
+        0x7f | BINDER_FLAG_ACCEPTS_FDS);
+
+    /* Invalid parameters */
+    g_assert(!gbinder_local_object_set_min_sched_policy(obj, -1, 0));
+    g_assert(!gbinder_local_object_set_min_sched_policy(obj, SCHED_OTHER, 20));
+    g_assert(!gbinder_local_object_set_min_sched_policy(obj, SCHED_FIFO, 0));
+    g_assert(!gbinder_local_object_set_min_sched_policy(obj, SCHED_RR, 100));
+    g_assert_cmphex(test_sched_policy_flags(obj), == ,
+        0x7f | BINDER_FLAG_ACCEPTS_FDS);
+
+    /* Policy goes to bits 9-10, priority to the low byte */
+    g_assert(gbinder_local_object_set_min_sched_policy(obj, SCHED_FIFO, 10));
+    g_assert_cmphex(test_sched_policy_flags(obj), == ,
+        BINDER_FLAG_ACCEPTS_FDS |
+        (SCHED_FIFO << BINDER_FLAG_SCHED_POLICY_SHIFT) | 10);
+    gbinder_local_object_set_inherit_rt(obj, TRUE);
+    g_assert_cmphex(test_sched_policy_flags(obj), == ,
+        BINDER_FLAG_ACCEPTS_FDS | BINDER_FLAG_INHERIT_RT |
+        (SCHED_FIFO << BINDER_FLAG_SCHED_POLICY_SHIFT) | 10);
+
+    /* Negative nice value is stored as a signed byte */
+    g_assert(gbinder_local_object_set_min_sched_policy(obj, SCHED_OTHER, -5));
+    gbinder_local_object_set_inherit_rt(obj, FALSE);
+    g_assert_cmphex(test_sched_policy_flags(obj), == ,
+        BINDER_FLAG_ACCEPTS_FDS | 0xfb);
+
+    gbinder_local_object_unref(obj);
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
+/*==========================================================================*
+ * stats
+ *==========================================================================*/
+
+static
+void
+test_stats(
+    void)
+{
+    int status = INT_MAX;
+    const char* dev = GBINDER_DEFAULT_BINDER;
+    const GBinderRpcProtocol* prot = gbinder_rpc_protocol_for_device(dev);
+    GBinderIpc* ipc = gbinder_ipc_new(dev, NULL);
+    GBinderObjectRegistry* reg = gbinder_ipc_object_registry(ipc);
+    GBinderRemoteRequest* req = gbinder_remote_request_new(reg, prot, 0, 0);
+    GBinderLocalObject* obj = gbinder_local_object_new(ipc, NULL, NULL, NULL);
+    GBinderLocalReply* reply;
+    GBinderReaderData reader_data;
+    GBinderReader reader;
+    GBinderStatsLatency latency;
+    GBinderStats stats;
+    guint32* codes;
+    guint n = INT_MAX;
+    char* str;
+
+    /* NULL tolerance */
+    gbinder_local_object_get_stats(NULL, NULL);
+    gbinder_local_object_get_stats(NULL, &latency);
+    g_assert_cmpuint(latency.count, == ,0);
+    g_assert(!gbinder_local_object_get_code_stats(NULL, 1, NULL));
+    g_assert(!gbinder_local_object_get_code_stats(NULL, 1, &latency));
+    g_assert(!gbinder_local_object_get_stats_codes(NULL, NULL));
+    g_assert(!gbinder_local_object_get_stats_codes(NULL, &n));
+    g_assert_cmpuint(n, == ,0);
+
+    /* Statistics aren't collected by default */
+    g_assert(!gbinder_ipc_stats_enabled(ipc));
+    reply = gbinder_local_object_handle_looper_transaction(obj, req,
+        GBINDER_PING_TRANSACTION, 0, &status);
+    g_assert(reply);
+    gbinder_local_reply_unref(reply);
+
+    /* Nothing has been recorded yet */
+    g_assert(!gbinder_local_object_get_stats_codes(obj, &n));
+    g_assert_cmpuint(n, == ,0);
+    g_assert(!gbinder_local_object_get_code_stats(obj, 1, &latency));
+    gbinder_local_object_get_stats(obj, &latency);
+    g_assert_cmpuint(latency.count, == ,0);
+
+    /* Stats transaction is disabled by default */
+    g_assert(gbinder_local_object_can_handle_transaction(obj, NULL,
+        GBINDER_STATS_TRANSACTION) == GBINDER_LOCAL_TRANSACTION_NOT_SUPPORTED);
+    gbinder_ipc_set_stats_transaction(ipc, TRUE);
+    g_assert(gbinder_local_object_can_handle_transaction(obj, NULL,
+        GBINDER_STATS_TRANSACTION) == GBINDER_LOCAL_TRANSACTION_LOOPER);
+
+    /* Which also enables collection */
+    g_assert(gbinder_ipc_stats_enabled(ipc));
+
+    /* Handle a few transactions */
+    reply = gbinder_local_object_handle_looper_transaction(obj, req,
+        GBINDER_PING_TRANSACTION, 0, &status);
+    g_assert(reply);
+    gbinder_local_reply_unref(reply);
+    reply = gbinder_local_object_handle_looper_transaction(obj, req,
+        GBINDER_PING_TRANSACTION, 0, &status);
+    g_assert(reply);
+    gbinder_local_reply_unref(reply);
+    g_assert(!gbinder_local_object_handle_transaction(obj, req, 1, 0,
+        &status));
+
+    gbinder_local_object_get_stats(obj, &latency);
+    g_assert_cmpuint(latency.count, == ,3);
+    g_assert(gbinder_local_object_get_code_stats(obj, 1, NULL));
+    g_assert(gbinder_local_object_get_code_stats(obj,
+        GBINDER_PING_TRANSACTION, &latency));
+    g_assert_cmpuint(latency.count, == ,2);
+    g_assert(!gbinder_local_object_get_code_stats(obj, 2, &latency));
+    g_assert_cmpuint(latency.count, == ,0);
+
+    /* Codes are sorted */
+    codes = gbinder_local_object_get_stats_codes(obj, &n);
+    g_assert(codes);
+    g_assert_cmpuint(n, == ,2);
+    g_assert_cmpuint(codes[0], == ,1);
+    g_assert_cmpuint(codes[1], == ,GBINDER_PING_TRANSACTION);
+    g_free(codes);
+
+    /* Incoming transactions are also accounted at the ipc level */
+    gbinder_ipc_get_stats(ipc, &stats);
+    g_assert_cmpuint(stats.incoming.count, == ,3);
+
+    /* Dump the stats */
+    reply = gbinder_local_object_handle_looper_transaction(obj, req,
+        GBINDER_STATS_TRANSACTION, 0, &status);
+    g_assert(reply);
+    g_assert_cmpint(status, == ,GBINDER_STATUS_OK);
+    test_reader_data_init_for_reply(&reader_data, obj, reply);
+    gbinder_reader_init(&reader, &reader_data, 0, reader_data.buffer->size);
+    str = gbinder_reader_read_string16(&reader);
+    g_assert(str);
+    GDEBUG("%s", str);
+    g_assert(strstr(str, "incoming.count: 3\n"));
+    g_assert(strstr(str, "object.count: 3\n"));
+    g_assert(strstr(str, "object.code_1.count: 1\n"));
+    g_free(str);
+    test_reader_data_cleanup(&reader_data);
+    gbinder_local_reply_unref(reply);
+
+    /* The stats transaction itself gets counted too */
+    codes = gbinder_local_object_get_stats_codes(obj, &n);
+    g_assert_cmpuint(n, == ,3);
+    g_free(codes);
+
+    gbinder_ipc_unref(ipc);
+    gbinder_local_object_unref(obj);
+    gbinder_remote_request_unref(req);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -842,6 +1034,8 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_PREFIX "decrefs", test_decrefs);
     g_test_add_func(TEST_PREFIX "acquire", test_acquire);
     g_test_add_func(TEST_PREFIX "release", test_release);
+    g_test_add_func(TEST_PREFIX "sched_policy", test_sched_policy);
+    g_test_add_func(TEST_PREFIX "stats", test_stats);
     test_init(&test_opt, argc, argv);
     test_config_init(&test_config, TMP_DIR_TEMPLATE);
     result = g_test_run();
@@ -524,6 +524,92 @@ test_remote_reply(
     gbinder_driver_unref(driver);
 }
 
+/*==========================================================================*
+ * recycle
+ *==========================================================================*/
+
+static
+void
+test_recycle(
+    void)
+{
+    GBinderLocalReply* reply = test_local_reply_new();
+    GBinderLocalReply* reply2;
+    GBinderLocalReply* many[20];
+    GBinderOutputData* data;
+    GBinderWriter writer;
+    int count = 0;
+    guint i;
+
+    gbinder_local_reply_append_hidl_string(reply, "foo");
+    gbinder_local_reply_cleanup(reply, test_int_inc, &count);
+    data = gbinder_local_reply_data(reply);
+    g_assert(gbinder_output_data_offsets(data));
+    g_assert(gbinder_output_data_buffers_size(data));
+    gbinder_local_reply_unref(reply);
+    g_assert_cmpint(count, == ,1);
+
+    /* Released object comes back empty */
+    reply2 = test_local_reply_new();
+    g_assert(reply2 == reply);
+    data = gbinder_local_reply_data(reply2);
+    g_assert(!data->bytes->len);
+    g_assert(!gbinder_output_data_offsets(data));
+    g_assert(!gbinder_output_data_buffers_size(data));
+    gbinder_local_reply_append_int32(reply2, 1);
+    g_assert_cmpuint(data->bytes->len, == ,4);
+    gbinder_local_reply_unref(reply2);
+
+    /* Overflow the pool */
+    for (i = 0; i < G_N_ELEMENTS(many); i++) {
+        many[i] = test_local_reply_new();
+        gbinder_local_reply_cleanup(many[i], test_int_inc, &count);
+    }
+    for (i = 0; i < G_N_ELEMENTS(many); i++) {
+        gbinder_local_reply_unref(many[i]);
+    }
+    g_assert_cmpint(count, == ,21);
+
+    /* Large buffers are not recycled */
+    reply = test_local_reply_new();
+    for (i = 0; i < 8192; i++) {
+        gbinder_local_reply_append_int32(reply, i);
+    }
+    gbinder_local_reply_unref(reply);
+
+    /* Neither are the ones which have reserved too much space */
+    reply = test_local_reply_new();
+    gbinder_local_reply_init_writer(reply, &writer);
+    gbinder_writer_size_hint(&writer, 32 * 1024);
+    gbinder_local_reply_unref(reply);
+}
+
+/*==========================================================================*
+ * recycle_thread
+ *==========================================================================*/
+
+static
+gpointer
+test_recycle_thread_proc(
+    gpointer reply)
+{
+    gbinder_local_reply_unref(reply);
+    return NULL;
+}
+
+static
+void
+test_recycle_thread(
+    void)
+{
+    GBinderLocalReply* reply = test_local_reply_new();
+
+    /* Released on another thread, reused on this one */
+    g_thread_join(g_thread_new("release", test_recycle_thread_proc, reply));
+    g_assert(test_local_reply_new() == reply);
+    gbinder_local_reply_unref(reply);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -554,6 +640,8 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_PREFIX "local_object", test_local_object);
     g_test_add_func(TEST_PREFIX "remote_object", test_remote_object);
     g_test_add_func(TEST_PREFIX "remote_reply", test_remote_reply);
+    g_test_add_func(TEST_PREFIX "recycle", test_recycle);
+    g_test_add_func(TEST_PREFIX "recycle_thread", test_recycle_thread);
     test_init(&test_opt, argc, argv);
     test_config_init(&test_config, TMP_DIR_TEMPLATE);
     result = g_test_run();
@@ -606,6 +606,104 @@ test_remote_request_obj(
     gbinder_driver_unref(driver);
 }
 
+/*==========================================================================*
+ * recycle
+ *==========================================================================*/
+
+static
+void
+test_recycle(
+    void)
+{
+    static const guint8 init_data[] = { 0x01, 0x02, 0x03, 0x04 };
+    GBytes* init = g_bytes_new_static(init_data, sizeof(init_data));
+    GBinderLocalRequest* req = test_local_request_new();
+    GBinderLocalRequest* req2;
+    GBinderLocalRequest* many[20];
+    GBinderOutputData* data;
+    GBinderWriter writer;
+    int count = 0;
+    guint i;
+
+    gbinder_local_request_append_hidl_string(req, "foo");
+    gbinder_local_request_cleanup(req, test_int_inc, &count);
+    data = gbinder_local_request_data(req);
+    g_assert(gbinder_output_data_offsets(data));
+    g_assert(gbinder_output_data_buffers_size(data));
+    gbinder_local_request_unref(req);
+    g_assert_cmpint(count, == ,1);
+
+    /* Released object comes back empty */
+    req2 = test_local_request_new();
+    g_assert(req2 == req);
+    data = gbinder_local_request_data(req2);
+    g_assert(!data->bytes->len);
+    g_assert(!gbinder_output_data_offsets(data));
+    g_assert(!gbinder_output_data_buffers_size(data));
+    gbinder_local_request_append_int32(req2, 1);
+    g_assert_cmpuint(data->bytes->len, == ,4);
+    gbinder_local_request_unref(req2);
+
+    /* Initial data goes into the recycled buffer */
+    req2 = gbinder_local_request_new(&gbinder_io_32,
+        gbinder_rpc_protocol_for_device(NULL), init);
+    g_assert(req2 == req);
+    data = gbinder_local_request_data(req2);
+    g_assert_cmpuint(data->bytes->len, == ,sizeof(init_data));
+    g_assert(!memcmp(data->bytes->data, init_data, sizeof(init_data)));
+    gbinder_local_request_unref(req2);
+    g_bytes_unref(init);
+
+    /* Overflow the pool */
+    for (i = 0; i < G_N_ELEMENTS(many); i++) {
+        many[i] = test_local_request_new();
+        gbinder_local_request_cleanup(many[i], test_int_inc, &count);
+    }
+    for (i = 0; i < G_N_ELEMENTS(many); i++) {
+        gbinder_local_request_unref(many[i]);
+    }
+    g_assert_cmpint(count, == ,21);
+
+    /* Large buffers are not recycled */
+    req = test_local_request_new();
+    for (i = 0; i < 8192; i++) {
+        gbinder_local_request_append_int32(req, i);
+    }
+    gbinder_local_request_unref(req);
+
+    /* Neither are the ones which have reserved too much space */
+    req = test_local_request_new();
+    gbinder_local_request_init_writer(req, &writer);
+    gbinder_writer_size_hint(&writer, 32 * 1024);
+    gbinder_local_request_unref(req);
+}
+
+/*==========================================================================*
+ * recycle_thread
+ *==========================================================================*/
+
+static
+gpointer
+test_recycle_thread_proc(
+    gpointer req)
+{
+    gbinder_local_request_unref(req);
+    return NULL;
+}
+
+static
+void
+test_recycle_thread(
+    void)
+{
+    GBinderLocalRequest* req = test_local_request_new();
+
+    /* Released on another thread, reused on this one */
+    g_thread_join(g_thread_new("release", test_recycle_thread_proc, req));
+    g_assert(test_local_request_new() == req);
+    gbinder_local_request_unref(req);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -634,6 +732,8 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_PREFIX "remote_object", test_remote_object);
     g_test_add_func(TEST_PREFIX "remote_request", test_remote_request);
     g_test_add_func(TEST_PREFIX "remote_request_obj", test_remote_request_obj);
+    g_test_add_func(TEST_PREFIX "recycle", test_recycle);
+    g_test_add_func(TEST_PREFIX "recycle_thread", test_recycle_thread);
     test_init(&test_opt, argc, argv);
     test_config_init(&test_config, TMP_DIR_TEMPLATE);
     result = g_test_run();
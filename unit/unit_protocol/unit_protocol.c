@@ -422,12 +422,58 @@ test_read_header(
         gbinder_buffer_new(driver, g_memdup(test->header, test->header_size),
         test->header_size, NULL));
     g_assert_cmpstr(gbinder_remote_request_interface(req), == ,test->iface);
+    if (test->iface) {
+        /* Interface names are interned */
+        g_assert(gbinder_remote_request_interface(req) ==
+            g_intern_string(test->iface));
+    }
     gbinder_remote_request_unref(req);
     gbinder_driver_unref(driver);
 
     test_context_cleanup(&context);
 }
 
+/*==========================================================================*
+ * intern
+ *==========================================================================*/
+
+static
+void
+test_intern(
+    void)
+{
+    const char* dev = GBINDER_DEFAULT_BINDER;
+    const GBinderRpcProtocol* prot;
+    GBinderDriver* driver;
+    GBinderRemoteRequest* req;
+    TestContext context;
+    guint i;
+
+    test_context_init2(&context, dev, "aidl2");
+    prot = gbinder_rpc_protocol_for_device(dev);
+    driver = gbinder_driver_new(dev, NULL);
+    req = gbinder_remote_request_new(NULL, prot, 0, 0);
+
+    /* More names than the cache can hold */
+    for (i = 0; i < 1000; i++) {
+        char* iface = g_strdup_printf("test.intern.%u", i % 500);
+        GBinderLocalRequest* local = gbinder_local_request_new_iface
+            (gbinder_driver_io(driver), prot, iface);
+        GBinderOutputData* data = gbinder_local_request_data(local);
+
+        gbinder_remote_request_set_data(req, GBINDER_FIRST_CALL_TRANSACTION,
+            gbinder_buffer_new(driver, g_memdup(data->bytes->data,
+            data->bytes->len), data->bytes->len, NULL));
+        g_assert_cmpstr(gbinder_remote_request_interface(req), == ,iface);
+        gbinder_local_request_unref(local);
+        g_free(iface);
+    }
+
+    gbinder_remote_request_unref(req);
+    gbinder_driver_unref(driver);
+    test_context_cleanup(&context);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -444,6 +490,7 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("config1"), test_config1);
     g_test_add_func(TEST_("config2"), test_config2);
     g_test_add_func(TEST_("config3"), test_config3);
+    g_test_add_func(TEST_("intern"), test_intern);
 
     for (i = 0; i < G_N_ELEMENTS(test_no_header_data); i++) {
         const TestData* test = test_no_header_data + i;
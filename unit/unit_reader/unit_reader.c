@@ -149,6 +149,8 @@ test_empty(
     g_assert(!gbinder_reader_skip_hidl_string(&reader));
     g_assert(!gbinder_reader_read_hidl_string(&reader));
     g_assert(!gbinder_reader_read_hidl_string_vec(&reader));
+    g_assert(!gbinder_reader_read_hidl_string_view(&reader, NULL));
+    g_assert(!gbinder_reader_read_hidl_string_vec_view(&reader, NULL));
     g_assert(!gbinder_reader_skip_buffer(&reader));
     g_assert(!gbinder_reader_read_string8(&reader));
     g_assert(!gbinder_reader_read_string16(&reader));
@@ -1579,6 +1581,7 @@ test_hidl_string(
     GBinderRemoteObject* obj = NULL;
     GBinderReaderData data;
     GBinderReader reader;
+    gsize len;
     guint i;
 
     g_assert(ipc);
@@ -1594,6 +1597,14 @@ test_hidl_string(
 
     g_assert(gbinder_reader_read_hidl_string_c(&reader) == result);
 
+    /* Same thing with the length */
+    gbinder_reader_init(&reader, &data, 0, buf->size);
+    len = 1;
+    g_assert(gbinder_reader_read_hidl_string_view(&reader, &len) == result);
+    g_assert_cmpuint(len, == ,result ? strlen(result) : 0);
+    gbinder_reader_init(&reader, &data, 0, buf->size);
+    g_assert(gbinder_reader_read_hidl_string_view(&reader, NULL) == result);
+
     g_free(data.objects);
     gbinder_remote_object_unref(obj);
     gbinder_buffer_free(buf);
@@ -2414,6 +2425,7 @@ test_vec(
     GBinderReader reader;
     BinderObject64 obj;
     GBinderHidlVec vec;
+    gsize count;
     char** out;
 
     g_assert(ipc);
@@ -2445,6 +2457,10 @@ test_vec(
     g_assert(out);
     g_assert(!out[0]);
     g_strfreev(out);
+    gbinder_reader_init(&reader, &data, 0, data.buffer->size);
+    count = 1;
+    g_assert(gbinder_reader_read_hidl_string_vec_view(&reader, &count));
+    g_assert_cmpuint(count, == ,0);
 
     g_free(data.objects);
     gbinder_buffer_free(data.buffer);
@@ -2469,6 +2485,8 @@ test_hidl_string_vec(
     GBinderRemoteObject* obj = NULL;
     GBinderReaderData data;
     GBinderReader reader;
+    const GBinderHidlString* view;
+    gsize count;
     char** out;
     guint i;
 
@@ -2499,6 +2517,24 @@ test_hidl_string_vec(
         g_assert(!result);
     }
 
+    /* The view points to the buffer */
+    gbinder_reader_init(&reader, &data, 0, buf->size);
+    count = 1;
+    view = gbinder_reader_read_hidl_string_vec_view(&reader, &count);
+    if (view) {
+        g_assert(result);
+        g_assert_cmpuint(count, == ,g_strv_length((char**)result));
+        for (i = 0; i < count; i++) {
+            g_assert_cmpstr(view[i].data.str, == ,result[i]);
+            g_assert_cmpuint(view[i].len, == ,strlen(result[i]));
+            g_assert(view[i].data.str >= (char*)buf->data);
+            g_assert(view[i].data.str < (char*)buf->data + buf->size);
+        }
+    } else {
+        g_assert(!result);
+        g_assert(!count);
+    }
+
     g_strfreev(out);
     g_free(data.objects);
     gbinder_remote_object_unref(obj);
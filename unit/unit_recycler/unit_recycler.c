@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "test_common.h"
+
+#include "gbinder_recycler.h"
+
+#include <gutil_log.h>
+
+static TestOpt test_opt;
+
+#define TEST_MAX (2)
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    GBinderRecycler recycler = GBINDER_RECYCLER_INIT(TEST_MAX);
+    GBinderRecyclerLink link[TEST_MAX + 1];
+
+    memset(link, 0, sizeof(link));
+    g_assert(!gbinder_recycler_take(&recycler));
+
+    /* Last in, first out */
+    g_assert(gbinder_recycler_put(&recycler, link));
+    g_assert(gbinder_recycler_put(&recycler, link + 1));
+    g_assert(!gbinder_recycler_put(&recycler, link + 2)); /* Full */
+    g_assert(gbinder_recycler_take(&recycler) == link + 1);
+    g_assert(!link[1].next);
+
+    /* There's room again */
+    g_assert(gbinder_recycler_put(&recycler, link + 2));
+    g_assert(gbinder_recycler_take(&recycler) == link + 2);
+    g_assert(gbinder_recycler_take(&recycler) == link);
+    g_assert(!gbinder_recycler_take(&recycler));
+}
+
+/*==========================================================================*
+ * drain
+ *==========================================================================*/
+
+static
+void
+test_drain(
+    void)
+{
+    GBinderRecycler empty = GBINDER_RECYCLER_INIT(TEST_MAX);
+    GBinderRecycler recycler = GBINDER_RECYCLER_INIT(TEST_MAX);
+    GBinderRecyclerLink link[TEST_MAX];
+
+    memset(link, 0, sizeof(link));
+    g_assert(!gbinder_recycler_drain(&empty));
+    g_assert(!gbinder_recycler_put(&empty, link)); /* Drained for good */
+
+    g_assert(gbinder_recycler_put(&recycler, link));
+    g_assert(gbinder_recycler_put(&recycler, link + 1));
+    g_assert(gbinder_recycler_drain(&recycler) == link + 1);
+    g_assert(link[1].next == link);
+    g_assert(!link[0].next);
+    g_assert(!gbinder_recycler_take(&recycler));
+    g_assert(!gbinder_recycler_put(&recycler, link));
+}
+
+/*==========================================================================*
+ * threads
+ *==========================================================================*/
+
+#define TEST_THREADS (4)
+#define TEST_ITERATIONS (10000)
+
+typedef struct test_threads_data {
+    GBinderRecycler recycler;
+    gint added;
+} TestThreadsData;
+
+static
+gpointer
+test_threads_proc(
+    gpointer user_data)
+{
+    TestThreadsData* test = user_data;
+    GBinderRecyclerLink* own = g_new0(GBinderRecyclerLink, 1);
+    int i;
+
+    for (i = 0; i < TEST_ITERATIONS; i++) {
+        GBinderRecyclerLink* link = gbinder_recycler_take(&test->recycler);
+
+        if (link) {
+            g_assert(!link->next);
+        } else if (own) {
+            /* The others have taken everything, add one more */
+            g_atomic_int_inc(&test->added);
+            link = own;
+            own = NULL;
+        } else {
+            continue;
+        }
+        g_assert(gbinder_recycler_put(&test->recycler, link));
+    }
+    g_free(own);
+    return NULL;
+}
+
+static
+void
+test_threads(
+    void)
+{
+    TestThreadsData test;
+    GThread* thread[TEST_THREADS];
+    GBinderRecyclerLink* link;
+    int i, n = 0;
+
+    memset(&test, 0, sizeof(test));
+    test.recycler.max = TEST_THREADS;
+    for (i = 0; i < TEST_THREADS; i++) {
+        thread[i] = g_thread_new("test", test_threads_proc, &test);
+    }
+    for (i = 0; i < TEST_THREADS; i++) {
+        g_thread_join(thread[i]);
+    }
+
+    /* Nothing is lost or duplicated */
+    link = gbinder_recycler_drain(&test.recycler);
+    while (link) {
+        GBinderRecyclerLink* next = link->next;
+
+        g_free(link);
+        link = next;
+        n++;
+    }
+    GDEBUG("%d object(s)", n);
+    g_assert_cmpint(n, == ,test.added);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/recycler/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("drain"), test_drain);
+    g_test_add_func(TEST_("threads"), test_threads);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
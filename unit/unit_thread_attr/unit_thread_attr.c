@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE /* sched_getaffinity */
+
+#include "test_binder.h"
+
+#include "gbinder_config.h"
+#include "gbinder_ipc.h"
+#include "gbinder_thread_attr.h"
+
+#include <gutil_log.h>
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+static TestOpt test_opt;
+static const char TMP_DIR_TEMPLATE[] = "gbinder-test-thread-attr-XXXXXX";
+
+typedef struct test_thread_info {
+    int policy;
+    int nice;
+    gboolean pinned_to_0;
+    gsize stack_size;
+} TestThreadInfo;
+
+static
+void
+test_thread_info_get(
+    TestThreadInfo* info)
+{
+    pthread_attr_t attr;
+    cpu_set_t cpus;
+
+    info->policy = sched_getscheduler(0);
+    info->nice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+    g_assert(!sched_getaffinity(0, sizeof(cpus), &cpus));
+    info->pinned_to_0 = CPU_COUNT(&cpus) == 1 && CPU_ISSET(0, &cpus);
+    g_assert(!pthread_getattr_np(pthread_self(), &attr));
+    g_assert(!pthread_attr_getstacksize(&attr, &info->stack_size));
+    pthread_attr_destroy(&attr);
+}
+
+typedef struct test_thread_data {
+    GBinderThreadAttrPriv* attr;
+    TestThreadInfo info;
+} TestThreadData;
+
+static
+void*
+test_thread_proc(
+    void* user_data)
+{
+    TestThreadData* data = user_data;
+
+    gbinder_thread_attr_apply(data->attr);
+    gbinder_thread_attr_apply(data->attr); /* Does nothing */
+    test_thread_info_get(&data->info);
+    return NULL;
+}
+
+/* Applies the attributes to a new thread and fetches the result */
+static
+void
+test_thread_run(
+    GBinderThreadAttrPriv* attr,
+    TestThreadInfo* info)
+{
+    TestThreadData data;
+    pthread_attr_t pthread_attr;
+    const gboolean have_attr = gbinder_thread_attr_init_pthread(attr,
+        &pthread_attr);
+    pthread_t thread;
+
+    memset(&data, 0, sizeof(data));
+    data.attr = attr;
+    g_assert(!pthread_create(&thread, have_attr ? &pthread_attr : NULL,
+        test_thread_proc, &data));
+    g_assert(!pthread_join(thread, NULL));
+    if (have_attr) {
+        pthread_attr_destroy(&pthread_attr);
+    }
+    *info = data.info;
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    g_assert(!gbinder_thread_attr_new(NULL));
+    g_assert(!gbinder_thread_attr_ref(NULL));
+    g_assert(!gbinder_thread_attr_init_pthread(NULL, NULL));
+    g_assert(!gbinder_ipc_set_thread_attr(NULL, NULL));
+    gbinder_thread_attr_unref(NULL);
+    gbinder_thread_attr_apply(NULL);
+    gbinder_thread_attr_pop(NULL);
+    g_assert(!gbinder_thread_attr_push(NULL));
+}
+
+/*==========================================================================*
+ * invalid
+ *==========================================================================*/
+
+static
+void
+test_invalid(
+    void)
+{
+    static const char* bad_cpus[] = {
+        "", ",", "x", "1,", "3-1", "1-2-3", "-1", "1-", "100000"
+    };
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GBinderThreadAttr attr;
+    guint i;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.policy = 12345;
+    g_assert(!gbinder_thread_attr_new(&attr));
+    g_assert(!gbinder_ipc_set_thread_attr(ipc, &attr));
+
+    attr.policy = SCHED_FIFO;
+    attr.priority = sched_get_priority_max(SCHED_FIFO) + 1;
+    g_assert(!gbinder_thread_attr_new(&attr));
+
+    attr.policy = SCHED_OTHER;
+    attr.nice = 20;
+    g_assert(!gbinder_thread_attr_new(&attr));
+    attr.nice = -21;
+    g_assert(!gbinder_thread_attr_new(&attr));
+
+    attr.policy = -1;
+    attr.stack_size = 1;
+    g_assert(!gbinder_thread_attr_new(&attr));
+    attr.stack_size = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(bad_cpus); i++) {
+        attr.cpus = bad_cpus[i];
+        GDEBUG("\"%s\"", attr.cpus);
+        g_assert(!gbinder_thread_attr_new(&attr));
+    }
+
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, NULL);
+}
+
+/*==========================================================================*
+ * apply
+ *==========================================================================*/
+
+static
+void
+test_apply(
+    void)
+{
+    GBinderThreadAttr attr;
+    GBinderThreadAttrPriv* priv;
+    TestThreadInfo info;
+
+    /* Nothing to apply */
+    memset(&attr, 0, sizeof(attr));
+    attr.policy = -1;
+    priv = gbinder_thread_attr_new(&attr);
+    g_assert(priv);
+    g_assert(gbinder_thread_attr_ref(priv) == priv);
+    gbinder_thread_attr_unref(priv);
+    test_thread_run(priv, &info);
+    g_assert_cmpint(info.policy, == ,SCHED_OTHER);
+    gbinder_thread_attr_unref(priv);
+
+    /* These don't require any privileges */
+    attr.policy = SCHED_BATCH;
+    attr.nice = 3;
+    attr.cpus = "0";
+    attr.stack_size = 1024 * 1024;
+    priv = gbinder_thread_attr_new(&attr);
+    g_assert(priv);
+    test_thread_run(priv, &info);
+    g_assert_cmpint(info.policy, == ,SCHED_BATCH);
+    g_assert_cmpint(info.nice, == ,3);
+    g_assert(info.pinned_to_0);
+    g_assert_cmpuint(info.stack_size, == ,attr.stack_size);
+    gbinder_thread_attr_unref(priv);
+}
+
+/*==========================================================================*
+ * push
+ *==========================================================================*/
+
+typedef struct test_push_data {
+    GBinderThreadAttrPriv* attr;
+    TestThreadInfo before;
+    TestThreadInfo pushed;
+    TestThreadInfo popped;
+} TestPushData;
+
+static
+void*
+test_push_proc(
+    void* user_data)
+{
+    TestPushData* data = user_data;
+    GBinderThreadAttrSaved* saved;
+
+    test_thread_info_get(&data->before);
+    saved = gbinder_thread_attr_push(data->attr);
+    g_assert(saved);
+    test_thread_info_get(&data->pushed);
+    gbinder_thread_attr_pop(saved);
+    test_thread_info_get(&data->popped);
+    return NULL;
+}
+
+static
+void
+test_push(
+    void)
+{
+    GBinderThreadAttr attr;
+    TestPushData data;
+    pthread_t thread;
+
+    /* Going back from SCHED_BATCH doesn't require any privileges */
+    memset(&attr, 0, sizeof(attr));
+    memset(&data, 0, sizeof(data));
+    attr.policy = SCHED_BATCH;
+    attr.cpus = "0";
+    data.attr = gbinder_thread_attr_new(&attr);
+    g_assert(data.attr);
+    g_assert(!pthread_create(&thread, NULL, test_push_proc, &data));
+    g_assert(!pthread_join(thread, NULL));
+    gbinder_thread_attr_unref(data.attr);
+
+    g_assert_cmpint(data.pushed.policy, == ,SCHED_BATCH);
+    g_assert(data.pushed.pinned_to_0);
+    g_assert_cmpint(data.popped.policy, == ,data.before.policy);
+    g_assert_cmpint(data.popped.nice, == ,data.before.nice);
+    g_assert(data.popped.pinned_to_0 == data.before.pinned_to_0);
+}
+
+/*==========================================================================*
+ * tx
+ *==========================================================================*/
+
+static
+void
+test_tx_exec(
+    const GBinderIpcTx* tx)
+{
+    test_thread_info_get((TestThreadInfo*)tx->user_data);
+}
+
+static
+void
+test_tx_done(
+    const GBinderIpcTx* tx)
+{
+    TestThreadInfo* info = tx->user_data;
+
+    g_assert_cmpint(info->policy, == ,SCHED_IDLE);
+    g_assert(info->pinned_to_0);
+}
+
+static
+void
+test_tx_destroy(
+    void* user_data)
+{
+    test_quit_later((GMainLoop*)user_data);
+}
+
+static
+void
+test_tx(
+    void)
+{
+    GBinderIpc* ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    GBinderThreadAttr attr;
+    TestThreadInfo info;
+
+    memset(&attr, 0, sizeof(attr));
+    memset(&info, 0, sizeof(info));
+    attr.policy = SCHED_IDLE;
+    attr.cpus = "0";
+    g_assert(gbinder_ipc_set_thread_attr(ipc, &attr));
+
+    /* The worker gets configured before executing the transaction */
+    g_assert(gbinder_ipc_transact_custom(ipc, test_tx_exec, test_tx_done,
+        NULL, &info));
+    g_assert(gbinder_ipc_transact_custom(ipc, NULL, NULL,
+        test_tx_destroy, loop));
+    test_run(&test_opt, loop);
+    g_assert_cmpint(info.policy, == ,SCHED_IDLE);
+
+    /* Stop configuring the threads */
+    g_assert(gbinder_ipc_set_thread_attr(ipc, NULL));
+
+    gbinder_ipc_unref(ipc);
+    test_binder_exit_wait(&test_opt, loop);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * config
+ *==========================================================================*/
+
+static
+void
+test_config_file_run(
+    const char* config,
+    const TestThreadInfo* expect)
+{
+    TestConfig test;
+    GBinderThreadAttrPriv* priv;
+    char* file;
+
+    test_config_init(&test, TMP_DIR_TEMPLATE);
+    file = g_build_filename(test.config_dir, "test.conf", NULL);
+    g_assert(g_file_set_contents(file, config, -1, NULL));
+    GDEBUG("Config file %s", file);
+    gbinder_config_file = file;
+
+    priv = gbinder_thread_attr_config();
+    if (expect) {
+        TestThreadInfo info;
+
+        g_assert(priv);
+        test_thread_run(priv, &info);
+        g_assert_cmpint(info.policy, == ,expect->policy);
+        g_assert_cmpint(info.nice, == ,expect->nice);
+        g_assert(info.pinned_to_0 == expect->pinned_to_0);
+        if (expect->stack_size) {
+            g_assert_cmpuint(info.stack_size, == ,expect->stack_size);
+        }
+        gbinder_thread_attr_unref(priv);
+    } else {
+        g_assert(!priv);
+    }
+
+    remove(file);
+    g_free(file);
+    test_config_cleanup(&test);
+}
+
+static
+void
+test_config_file(
+    void)
+{
+    TestThreadInfo info;
+
+    /* Nothing is configured */
+    test_config_file_run("[General]\n", NULL);
+
+    /* Invalid CPU list */
+    test_config_file_run("[General]\nThreadAffinity = foo\n", NULL);
+
+    /* Nice value implies SCHED_OTHER */
+    memset(&info, 0, sizeof(info));
+    info.policy = SCHED_OTHER;
+    info.nice = 2;
+    test_config_file_run("[General]\nThreadNice = 2\n", &info);
+
+    /* Invalid policy is ignored */
+    info.nice = 0;
+    info.pinned_to_0 = TRUE;
+    test_config_file_run("[General]\n"
+        "ThreadPolicy = foo\n"
+        "ThreadAffinity = 0\n", &info);
+
+    memset(&info, 0, sizeof(info));
+    info.policy = SCHED_BATCH;
+    info.nice = 4;
+    info.pinned_to_0 = TRUE;
+    info.stack_size = 512 * 1024;
+    test_config_file_run("[General]\n"
+        "ThreadPolicy = Batch\n"
+        "ThreadNice = 4\n"
+        "ThreadAffinity = 0-0\n"
+        "ThreadStackSize = 524288\n", &info);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(t) "/thread_attr/" t
+
+int main(int argc, char* argv[])
+{
+    TestConfig test_config;
+    int result;
+
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+    g_type_init();
+    G_GNUC_END_IGNORE_DEPRECATIONS;
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("invalid"), test_invalid);
+    g_test_add_func(TEST_("apply"), test_apply);
+    g_test_add_func(TEST_("push"), test_push);
+    g_test_add_func(TEST_("tx"), test_tx);
+    g_test_add_func(TEST_("config_file"), test_config_file);
+    test_init(&test_opt, argc, argv);
+    test_config_init(&test_config, TMP_DIR_TEMPLATE);
+    result = g_test_run();
+    test_config_cleanup(&test_config);
+    return result;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test_binder.h"
+
+#include "gbinder_config.h"
+#include "gbinder_ipc.h"
+#include "gbinder_trace_p.h"
+
+#include <gutil_log.h>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static TestOpt test_opt;
+static const char TMP_DIR_TEMPLATE[] = "gbinder-test-trace-XXXXXX";
+
+static
+GBinderTraceRecord*
+test_dump(
+    guint* count)
+{
+    char* path = NULL;
+    const int fd = g_file_open_tmp("gbinder-trace-XXXXXX", &path, NULL);
+    GBinderTraceRecord* records = NULL;
+    GBinderTraceHeader header;
+    gchar* data = NULL;
+    gsize size = 0;
+
+    g_assert_cmpint(fd, >= ,0);
+    g_assert(gbinder_trace_dump(fd));
+    close(fd);
+    g_assert(g_file_get_contents(path, &data, &size, NULL));
+    remove(path);
+    g_free(path);
+
+    g_assert_cmpuint(size, >= ,sizeof(header));
+    memcpy(&header, data, sizeof(header));
+    g_assert_cmpuint(header.magic, == ,GBINDER_TRACE_MAGIC);
+    g_assert_cmpuint(header.version, == ,GBINDER_TRACE_VERSION);
+    g_assert_cmpuint(header.record_size, == ,sizeof(GBinderTraceRecord));
+    g_assert_cmpuint(size, == ,sizeof(header) +
+        header.count * header.record_size);
+    if (header.count) {
+        records = g_memdup(data + sizeof(header), size - sizeof(header));
+    }
+    g_free(data);
+    *count = header.count;
+    return records;
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    g_assert(!gbinder_trace_dump(-1));
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    const guint32 tid = (guint32)syscall(SYS_gettid);
+    GBinderTraceRecord* rec;
+    guint i, n;
+
+    /* Rounded up to 4, only 3 most recent records make it to the dump */
+    gbinder_trace_start(3);
+    g_assert_cmpuint(gbinder_trace_size, == ,4);
+    for (i = 0; i < 6; i++) {
+        GBINDER_TRACE(GBINDER_TRACE_TX_QUEUED, i, i + 1, i + 2);
+    }
+
+    rec = test_dump(&n);
+    g_assert_cmpuint(n, == ,3);
+    for (i = 0; i < n; i++) {
+        g_assert_cmpuint(rec[i].tid, == ,tid);
+        g_assert_cmpuint(rec[i].event, == ,GBINDER_TRACE_TX_QUEUED);
+        g_assert_cmpuint(rec[i].arg1, == ,i + 3);
+        g_assert_cmpuint(rec[i].arg2, == ,i + 4);
+        g_assert_cmpuint(rec[i].arg3, == ,i + 5);
+        if (i > 0) {
+            g_assert_cmpuint(rec[i].nsec, >= ,rec[i - 1].nsec);
+        }
+    }
+    g_free(rec);
+
+    /* Nothing gets recorded after tracing is stopped */
+    gbinder_trace_stop();
+    g_assert(!gbinder_trace_size);
+    GBINDER_TRACE(GBINDER_TRACE_TX_QUEUED, 0, 0, 0);
+    gbinder_trace_add(GBINDER_TRACE_TX_QUEUED, 0, 0, 0);
+    rec = test_dump(&n);
+    g_assert_cmpuint(n, == ,3);
+    g_assert_cmpuint(rec[2].arg1, == ,5);
+    g_free(rec);
+}
+
+/*==========================================================================*
+ * threads
+ *==========================================================================*/
+
+static
+gpointer
+test_threads_proc(
+    gpointer data)
+{
+    GBINDER_TRACE(GBINDER_TRACE_HANDLER_START, GPOINTER_TO_UINT(data), 0, 0);
+    GBINDER_TRACE(GBINDER_TRACE_HANDLER_END, GPOINTER_TO_UINT(data), 0, 0);
+    return NULL;
+}
+
+static
+void
+test_threads(
+    void)
+{
+    GBinderTraceRecord* rec;
+    guint32 tid[2];
+    guint i, n, handler_events = 0, reply_events = 0;
+
+    /* Each thread gets its own buffer, the second one reuses it */
+    gbinder_trace_start(16);
+    for (i = 0; i < G_N_ELEMENTS(tid); i++) {
+        g_thread_join(g_thread_new("trace", test_threads_proc,
+            GUINT_TO_POINTER(i + 1)));
+    }
+    GBINDER_TRACE(GBINDER_TRACE_REPLY_SENT, 0, 0, 0);
+
+    /* The main thread's buffer still has records from the basic test */
+    rec = test_dump(&n);
+    memset(tid, 0, sizeof(tid));
+    for (i = 0; i < n; i++) {
+        if (rec[i].event == GBINDER_TRACE_HANDLER_START ||
+            rec[i].event == GBINDER_TRACE_HANDLER_END) {
+            const guint k = rec[i].arg1 - 1;
+
+            g_assert_cmpuint(k, < ,G_N_ELEMENTS(tid));
+            if (tid[k]) {
+                g_assert_cmpuint(tid[k], == ,rec[i].tid);
+            } else {
+                tid[k] = rec[i].tid;
+            }
+            handler_events++;
+        } else if (rec[i].event == GBINDER_TRACE_REPLY_SENT) {
+            g_assert_cmpuint(rec[i].tid, == ,syscall(SYS_gettid));
+            reply_events++;
+        }
+    }
+    g_assert_cmpuint(handler_events, == ,4);
+    g_assert_cmpuint(reply_events, == ,1);
+    g_assert(tid[0]);
+    g_assert(tid[1]);
+    g_assert_cmpuint(tid[0], != ,tid[1]);
+    g_free(rec);
+    gbinder_trace_stop();
+}
+
+/*==========================================================================*
+ * config_file
+ *==========================================================================*/
+
+static
+void
+test_config_file(
+    void)
+{
+    GBinderIpc* ipc;
+    TestConfig test;
+    char* file;
+    static const char config[] =
+        "[General]\n"
+        "TraceBufferSize = 5\n";
+
+    test_config_init(&test, TMP_DIR_TEMPLATE);
+    file = g_build_filename(test.config_dir, "test.conf", NULL);
+    g_assert(g_file_set_contents(file, config, -1, NULL));
+    GDEBUG("Config file %s", file);
+    gbinder_config_file = file;
+
+    /* Tracing gets started when GBinderIpc is created */
+    gbinder_trace_stop();
+    ipc = gbinder_ipc_new(GBINDER_DEFAULT_BINDER, NULL);
+    g_assert(ipc);
+    g_assert_cmpuint(gbinder_trace_size, == ,8);
+    gbinder_ipc_unref(ipc);
+    gbinder_trace_stop();
+
+    test_binder_exit_wait(&test_opt, NULL);
+    remove(file);
+    g_free(file);
+    test_config_cleanup(&test);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(t) "/trace/" t
+
+int main(int argc, char* argv[])
+{
+    TestConfig test_config;
+    int result;
+
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+    g_type_init();
+    G_GNUC_END_IGNORE_DEPRECATIONS;
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("threads"), test_threads);
+    g_test_add_func(TEST_("config_file"), test_config_file);
+    test_init(&test_opt, argc, argv);
+    test_config_init(&test_config, TMP_DIR_TEMPLATE);
+    result = g_test_run();
+    test_config_cleanup(&test_config);
+    return result;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
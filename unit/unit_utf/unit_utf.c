@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 Jolla Mobile Ltd
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test_common.h"
+
+#include "gbinder_utf.h"
+
+static TestOpt test_opt;
+
+static const char* test_strings[] = {
+    "",
+    "a",
+    "android.hidl.base@1.0::IBase",
+    "android.hardware.radio@1.4::IRadio/slot1",
+    "0123456789abcdef0123456789abcdef0123456789abcdef",
+    "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", /* Привет */
+    "0123456789abcdef\xc3\xa4",
+    "0123456789abcdef0123456789abcde\xc3\xa4xyz",
+    "\xf0\x9f\x98\x80 0123456789abcdef0123456789abcdef" /* Surrogates */
+};
+
+/*==========================================================================*
+ * ascii_len
+ *==========================================================================*/
+
+static
+void
+test_ascii_len(
+    void)
+{
+    char buf[80];
+    gsize len, i;
+
+    g_assert_cmpuint(gbinder_utf8_ascii_len(NULL, 0), == ,0);
+
+    /* Non-ASCII byte at every position */
+    for (len = 1; len < sizeof(buf); len++) {
+        for (i = 0; i < len; i++) {
+            memset(buf, 'x', len);
+            g_assert_cmpuint(gbinder_utf8_ascii_len(buf, len), == ,len);
+            buf[i] = (char)0x80;
+            g_assert_cmpuint(gbinder_utf8_ascii_len(buf, len), == ,i);
+        }
+    }
+}
+
+/*==========================================================================*
+ * to_utf16
+ *==========================================================================*/
+
+static
+void
+test_to_utf16(
+    void)
+{
+    char buf[80];
+    gunichar2 out[G_N_ELEMENTS(buf)];
+    gsize len, i;
+
+    for (len = 0; len < sizeof(buf); len++) {
+        for (i = 0; i < len; i++) {
+            buf[i] = (char)(0x20 + (i % 0x5f));
+        }
+        memset(out, 0xff, sizeof(out));
+        gbinder_utf8_ascii_to_utf16(out, buf, len);
+        for (i = 0; i < len; i++) {
+            g_assert_cmpuint(out[i], == ,(guint8)buf[i]);
+        }
+        if (len < G_N_ELEMENTS(out)) {
+            /* Didn't write past the end */
+            g_assert_cmpuint(out[len], == ,0xffff);
+        }
+    }
+}
+
+/*==========================================================================*
+ * to_utf8
+ *==========================================================================*/
+
+static
+void
+test_to_utf8(
+    void)
+{
+    gunichar2 buf[80];
+    char out[G_N_ELEMENTS(buf)];
+    gsize len, i;
+
+    /* Non-ASCII unit at every position */
+    for (len = 1; len < G_N_ELEMENTS(buf); len++) {
+        for (i = 0; i < len; i++) {
+            gsize k;
+
+            for (k = 0; k < len; k++) {
+                buf[k] = 0x20 + (k % 0x5f);
+            }
+            g_assert_cmpuint(gbinder_utf16_ascii_to_utf8(out, buf, len),
+                == ,len);
+            for (k = 0; k < len; k++) {
+                g_assert_cmpint(out[k], == ,buf[k]);
+            }
+            buf[i] = (i & 1) ? 0x80 : 0x100;
+            g_assert_cmpuint(gbinder_utf16_ascii_to_utf8(out, buf, len),
+                == ,i);
+        }
+    }
+}
+
+/*==========================================================================*
+ * roundtrip
+ *==========================================================================*/
+
+static
+void
+test_roundtrip(
+    void)
+{
+    static const gunichar2 bad[] = { 'a', 0xd800, 'b' };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(test_strings); i++) {
+        const char* str = test_strings[i];
+        glong len = 0;
+        gunichar2* utf16 = g_utf8_to_utf16(str, -1, NULL, &len, NULL);
+        char* utf8 = gbinder_utf16_to_utf8(utf16, len);
+
+        g_assert_cmpstr(utf8, == ,str);
+        g_free(utf8);
+        g_free(utf16);
+    }
+
+    /* Invalid UTF-16 (unpaired surrogate) */
+    g_assert(!gbinder_utf16_to_utf8(bad, G_N_ELEMENTS(bad)));
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/utf/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("ascii_len"), test_ascii_len);
+    g_test_add_func(TEST_("to_utf16"), test_to_utf16);
+    g_test_add_func(TEST_("to_utf8"), test_to_utf8);
+    g_test_add_func(TEST_("roundtrip"), test_roundtrip);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
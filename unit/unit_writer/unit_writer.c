@@ -197,6 +197,8 @@ test_null(
     gbinder_writer_add_cleanup(NULL, NULL, 0);
     gbinder_writer_add_cleanup(NULL, g_free, 0);
     gbinder_writer_overwrite_int32(NULL, 0, 0);
+    g_assert(!gbinder_writer_reserve(NULL, 4));
+    gbinder_writer_size_hint(NULL, 4);
 
 #if GBINDER_FMQ_SUPPORTED
     gbinder_writer_append_fmq_descriptor(NULL, NULL);
@@ -1576,6 +1578,59 @@ test_bytes_written(
     gbinder_local_request_unref(req);
 }
 
+/*==========================================================================*
+ * reserve
+ *==========================================================================*/
+
+static
+void
+test_reserve(
+    void)
+{
+    static const guint8 expected[] = {
+        0x01, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x00, 0x00,
+        0x03, 0x00, 0x00, 0x00,
+        0xaa, 0xbb, 0xcc, 0x00,
+        0x04, 0x00, 0x00, 0x00
+    };
+    GBinderLocalRequest* req = test_local_request_new();
+    GBinderOutputData* data;
+    GBinderWriter writer;
+    guint32* ints;
+    guint8* bytes;
+    const guint8* buf;
+
+    gbinder_local_request_init_writer(req, &writer);
+    g_assert(!gbinder_writer_reserve(&writer, 0));
+    gbinder_writer_size_hint(&writer, 0);
+    gbinder_writer_size_hint(&writer, sizeof(expected));
+    data = gbinder_local_request_data(req);
+    buf = data->bytes->data;
+
+    /* The buffer doesn't move after the size hint */
+    ints = gbinder_writer_reserve(&writer, 3 * sizeof(guint32));
+    g_assert(ints);
+    ints[0] = 1;
+    ints[1] = 2;
+    ints[2] = 3;
+    bytes = gbinder_writer_reserve(&writer, 3);
+    g_assert(bytes);
+    bytes[0] = 0xaa;
+    bytes[1] = 0xbb;
+    bytes[2] = 0xcc;
+    gbinder_writer_append_int32(&writer, 4);
+    g_assert(data->bytes->data == buf);
+
+    g_assert_cmpuint(data->bytes->len, == ,sizeof(expected));
+    g_assert(!memcmp(data->bytes->data, expected, sizeof(expected)));
+    g_assert(!gbinder_writer_reserve(&writer, G_MAXSIZE));
+    g_assert(!gbinder_writer_reserve(&writer, G_MAXUINT));
+    gbinder_writer_size_hint(&writer, G_MAXUINT);
+    g_assert_cmpuint(data->bytes->len, == ,sizeof(expected));
+    gbinder_local_request_unref(req);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -1664,6 +1719,7 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("remote_object"), test_remote_object);
     g_test_add_func(TEST_("byte_array"), test_byte_array);
     g_test_add_func(TEST_("bytes_written"), test_bytes_written);
+    g_test_add_func(TEST_("reserve"), test_reserve);
 
 #if GBINDER_FMQ_SUPPORTED
     {